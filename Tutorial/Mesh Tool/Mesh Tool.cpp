@@ -0,0 +1,851 @@
+//This file is licensed under the MIT License.
+
+
+//Command-line work on mesh files, away from any window or GL context.
+//
+//	clusters <mesh.xml>
+//		Splits the mesh into clusters, reports their sizes and bounds, and how many of them
+//		culling keeps from cameras around the mesh and inside it.
+//	convert [-c] [-l] [-q] <mesh.xml> [<out.mesh>]
+//		Writes the packed binary copy that Framework::PackedMesh would cache, with the same
+//		reordering as optimize, and times loading the mesh from the xml, from a read of the
+//		copy, and from a mapping of it. -c builds clusters, -l levels of detail and -q
+//		quantizes the attributes, as the PACKED_MESH_CLUSTERS, PACKED_MESH_LODS and
+//		PACKED_MESH_QUANTIZE options do; -q reports the size saved and the error added.
+//	info <mesh.xml or mesh.mesh>
+//		Lists the mesh's attributes, primitives and VAOs, and how well its triangles use the
+//		post-transform vertex cache.
+//	lod <mesh.xml>
+//		Builds the levels of detail and reports each one's triangles, its error estimate, and
+//		the largest distance measured from a vertex of the full mesh to the level's surface.
+//	optimize <mesh.xml> [<out.xml>]
+//		Reorders the mesh's triangles for the vertex cache and its vertices for fetch, the
+//		same as convert does, and rewrites the .xml (in place, without <out.xml>).
+//	parse <mesh.xml> [<passes>]
+//		Times converting the text of the mesh's float <attribute> bodies with a string
+//		stream, with strtod, and with Framework::ParseFloat, and counts the values where
+//		they disagree.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <utility>
+#include <stdexcept>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../framework/FloatParse.h"
+#include "../framework/MappedFile.h"
+#include "../framework/MeshCluster.h"
+#include "../framework/MeshData.h"
+#include "../framework/MeshOptimize.h"
+#include "../framework/MeshQuantize.h"
+#include "../framework/MeshSimplify.h"
+#include "../framework/PackedMeshFormat.h"
+
+namespace
+{
+	double SecondsSince(clock_t start)
+	{
+		return (clock() - start) / (double)CLOCKS_PER_SEC;
+	}
+
+	bool EndsWith(const std::string &str, const char *strSuffix)
+	{
+		const size_t length = strlen(strSuffix);
+		return str.size() >= length && str.compare(str.size() - length, length, strSuffix) == 0;
+	}
+
+	void LoadAnyMesh(const std::string &strFilename, Framework::MeshData &mesh)
+	{
+		if(EndsWith(strFilename, ".mesh"))
+		{
+			if(!Framework::LoadPackedMeshFile(strFilename, mesh))
+				throw std::runtime_error(strFilename + " is not a packed mesh of this version.");
+		}
+		else
+		{
+			Framework::LoadMeshXml(strFilename, mesh);
+		}
+	}
+
+	size_t CountPayload(const Framework::MeshData &mesh)
+	{
+		size_t bytes = 0;
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+			bytes += mesh.attribs[attrib].data.size();
+
+		return bytes;
+	}
+
+	void PrintQuantizeReport(const Framework::MeshData &mesh,
+		const std::vector<Framework::QuantizeReport> &report)
+	{
+		size_t newVertexSize = 0;
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+			newVertexSize += mesh.attribs[attrib].GetVertexSize();
+
+		size_t oldVertexSize = newVertexSize;
+
+		for(size_t entry = 0; entry < report.size(); entry++)
+		{
+			const Framework::QuantizeReport &curr = report[entry];
+			printf("  attribute %u: %s, %lu -> %lu bytes, max error %g%s%s\n", curr.index,
+				curr.strEncoding, (unsigned long)curr.oldVertexSize,
+				(unsigned long)curr.newVertexSize, curr.maxError,
+				curr.strErrorUnits[0] ? " " : "", curr.strErrorUnits);
+			oldVertexSize = oldVertexSize - curr.newVertexSize + curr.oldVertexSize;
+		}
+
+		printf("  vertex: %lu -> %lu bytes (%.0f%% smaller)\n", (unsigned long)oldVertexSize,
+			(unsigned long)newVertexSize, 100.0 * (1.0 - newVertexSize / (double)oldVertexSize));
+	}
+
+	void Convert(const std::vector<std::string> &args)
+	{
+		bool bClusters = false;
+		bool bLods = false;
+		bool bQuantize = false;
+		size_t firstArg = 0;
+		for(; firstArg < args.size() && args[firstArg][0] == '-'; firstArg++)
+		{
+			if(args[firstArg] == "-c")
+				bClusters = true;
+			else if(args[firstArg] == "-l")
+				bLods = true;
+			else if(args[firstArg] == "-q")
+				bQuantize = true;
+			else
+				firstArg = args.size();
+		}
+
+		if(args.size() <= firstArg || args.size() > firstArg + 2)
+			throw std::runtime_error("Usage: convert [-c] [-l] [-q] <mesh.xml> [<out.mesh>]");
+
+		const std::string &strInput = args[firstArg];
+		const std::string strOutput = args.size() > firstArg + 1 ? args[firstArg + 1] :
+			Framework::GetPackedMeshFilename(strInput);
+
+		Framework::MeshData mesh;
+		clock_t start = clock();
+		Framework::LoadMeshXml(strInput, mesh);
+		const double xmlSeconds = SecondsSince(start);
+
+		if(bLods)
+			Framework::BuildLods(mesh);
+		if(bClusters)
+			Framework::BuildClusters(mesh);
+		Framework::OptimizeVertexCache(mesh);
+		Framework::OptimizeVertexFetch(mesh);
+		std::vector<Framework::QuantizeReport> report;
+		if(bQuantize)
+			Framework::QuantizeMesh(mesh, report);
+		Framework::SavePackedMeshFile(strOutput, mesh);
+
+		start = clock();
+		std::vector<char> image;
+		if(!Framework::ReadPackedMeshImage(strOutput, image))
+			throw std::runtime_error("Could not read back " + strOutput + ".");
+		const double readSeconds = SecondsSince(start);
+
+		//Touch every page, the way glBufferData would, so the mapping is not timed empty.
+		start = clock();
+		Framework::MappedFile packedFile(strOutput);
+		if(!packedFile.IsOpen() ||
+			!Framework::GetPackedMeshHeader(packedFile.GetData(), packedFile.GetSize()))
+		{
+			throw std::runtime_error("Could not map " + strOutput + ".");
+		}
+		volatile unsigned int pageSum = 0;
+		for(size_t page = 0; page < packedFile.GetSize(); page += 4096)
+			pageSum += (unsigned char)packedFile.GetData()[page];
+		const double mappedSeconds = SecondsSince(start);
+
+		printf("%s -> %s (%lu bytes)\n", strInput.c_str(), strOutput.c_str(),
+			(unsigned long)image.size());
+		printf("load: xml %.2f ms, packed read %.2f ms, packed mapped %.2f ms\n",
+			xmlSeconds * 1000.0, readSeconds * 1000.0, mappedSeconds * 1000.0);
+		if(bQuantize)
+			PrintQuantizeReport(mesh, report);
+	}
+
+	void PrintCacheStats(const char *strLabel, const Framework::MeshData &mesh)
+	{
+		const Framework::VertexCacheStats stats = Framework::SimulateVertexCache(mesh);
+		printf("  %s: %lu triangles, ACMR %.3f, ATVR %.3f (FIFO of %d)\n", strLabel,
+			(unsigned long)stats.numTriangles, stats.GetAcmr(), stats.GetAtvr(),
+			(int)Framework::DEFAULT_VERTEX_CACHE_SIZE);
+	}
+
+	void Optimize(const std::vector<std::string> &args)
+	{
+		if(args.empty() || args.size() > 2)
+			throw std::runtime_error("Usage: optimize <mesh.xml> [<out.xml>]");
+
+		const std::string &strInput = args[0];
+		const std::string &strOutput = args.size() > 1 ? args[1] : args[0];
+
+		Framework::MeshData mesh;
+		Framework::LoadMeshXml(strInput, mesh);
+
+		printf("%s -> %s\n", strInput.c_str(), strOutput.c_str());
+		PrintCacheStats("before", mesh);
+		Framework::OptimizeVertexCache(mesh);
+		if(!Framework::OptimizeVertexFetch(mesh))
+			printf("  vertex order kept: the mesh draws <arrays> or restarts on a vertex index\n");
+		PrintCacheStats("after", mesh);
+
+		Framework::SaveMeshXml(strOutput, mesh);
+	}
+
+	const char *GetTypeName(GLenum type)
+	{
+		switch(type)
+		{
+		case GL_FLOAT: return "float";
+		case GL_HALF_FLOAT: return "half";
+		case GL_INT: return "int";
+		case GL_UNSIGNED_INT: return "uint";
+		case GL_SHORT: return "short";
+		case GL_UNSIGNED_SHORT: return "ushort";
+		case GL_BYTE: return "byte";
+		case GL_UNSIGNED_BYTE: return "ubyte";
+		case GL_INT_2_10_10_10_REV: return "int-2-10-10-10";
+		case GL_UNSIGNED_INT_2_10_10_10_REV: return "uint-2-10-10-10";
+		case GL_TRIANGLES: return "triangles";
+		case GL_TRIANGLE_STRIP: return "tri-strip";
+		case GL_TRIANGLE_FAN: return "tri-fan";
+		case GL_LINES: return "lines";
+		case GL_LINE_STRIP: return "line-strip";
+		case GL_LINE_LOOP: return "line-loop";
+		case GL_POINTS: return "points";
+		default: return "?";
+		}
+	}
+
+	void Info(const std::vector<std::string> &args)
+	{
+		if(args.size() != 1)
+			throw std::runtime_error("Usage: info <mesh.xml or mesh.mesh>");
+
+		Framework::MeshData mesh;
+		LoadAnyMesh(args[0], mesh);
+
+		printf("%s: %lu vertices, %lu bytes of attributes\n", args[0].c_str(),
+			(unsigned long)mesh.attribs[0].GetNumVertices(), (unsigned long)CountPayload(mesh));
+		if(mesh.bQuantized)
+		{
+			printf("  quantized: position scale (%g, %g, %g), offset (%g, %g, %g)\n",
+				mesh.positionScale[0], mesh.positionScale[1], mesh.positionScale[2],
+				mesh.positionOffset[0], mesh.positionOffset[1], mesh.positionOffset[2]);
+		}
+
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+		{
+			const Framework::MeshAttribute &curr = mesh.attribs[attrib];
+			printf("  attribute %u: %s%s x%d%s\n", curr.index, curr.bNormalized ? "norm-" : "",
+				GetTypeName(curr.type), curr.numComponents, curr.bIntegral ? " integral" : "");
+		}
+
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const Framework::MeshPrimitive &curr = mesh.primitives[prim];
+			if(curr.indexType)
+			{
+				printf("  indices: %s, %u %s\n", GetTypeName(curr.primType), curr.count,
+					GetTypeName(curr.indexType));
+			}
+			else
+			{
+				printf("  arrays: %s, %u from %u\n", GetTypeName(curr.primType), curr.count, curr.start);
+			}
+		}
+
+		for(size_t vao = 0; vao < mesh.vaos.size(); vao++)
+		{
+			printf("  vao \"%s\":", mesh.vaos[vao].name.c_str());
+			for(size_t source = 0; source < mesh.vaos[vao].attribs.size(); source++)
+				printf(" %u", mesh.vaos[vao].attribs[source]);
+			printf("\n");
+		}
+
+		PrintCacheStats("vertex cache", mesh);
+
+		if(mesh.bLodsBuilt)
+		{
+			printf("  bounds: center (%g, %g, %g), radius %g\n", mesh.boundsCenter[0],
+				mesh.boundsCenter[1], mesh.boundsCenter[2], mesh.boundsRadius);
+		}
+
+		for(size_t lod = 0; lod < mesh.lods.size(); lod++)
+		{
+			printf("  lod %lu: %lu triangles, error %g\n", (unsigned long)(lod + 1),
+				(unsigned long)(mesh.lods[lod].indices.size() / 3), mesh.lods[lod].error);
+		}
+
+		if(!mesh.clusters.empty())
+			printf("  clusters: %lu\n", (unsigned long)mesh.clusters.size());
+	}
+
+	typedef double Vec3[3];
+
+	void GetPosition(const std::vector<float> &positions, GLuint vertex, Vec3 &position)
+	{
+		for(int component = 0; component < 3; component++)
+			position[component] = positions[vertex * 3 + component];
+	}
+
+	double Dot(const Vec3 &lhs, const Vec3 &rhs)
+	{
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+	}
+
+	//The squared distance from p to the triangle abc, by the region of the triangle the
+	//closest point lies in (Ericson, Real-Time Collision Detection, 5.1.5).
+	double TriangleDistanceSqr(const Vec3 &p, const Vec3 &a, const Vec3 &b, const Vec3 &c)
+	{
+		Vec3 ab, ac, ap, closest;
+		for(int component = 0; component < 3; component++)
+		{
+			ab[component] = b[component] - a[component];
+			ac[component] = c[component] - a[component];
+			ap[component] = p[component] - a[component];
+		}
+
+		const double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		//v and w weigh b and c; both stay 0 if a is the closest point.
+		double v = 0.0, w = 0.0;
+		if(d1 > 0.0 || d2 > 0.0)
+		{
+			Vec3 bp, cp;
+			for(int component = 0; component < 3; component++)
+			{
+				bp[component] = p[component] - b[component];
+				cp[component] = p[component] - c[component];
+			}
+
+			const double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+			const double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+			const double vc = d1 * d4 - d3 * d2;
+			const double vb = d5 * d2 - d1 * d6;
+			const double va = d3 * d6 - d5 * d4;
+			if(d3 >= 0.0 && d4 <= d3)
+				v = 1.0;
+			else if(d6 >= 0.0 && d5 <= d6)
+				w = 1.0;
+			else if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+				v = d1 / (d1 - d3);
+			else if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+				w = d2 / (d2 - d6);
+			else if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+			{
+				w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+				v = 1.0 - w;
+			}
+			else
+			{
+				const double denom = 1.0 / (va + vb + vc);
+				v = vb * denom;
+				w = vc * denom;
+			}
+		}
+
+		double distanceSqr = 0.0;
+		for(int component = 0; component < 3; component++)
+		{
+			closest[component] = a[component] + ab[component] * v + ac[component] * w;
+			const double offset = p[component] - closest[component];
+			distanceSqr += offset * offset;
+		}
+
+		return distanceSqr;
+	}
+
+	//The largest distance from a vertex the full triangles use to the level's triangles.
+	//Triangles whose bounding box is already further than the best so far are skipped.
+	double MeasureLodDistance(const std::vector<float> &positions,
+		const std::vector<GLuint> &fullTriangles, const std::vector<GLuint> &lodTriangles)
+	{
+		const size_t numLodTriangles = lodTriangles.size() / 3;
+		std::vector<double> boxes(numLodTriangles * 6);
+		for(size_t triangle = 0; triangle < numLodTriangles; triangle++)
+		{
+			double *pBox = &boxes[triangle * 6];
+			for(int component = 0; component < 3; component++)
+			{
+				pBox[component] = pBox[component + 3] =
+					positions[lodTriangles[triangle * 3] * 3 + component];
+				for(int corner = 1; corner < 3; corner++)
+				{
+					const double value = positions[lodTriangles[triangle * 3 + corner] * 3 + component];
+					pBox[component] = std::min(pBox[component], value);
+					pBox[component + 3] = std::max(pBox[component + 3], value);
+				}
+			}
+		}
+
+		std::vector<bool> measured(positions.size() / 3, false);
+		double maxDistanceSqr = 0.0;
+		for(size_t ix = 0; ix < fullTriangles.size(); ix++)
+		{
+			const GLuint vertex = fullTriangles[ix];
+			if(measured[vertex])
+				continue;
+			measured[vertex] = true;
+
+			Vec3 p;
+			GetPosition(positions, vertex, p);
+			double bestSqr = -1.0;
+			for(size_t triangle = 0; triangle < numLodTriangles && bestSqr != 0.0; triangle++)
+			{
+				const double *pBox = &boxes[triangle * 6];
+				double boxSqr = 0.0;
+				for(int component = 0; component < 3; component++)
+				{
+					const double outside = std::max(pBox[component] - p[component],
+						std::max(0.0, p[component] - pBox[component + 3]));
+					boxSqr += outside * outside;
+				}
+				if(bestSqr >= 0.0 && boxSqr >= bestSqr)
+					continue;
+
+				Vec3 a, b, c;
+				GetPosition(positions, lodTriangles[triangle * 3], a);
+				GetPosition(positions, lodTriangles[triangle * 3 + 1], b);
+				GetPosition(positions, lodTriangles[triangle * 3 + 2], c);
+				const double distanceSqr = TriangleDistanceSqr(p, a, b, c);
+				if(bestSqr < 0.0 || distanceSqr < bestSqr)
+					bestSqr = distanceSqr;
+			}
+
+			maxDistanceSqr = std::max(maxDistanceSqr, bestSqr);
+		}
+
+		return sqrt(maxDistanceSqr);
+	}
+
+	void Lod(const std::vector<std::string> &args)
+	{
+		if(args.size() != 1)
+			throw std::runtime_error("Usage: lod <mesh.xml>");
+
+		Framework::MeshData mesh;
+		Framework::LoadMeshXml(args[0], mesh);
+
+		clock_t start = clock();
+		const int numLods = Framework::BuildLods(mesh);
+		const double buildSeconds = SecondsSince(start);
+
+		std::vector<GLuint> fullTriangles;
+		Framework::GetTriangles(mesh, fullTriangles);
+		printf("%s: %d levels of detail in %.2f ms, bounding radius %g\n", args[0].c_str(),
+			numLods, buildSeconds * 1000.0, mesh.boundsRadius);
+		printf("  lod 0: %lu triangles\n", (unsigned long)(fullTriangles.size() / 3));
+		if(!numLods)
+			return;
+
+		std::vector<float> positions;
+		Framework::GetPositions(mesh, positions);
+
+		for(int lod = 0; lod < numLods; lod++)
+		{
+			const Framework::MeshLod &curr = mesh.lods[lod];
+			const size_t numTriangles = curr.indices.size() / 3;
+			const double distance = MeasureLodDistance(positions, fullTriangles, curr.indices);
+			printf("  lod %d: %lu triangles (%.1f%%), error %g, measured %g (%.3f%% of the radius)\n",
+				lod + 1, (unsigned long)numTriangles,
+				100.0 * numTriangles / (double)(fullTriangles.size() / 3), curr.error, distance,
+				mesh.boundsRadius > 0.0f ? 100.0 * distance / mesh.boundsRadius : 0.0);
+		}
+	}
+
+	//A square 60 degree view from eye along forward, reaching out to farDistance.
+	Framework::ClusterView MakeView(const Vec3 &eye, const Vec3 &forward, double farDistance)
+	{
+		//Any two axes square to forward and to each other will do.
+		Vec3 side = {0.0, 0.0, 0.0};
+		side[fabs(forward[0]) < 0.5 ? 0 : 1] = 1.0;
+		Vec3 right, up;
+		right[0] = forward[1] * side[2] - forward[2] * side[1];
+		right[1] = forward[2] * side[0] - forward[0] * side[2];
+		right[2] = forward[0] * side[1] - forward[1] * side[0];
+		const double rightLength = sqrt(Dot(right, right));
+		for(int component = 0; component < 3; component++)
+			right[component] /= rightLength;
+		up[0] = right[1] * forward[2] - right[2] * forward[1];
+		up[1] = right[2] * forward[0] - right[0] * forward[2];
+		up[2] = right[0] * forward[1] - right[1] * forward[0];
+
+		const double halfAngle = 30.0 * 3.14159265358979 / 180.0;
+		const double edgeCos = cos(halfAngle), edgeSin = sin(halfAngle);
+
+		Vec3 normals[6];
+		for(int component = 0; component < 3; component++)
+		{
+			normals[0][component] = edgeCos * right[component] + edgeSin * forward[component];
+			normals[1][component] = -edgeCos * right[component] + edgeSin * forward[component];
+			normals[2][component] = edgeCos * up[component] + edgeSin * forward[component];
+			normals[3][component] = -edgeCos * up[component] + edgeSin * forward[component];
+			normals[4][component] = forward[component];
+			normals[5][component] = -forward[component];
+		}
+
+		Framework::ClusterView view;
+		for(int plane = 0; plane < 6; plane++)
+		{
+			for(int component = 0; component < 3; component++)
+				view.planes[plane][component] = (float)normals[plane][component];
+			view.planes[plane][3] = (float)-Dot(normals[plane], eye);
+		}
+		view.planes[4][3] -= (float)(farDistance * 0.001);
+		view.planes[5][3] += (float)farDistance;
+
+		for(int component = 0; component < 3; component++)
+			view.cameraPos[component] = (float)eye[component];
+		view.bFrontFaceCw = false;
+		return view;
+	}
+
+	struct CullStats
+	{
+		size_t numViews;
+		size_t numClusters;
+		size_t numTriangles;
+		size_t numFrustumCulled;
+		size_t numConeCulled;
+		size_t numRuns;
+	};
+
+	void CullFromView(const Framework::MeshData &mesh, const Framework::ClusterView &view,
+		CullStats &stats)
+	{
+		bool bPrevVisible = false;
+		for(size_t cluster = 0; cluster < mesh.clusters.size(); cluster++)
+		{
+			Framework::MeshCluster sphereOnly = mesh.clusters[cluster];
+			sphereOnly.coneCos = -1.0f;
+
+			const bool bVisible = Framework::IsClusterVisible(mesh.clusters[cluster], view);
+			if(bVisible)
+			{
+				stats.numClusters++;
+				stats.numTriangles += mesh.clusters[cluster].numIndices / 3;
+				if(!bPrevVisible)
+					stats.numRuns++;
+			}
+			else if(!Framework::IsClusterVisible(sphereOnly, view))
+				stats.numFrustumCulled++;
+			else
+				stats.numConeCulled++;
+
+			bPrevVisible = bVisible;
+		}
+		stats.numViews++;
+	}
+
+	void PrintCullStats(const char *strLabel, const Framework::MeshData &mesh,
+		const CullStats &stats, size_t numTriangles)
+	{
+		const double views = (double)stats.numViews;
+		printf("  %s: %.1f%% of clusters and %.1f%% of triangles drawn, in %.1f draws;"
+			" %.1f%% culled by frustum, %.1f%% by cone\n", strLabel,
+			100.0 * stats.numClusters / (views * mesh.clusters.size()),
+			100.0 * stats.numTriangles / (views * numTriangles), stats.numRuns / views,
+			100.0 * stats.numFrustumCulled / (views * mesh.clusters.size()),
+			100.0 * stats.numConeCulled / (views * mesh.clusters.size()));
+	}
+
+	void Clusters(const std::vector<std::string> &args)
+	{
+		if(args.size() != 1)
+			throw std::runtime_error("Usage: clusters <mesh.xml>");
+
+		Framework::MeshData mesh;
+		Framework::LoadMeshXml(args[0], mesh);
+
+		clock_t start = clock();
+		const int numClusters = Framework::BuildClusters(mesh);
+		const double buildSeconds = SecondsSince(start);
+
+		printf("%s: %d clusters in %.2f ms\n", args[0].c_str(), numClusters,
+			buildSeconds * 1000.0);
+		if(!numClusters)
+			return;
+
+		//The box around the clusters' spheres, and a sphere around that.
+		Vec3 minValue, maxValue, center;
+		for(int component = 0; component < 3; component++)
+		{
+			minValue[component] = mesh.clusters[0].center[component] - mesh.clusters[0].radius;
+			maxValue[component] = mesh.clusters[0].center[component] + mesh.clusters[0].radius;
+			for(int cluster = 1; cluster < numClusters; cluster++)
+			{
+				const Framework::MeshCluster &curr = mesh.clusters[cluster];
+				minValue[component] = std::min(minValue[component], (double)(curr.center[component] - curr.radius));
+				maxValue[component] = std::max(maxValue[component], (double)(curr.center[component] + curr.radius));
+			}
+			center[component] = (minValue[component] + maxValue[component]) * 0.5;
+		}
+
+		double meshRadius = 0.0;
+		for(int cluster = 0; cluster < numClusters; cluster++)
+		{
+			Vec3 offset;
+			for(int component = 0; component < 3; component++)
+				offset[component] = mesh.clusters[cluster].center[component] - center[component];
+			meshRadius = std::max(meshRadius, sqrt(Dot(offset, offset)) + mesh.clusters[cluster].radius);
+		}
+
+		size_t minTriangles = mesh.primitives[0].indices.size(), maxTriangles = 0;
+		size_t numCones = 0;
+		double radiusSum = 0.0, coneAngleSum = 0.0;
+		for(int cluster = 0; cluster < numClusters; cluster++)
+		{
+			const Framework::MeshCluster &curr = mesh.clusters[cluster];
+			minTriangles = std::min(minTriangles, (size_t)curr.numIndices / 3);
+			maxTriangles = std::max(maxTriangles, (size_t)curr.numIndices / 3);
+			radiusSum += curr.radius;
+			if(curr.coneCos > 0.0f)
+			{
+				numCones++;
+				coneAngleSum += acos(std::min(1.0, (double)curr.coneCos)) * 180.0 / 3.14159265358979;
+			}
+		}
+
+		const size_t numTriangles = mesh.primitives[0].indices.size() / 3;
+		printf("  triangles per cluster: %lu to %lu, %.1f on average\n",
+			(unsigned long)minTriangles, (unsigned long)maxTriangles,
+			numTriangles / (double)numClusters);
+		printf("  bounds: radius %.3g on average (mesh %.3g); %lu cones, %.1f degrees wide on"
+			" average\n", radiusSum / numClusters, meshRadius, (unsigned long)numCones,
+			numCones ? coneAngleSum / numCones : 0.0);
+
+		//Cameras on each side of the mesh looking in, and at its center looking out.
+		CullStats outside, inside;
+		memset(&outside, 0, sizeof(outside));
+		memset(&inside, 0, sizeof(inside));
+		for(int axis = 0; axis < 3; axis++)
+		{
+			for(int sign = -1; sign <= 1; sign += 2)
+			{
+				Vec3 forward = {0.0, 0.0, 0.0};
+				forward[axis] = sign;
+
+				Vec3 eye;
+				for(int component = 0; component < 3; component++)
+					eye[component] = center[component] - forward[component] * 2.0 * meshRadius;
+				CullFromView(mesh, MakeView(eye, forward, 4.0 * meshRadius), outside);
+
+				CullFromView(mesh, MakeView(center, forward, 4.0 * meshRadius), inside);
+			}
+		}
+
+		PrintCullStats("from outside", mesh, outside, numTriangles);
+		PrintCullStats("from the center", mesh, inside, numTriangles);
+	}
+
+	//The text of every float and half <attribute> body in the file.
+	void FindFloatBodies(const std::vector<char> &text,
+		std::vector<std::pair<const char *, const char *> > &bodies)
+	{
+		const char *pCurr = &text[0];
+		while((pCurr = strstr(pCurr, "<attribute")) != NULL)
+		{
+			const char *pTagEnd = strchr(pCurr, '>');
+			if(!pTagEnd)
+				return;
+
+			const std::string strTag(pCurr, pTagEnd);
+			pCurr = pTagEnd + 1;
+			if(strTag.find("type=\"float\"") == std::string::npos &&
+				strTag.find("type=\"half\"") == std::string::npos)
+			{
+				continue;
+			}
+
+			const char *pBodyEnd = strchr(pCurr, '<');
+			if(!pBodyEnd)
+				return;
+
+			bodies.push_back(std::make_pair(pCurr, pBodyEnd));
+			pCurr = pBodyEnd;
+		}
+	}
+
+	//Each body in a string stream of its own, as the stream-based loaders read them.
+	void ParseWithStream(const std::vector<std::pair<const char *, const char *> > &bodies,
+		std::vector<float> &values)
+	{
+		values.clear();
+		for(size_t body = 0; body < bodies.size(); body++)
+		{
+			std::istringstream stream(std::string(bodies[body].first, bodies[body].second));
+			float value;
+			while(stream >> value)
+				values.push_back(value);
+		}
+	}
+
+	void ParseWithStrtod(const std::vector<std::pair<const char *, const char *> > &bodies,
+		std::vector<float> &values)
+	{
+		values.clear();
+		for(size_t body = 0; body < bodies.size(); body++)
+		{
+			const char *pCurr = bodies[body].first;
+			for(;;)
+			{
+				char *pEnd = NULL;
+				const double value = strtod(pCurr, &pEnd);
+				if(pEnd == pCurr)
+					break;
+
+				values.push_back((float)value);
+				pCurr = pEnd;
+			}
+		}
+	}
+
+	void ParseWithParseFloat(const std::vector<std::pair<const char *, const char *> > &bodies,
+		std::vector<float> &values)
+	{
+		values.clear();
+		for(size_t body = 0; body < bodies.size(); body++)
+		{
+			const char *pCurr = bodies[body].first;
+			float value;
+			while((pCurr = Framework::ParseFloat(pCurr, value)) != NULL)
+				values.push_back(value);
+		}
+	}
+
+	typedef void (*ParseFunc)(const std::vector<std::pair<const char *, const char *> > &,
+		std::vector<float> &);
+
+	//The fastest of the passes, in seconds.
+	double TimeParse(ParseFunc Parse, int numPasses,
+		const std::vector<std::pair<const char *, const char *> > &bodies,
+		std::vector<float> &values)
+	{
+		double bestSeconds = 0.0;
+		for(int pass = 0; pass < numPasses; pass++)
+		{
+			clock_t start = clock();
+			Parse(bodies, values);
+			const double seconds = SecondsSince(start);
+			if(pass == 0 || seconds < bestSeconds)
+				bestSeconds = seconds;
+		}
+
+		return bestSeconds;
+	}
+
+	size_t CountDifferences(const std::vector<float> &lhs, const std::vector<float> &rhs)
+	{
+		size_t numDifferent = lhs.size() > rhs.size() ? lhs.size() - rhs.size() :
+			rhs.size() - lhs.size();
+		for(size_t value = 0; value < std::min(lhs.size(), rhs.size()); value++)
+		{
+			if(memcmp(&lhs[value], &rhs[value], sizeof(float)) != 0)
+				numDifferent++;
+		}
+
+		return numDifferent;
+	}
+
+	void Parse(const std::vector<std::string> &args)
+	{
+		if(args.empty() || args.size() > 2)
+			throw std::runtime_error("Usage: parse <mesh.xml> [<passes>]");
+
+		const int numPasses = args.size() > 1 ? atoi(args[1].c_str()) : 10;
+		if(numPasses < 1)
+			throw std::runtime_error("There must be at least one pass.");
+
+		Framework::MappedFile file(args[0]);
+		if(!file.IsOpen())
+			throw std::runtime_error("Could not open " + args[0] + ".");
+
+		//A copy, so that the text is null-terminated for strstr.
+		std::vector<char> text(file.GetData(), file.GetData() + file.GetSize());
+		text.push_back('\0');
+
+		std::vector<std::pair<const char *, const char *> > bodies;
+		FindFloatBodies(text, bodies);
+		size_t numBytes = 0;
+		for(size_t body = 0; body < bodies.size(); body++)
+			numBytes += bodies[body].second - bodies[body].first;
+
+		std::vector<float> streamValues, strtodValues, parseValues;
+		const double streamSeconds = TimeParse(ParseWithStream, numPasses, bodies, streamValues);
+		const double strtodSeconds = TimeParse(ParseWithStrtod, numPasses, bodies, strtodValues);
+		const double parseSeconds = TimeParse(ParseWithParseFloat, numPasses, bodies, parseValues);
+
+		printf("%s: %lu float bodies, %lu values in %.2f MB, best of %d passes\n",
+			args[0].c_str(), (unsigned long)bodies.size(), (unsigned long)parseValues.size(),
+			numBytes / (1024.0 * 1024.0), numPasses);
+
+		const char *const strNames[] = {"string stream", "strtod", "ParseFloat"};
+		const double seconds[] = {streamSeconds, strtodSeconds, parseSeconds};
+		for(int method = 0; method < 3; method++)
+		{
+			printf("  %-13s %7.2f ms, %6.1f MB/s, %.1fx the stream\n", strNames[method],
+				seconds[method] * 1000.0, numBytes / (1024.0 * 1024.0) / seconds[method],
+				streamSeconds / seconds[method]);
+		}
+
+		printf("  ParseFloat differs from strtod on %lu values, from the stream on %lu\n",
+			(unsigned long)CountDifferences(parseValues, strtodValues),
+			(unsigned long)CountDifferences(parseValues, streamValues));
+	}
+
+	struct Command
+	{
+		const char *strName;
+		void (*Run)(const std::vector<std::string> &args);
+	};
+
+	const Command g_commands[] =
+	{
+		{"clusters", Clusters},
+		{"convert", Convert},
+		{"info", Info},
+		{"lod", Lod},
+		{"optimize", Optimize},
+		{"parse", Parse},
+	};
+}
+
+int main(int argc, char *argv[])
+{
+	const size_t numCommands = sizeof(g_commands) / sizeof(g_commands[0]);
+
+	if(argc >= 2)
+	{
+		for(size_t command = 0; command < numCommands; command++)
+		{
+			if(strcmp(argv[1], g_commands[command].strName) != 0)
+				continue;
+
+			try
+			{
+				g_commands[command].Run(std::vector<std::string>(argv + 2, argv + argc));
+				return 0;
+			}
+			catch(std::exception &e)
+			{
+				fprintf(stderr, "%s\n", e.what());
+				return 1;
+			}
+		}
+	}
+
+	fprintf(stderr, "Commands:");
+	for(size_t command = 0; command < numCommands; command++)
+		fprintf(stderr, " %s", g_commands[command].strName);
+	fprintf(stderr, "\n");
+	return 1;
+}
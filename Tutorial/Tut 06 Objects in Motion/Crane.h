@@ -0,0 +1,330 @@
+// This file is licensed under the MIT License.
+
+#ifndef CRANE_H
+#define CRANE_H
+
+#include <assert.h>
+#include <vector>
+#include <glm/glm.hpp>
+#include "MatrixKernels.h"
+
+// Flattened transform hierarchy. Every node lives at an index in a set of
+// parallel arrays, and a node is always added after its parent, so walking
+// the arrays front to back visits parents before children. World matrices
+// are cached and only recomputed for nodes whose local transform, or whose
+// ancestor's local transform, changed since the last Update().
+class TransformHierarchy {
+public:
+  static const size_t NO_PARENT = (size_t)-1;
+
+  TransformHierarchy() : m_anyDirty(false) {}
+
+  // Builds translate => rotate (Z, then Y, then X) => scale.
+  static glm::mat4 Compose(const glm::vec3 &translation,
+                           const glm::vec3 &rotation, const glm::vec3 &scale) {
+    glm::mat4 theMat(1.0f);
+    theMat[3] = glm::vec4(translation, 1.0f);
+    ApplyRotateZ(theMat, rotation.z);
+    ApplyRotateY(theMat, rotation.y);
+    ApplyRotateX(theMat, rotation.x);
+    ApplyScale(theMat, scale);
+    return theMat;
+  }
+
+  // 'local' is passed down to the children; 'draw' is only applied to the
+  // node's own mesh. Invisible nodes are pure pivots.
+  size_t AddNode(size_t parent, const glm::mat4 &local, bool vis,
+                 const glm::mat4 &draw = glm::mat4(1.0f)) {
+    assert(parent == NO_PARENT || parent < m_parents.size());
+
+    m_parents.push_back(parent);
+    m_localMats.push_back(local);
+    m_drawMats.push_back(draw);
+    m_worldMats.push_back(glm::mat4(1.0f));
+    m_finalMats.push_back(glm::mat4(1.0f));
+    m_visible.push_back(vis);
+    m_dirty.push_back(true);
+    m_anyDirty = true;
+
+    return m_parents.size() - 1;
+  }
+
+  void SetLocal(size_t ix, const glm::mat4 &local) {
+    m_localMats[ix] = local;
+    m_dirty[ix] = true;
+    m_anyDirty = true;
+  }
+
+  // Recomputes the world matrices of dirty subtrees. Does nothing if no node
+  // changed since the last call.
+  void Update() {
+    if (!m_anyDirty)
+      return;
+
+    for (size_t ix = 0; ix < m_parents.size(); ++ix) {
+      size_t parent = m_parents[ix];
+      if (parent != NO_PARENT && m_dirty[parent])
+        m_dirty[ix] = true;
+
+      if (!m_dirty[ix])
+        continue;
+
+      if (parent == NO_PARENT)
+        m_worldMats[ix] = m_localMats[ix];
+      else
+        m_worldMats[ix] = m_worldMats[parent] * m_localMats[ix];
+
+      m_finalMats[ix] = m_worldMats[ix] * m_drawMats[ix];
+    }
+
+    // Cleared in a second pass; children read their parent's flag above.
+    for (size_t ix = 0; ix < m_dirty.size(); ++ix)
+      m_dirty[ix] = false;
+
+    m_anyDirty = false;
+  }
+
+  size_t GetNumNodes() const { return m_parents.size(); }
+
+  // Invisible nodes are only pivots and have nothing to draw.
+  bool IsVisible(size_t ix) const { return m_visible[ix] != 0; }
+
+  // The node's world matrix with its draw-only transform applied. Current as
+  // of the last Update().
+  const glm::mat4 &GetFinalMatrix(size_t ix) const { return m_finalMats[ix]; }
+
+private:
+  std::vector<size_t> m_parents;
+  std::vector<glm::mat4> m_localMats;
+  std::vector<glm::mat4> m_drawMats;
+  std::vector<glm::mat4> m_worldMats;
+  std::vector<glm::mat4> m_finalMats;
+  std::vector<char> m_visible;
+  std::vector<char> m_dirty;
+  bool m_anyDirty;
+};
+
+class Crane {
+public:
+  Crane() : baseTranslation(glm::vec3(4.0f, -5.0f, -40.0f)), 
+        baseRotationY(45.0f),
+        baseLeftTranslation(glm::vec3(2.0f, 0.0f, 0.0f)),
+        baseRightTranslation(glm::vec3(-2.0f, 0.0f, 0.0f)),
+        baseLength(3.0f),
+        upperArmRotationX(-33.75f),
+        upperArmLength(9.0f),
+        lowerArmTranslation(glm::vec3(0.0f, 0.0f, 8.0f)),
+        lowerArmRotationX(146.25f), lowerArmLength(5.0f),
+        lowerArmWidth(1.5f),
+        wristTranslation(glm::vec3(0.0f, 0.0f, 5.0f)),
+        wristRotationZ(0.0f),
+        wristRotationX(67.5f),
+        wristLength(2.0f),
+        wristWidth(2.0f),
+        leftFingerTranslation(glm::vec3(1.0f, 0.0f, 1.0f)),
+        rightFingerTranslation(glm::vec3(-1.0f, 0.0f, 1.0f)),
+        fingerOpenRotationY(180.0f),
+        fingerLength(2.0f),
+        fingerWidth(0.5f),
+        lowerFingerRotationY(45.0f) {
+    BuildHierarchy();
+  }
+
+  // Only does work on frames after a joint moved.
+  const TransformHierarchy &Update() {
+    hierarchy.Update();
+    return hierarchy;
+  }
+
+
+void addToBaseRotationY(float val) {
+  baseRotationY += val;
+  baseRotationY = fmodf(baseRotationY, 360.0f);
+  UpdateJoints();
+}
+
+// void addToBaseLength(float val) {
+//   baseLength += val;
+// }
+
+void addToUpperArmRotationX(float val) {
+  upperArmRotationX += val;
+  upperArmRotationX = Clamp(upperArmRotationX, -90.0f, 0.0f);
+  UpdateJoints();
+}
+
+// void addToUpperArmLength(float val) {
+//   upperArmLength += val;
+// }
+
+void addToLowerArmRotationX(float val) {
+  lowerArmRotationX += val;
+  lowerArmRotationX = Clamp(lowerArmRotationX, 0.0f, 146.25f);
+  UpdateJoints();
+}
+
+// void addToLowerArmLength(float val) {
+//   lowerArmLength += val;
+// }
+
+// void addToLowerArmWidth(float val) {
+//   lowerArmWidth += val;
+// }
+
+void addToWristRotationZ(float val) {
+  wristRotationZ += val;
+  wristRotationZ = fmodf(wristRotationZ, 360.0f);
+  UpdateJoints();
+}
+
+void addToWristRotationX(float val) {
+  wristRotationX += val;
+  wristRotationX = Clamp(wristRotationX, 0.0f, 90.0f);
+  UpdateJoints();
+}
+
+// void addToWristLength(float val) {
+//   wristLength += val;
+// }
+
+// void addToWristWidth(float val) {
+//   wristWidth += val;
+// }
+
+void addToFingerOpenRotationY(float val) {
+  fingerOpenRotationY += val;
+  fingerOpenRotationY = Clamp(fingerOpenRotationY, 9.0f, 180.0f);
+  UpdateJoints();
+}
+
+// void addToFingerLength(float val) {
+//   fingerLength += val;
+// }
+
+// void addToFingerWidth(float val) {
+//   fingerWidth += val;
+// }
+
+// void addToLowerFingerRotationY(float val) {
+//   lowerFingerRotationY += val;
+// }
+
+private:
+  // Called once from the constructor. Everything except the joint rotations
+  // is fixed from here on; the joints are filled in by UpdateJoints().
+  void BuildHierarchy() {
+    const glm::vec3 noOffset(0.0f);
+    const glm::vec3 noRotation(0.0f);
+    const glm::vec3 noScale(1.0f);
+    const glm::mat4 identity(1.0f);
+
+    glm::mat4 fingerDraw = TransformHierarchy::Compose(
+        glm::vec3(0.0f, 0.0f, fingerLength / 2.0f), noRotation,
+        glm::vec3(fingerWidth / 2.0f, fingerWidth / 2.0f, fingerLength / 2.0f));
+
+    // TODO: turn all angles into radians
+    baseNode = hierarchy.AddNode(TransformHierarchy::NO_PARENT, identity, false);
+
+    hierarchy.AddNode(baseNode,
+                      TransformHierarchy::Compose(baseLeftTranslation, noRotation,
+                                                  glm::vec3(1.0f, 1.0f, baseLength)),
+                      true);
+    hierarchy.AddNode(baseNode,
+                      TransformHierarchy::Compose(baseRightTranslation, noRotation,
+                                                  glm::vec3(1.0f, 1.0f, baseLength)),
+                      true);
+
+    upperArmNode = hierarchy.AddNode(
+        baseNode, identity, true,
+        TransformHierarchy::Compose(
+            glm::vec3(0.0f, 0.0f, upperArmLength / 2.0f - 1.0f), noRotation,
+            glm::vec3(1.0f, 1.0f, upperArmLength / 2.0f)));
+
+    lowerArmNode = hierarchy.AddNode(
+        upperArmNode, identity, true,
+        TransformHierarchy::Compose(
+            glm::vec3(0.0f, 0.0f, lowerArmLength / 2.0f), noRotation,
+            glm::vec3(lowerArmWidth / 2.0f, lowerArmWidth / 2.0f, lowerArmLength / 2.0f)));
+
+    wristNode = hierarchy.AddNode(
+        lowerArmNode, identity, true,
+        TransformHierarchy::Compose(
+            noOffset, noRotation,
+            glm::vec3(wristWidth / 2.0f, wristWidth / 2.0f, wristLength / 2.0f)));
+
+    leftFingerNode = hierarchy.AddNode(wristNode, identity, true, fingerDraw);
+    hierarchy.AddNode(leftFingerNode,
+                      TransformHierarchy::Compose(glm::vec3(0.0f, 0.0f, fingerLength),
+                                                  glm::vec3(0.0f, -lowerFingerRotationY, 0.0f),
+                                                  noScale),
+                      true, fingerDraw);
+
+    rightFingerNode = hierarchy.AddNode(wristNode, identity, true, fingerDraw);
+    hierarchy.AddNode(rightFingerNode,
+                      TransformHierarchy::Compose(glm::vec3(0.0f, 0.0f, fingerLength),
+                                                  glm::vec3(0.0f, lowerFingerRotationY, 0.0f),
+                                                  noScale),
+                      true, fingerDraw);
+
+    UpdateJoints();
+  }
+
+  // Writes the current joint angles into the hierarchy. The affected subtrees
+  // are recomputed on the next Update().
+  void UpdateJoints() {
+    const glm::vec3 noOffset(0.0f);
+    const glm::vec3 noScale(1.0f);
+
+    hierarchy.SetLocal(baseNode, TransformHierarchy::Compose(
+                                     baseTranslation, glm::vec3(0.0f, baseRotationY, 0.0f), noScale));
+    hierarchy.SetLocal(upperArmNode, TransformHierarchy::Compose(
+                                         noOffset, glm::vec3(upperArmRotationX, 0.0f, 0.0f), noScale));
+    hierarchy.SetLocal(lowerArmNode, TransformHierarchy::Compose(
+                                         lowerArmTranslation, glm::vec3(lowerArmRotationX, 0.0f, 0.0f), noScale));
+    hierarchy.SetLocal(wristNode, TransformHierarchy::Compose(
+                                      wristTranslation, glm::vec3(wristRotationX, 0.0f, wristRotationZ), noScale));
+    hierarchy.SetLocal(leftFingerNode, TransformHierarchy::Compose(
+                                           leftFingerTranslation, glm::vec3(0.0f, fingerOpenRotationY, 0.0f), noScale));
+    hierarchy.SetLocal(rightFingerNode, TransformHierarchy::Compose(
+                                            rightFingerTranslation, glm::vec3(0.0f, -fingerOpenRotationY, 0.0f), noScale));
+  }
+
+  glm::vec3 baseTranslation;
+  float baseRotationY;
+
+  glm::vec3 baseLeftTranslation;
+  glm::vec3 baseRightTranslation;
+  float baseLength;
+
+  float upperArmRotationX;
+  float upperArmLength;
+
+  glm::vec3 lowerArmTranslation;
+  float lowerArmRotationX;
+  float lowerArmLength;
+  float lowerArmWidth;
+
+  glm::vec3 wristTranslation;
+  float wristRotationZ; // ROLL
+  float wristRotationX; // PITCH
+  float wristLength;
+  float wristWidth;
+
+  glm::vec3 leftFingerTranslation;
+  glm::vec3 rightFingerTranslation;
+  float fingerOpenRotationY;
+  float fingerLength;
+  float fingerWidth;
+  float lowerFingerRotationY;
+
+  TransformHierarchy hierarchy;
+
+  size_t baseNode;
+  size_t upperArmNode;
+  size_t lowerArmNode;
+  size_t wristNode;
+  size_t leftFingerNode;
+  size_t rightFingerNode;
+};
+
+#endif // CRANE_H
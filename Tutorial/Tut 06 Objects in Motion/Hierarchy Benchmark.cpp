@@ -0,0 +1,400 @@
+// This file is licensed under the MIT License.
+
+// Console timings for the Hierarchy tutorial's CPU-side code. No window or GL
+// context is made; where the tutorial would upload a matrix, this copies it
+// into a local buffer instead.
+//
+// 1: Crane frames: heap allocations and time per frame, both for frames where
+// nothing moved and for frames after a joint change.
+// 2: Matrix stack kernels: a Tut 07 style traversal of deep push/pop chains,
+// with the stack ops done as full mat4 products, as in-place kernels on a mat4,
+// and as in-place kernels on the affine mat4x3 stack.
+// 3: AffineMatrixStack's InverseTop(), ApplyMatrix() and TopWithProjection()
+// against glm::inverse and full mat4 products, on random transform chains.
+
+#include <stack>
+#include <stdexcept>
+#include <new>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <glm/glm.hpp>
+#include "MatrixKernels.h"
+#include "Crane.h"
+
+#if __cplusplus >= 201103L
+#define NO_THROW noexcept
+#else
+#define NO_THROW throw()
+#endif
+
+namespace {
+size_t g_numAllocations = 0;
+}
+
+// Every heap allocation in the program goes through these.
+void *operator new(size_t size) {
+  ++g_numAllocations;
+  void *pMemory = malloc(size ? size : 1);
+  if (!pMemory)
+    throw std::bad_alloc();
+  return pMemory;
+}
+
+void operator delete(void *pMemory) NO_THROW { free(pMemory); }
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *pMemory, size_t) NO_THROW { free(pMemory); }
+#endif
+
+namespace {
+double SecondsSince(clock_t start) {
+  return (clock() - start) / (double)CLOCKS_PER_SEC;
+}
+
+// What RenderCrane() does, minus the GL calls.
+float RenderCraneFrame(Crane &crane) {
+  const TransformHierarchy &hierarchy = crane.Update();
+
+  float uploaded[16];
+  float checksum = 0.0f;
+  for (size_t ix = 0; ix < hierarchy.GetNumNodes(); ++ix) {
+    if (!hierarchy.IsVisible(ix))
+      continue;
+
+    memcpy(uploaded, &hierarchy.GetFinalMatrix(ix)[0].x, sizeof(uploaded));
+    checksum += uploaded[12];
+  }
+
+  return checksum;
+}
+
+void TimeCraneFrames(const char *strLabel, Crane &crane, int numFrames,
+                     bool bMoveJoint) {
+  float checksum = 0.0f;
+  size_t startAllocations = g_numAllocations;
+  clock_t start = clock();
+  for (int frame = 0; frame < numFrames; ++frame) {
+    if (bMoveJoint)
+      crane.addToBaseRotationY(1.0f);
+
+    checksum += RenderCraneFrame(crane);
+  }
+  double frameNs = SecondsSince(start) * 1.0e9 / numFrames;
+  size_t numAllocations = g_numAllocations - startAllocations;
+
+  printf("%-14s %9.1f ns/frame   %lu allocations in %d frames   (%g)\n",
+         strLabel, frameNs, (unsigned long)numAllocations, numFrames,
+         checksum);
+}
+
+void BenchmarkCraneFrames() {
+  printf("Crane frames:\n");
+
+  size_t startAllocations = g_numAllocations;
+  Crane crane;
+  printf("%-14s %lu allocations\n", "construction",
+         (unsigned long)(g_numAllocations - startAllocations));
+
+  // Warm up, so the first Update() after construction is not counted.
+  for (int frame = 0; frame < 10; ++frame)
+    RenderCraneFrame(crane);
+
+  TimeCraneFrames("steady", crane, 10000000, false);
+  TimeCraneFrames("joint moved", crane, 1000000, true);
+}
+
+// The stack ops as they were before the in-place kernels: each one builds a
+// full mat4 and multiplies it in.
+class FullProductStack {
+public:
+  FullProductStack() : m_currMat(1.0f) {}
+
+  const glm::mat4 &Top() const { return m_currMat; }
+
+  void RotateX(float fAngDeg) {
+    m_currMat = m_currMat * glm::mat4(::RotateX(fAngDeg));
+  }
+  void RotateY(float fAngDeg) {
+    m_currMat = m_currMat * glm::mat4(::RotateY(fAngDeg));
+  }
+  void RotateZ(float fAngDeg) {
+    m_currMat = m_currMat * glm::mat4(::RotateZ(fAngDeg));
+  }
+
+  void Scale(const glm::vec3 &scaleVec) {
+    glm::mat4 scaleMat(1.0f);
+    scaleMat[0].x = scaleVec.x;
+    scaleMat[1].y = scaleVec.y;
+    scaleMat[2].z = scaleVec.z;
+    m_currMat = m_currMat * scaleMat;
+  }
+
+  void Translate(const glm::vec3 &offsetVec) {
+    glm::mat4 translateMat(1.0f);
+    translateMat[3] = glm::vec4(offsetVec, 1.0f);
+    m_currMat = m_currMat * translateMat;
+  }
+
+  void Push() { m_matrices.push(m_currMat); }
+
+  void Pop() {
+    m_currMat = m_matrices.top();
+    m_matrices.pop();
+  }
+
+private:
+  glm::mat4 m_currMat;
+  std::stack<glm::mat4> m_matrices;
+};
+
+// Stands in for uploading the matrix.
+template <typename Stack> float UploadTop(const Stack &modelMatrix) {
+  glm::mat4 top = modelMatrix.Top();
+  return top[3].x + top[0].y;
+}
+
+template <typename Stack>
+float DrawPart(Stack &modelMatrix, const glm::vec3 &offset,
+               const glm::vec3 &scale) {
+  modelMatrix.Push();
+  modelMatrix.Translate(offset);
+  modelMatrix.Scale(scale);
+  modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
+  float checksum = UploadTop(modelMatrix);
+  modelMatrix.Pop();
+  return checksum;
+}
+
+// The shape of Tut 07's display(): a camera transform, then DrawForest() and
+// DrawParthenon(), with each part of each object under its own push/pop.
+template <typename Stack> float DrawWorld(Stack &modelMatrix) {
+  float checksum = 0.0f;
+
+  modelMatrix.Push();
+  modelMatrix.RotateX(-21.0f);
+  modelMatrix.RotateY(67.5f);
+  modelMatrix.RotateZ(2.0f);
+  modelMatrix.Translate(glm::vec3(-60.0f, -50.0f, -120.0f));
+
+  // Forest: a tree is a trunk and a treetop under the tree's own translation.
+  for (int tree = 0; tree < 100; ++tree) {
+    const float fTrunkHeight = 2.0f + (tree % 3) * 0.5f;
+    const float fConeHeight = 3.0f + (tree % 5) * 0.5f;
+
+    modelMatrix.Push();
+    modelMatrix.Translate(glm::vec3((tree % 10) * 9.0f - 45.0f, 0.0f,
+                                    (tree / 10) * 9.0f - 45.0f));
+    checksum += DrawPart(modelMatrix, glm::vec3(0.0f),
+                         glm::vec3(1.0f, fTrunkHeight, 1.0f));
+    checksum += DrawPart(modelMatrix, glm::vec3(0.0f, fTrunkHeight, 0.0f),
+                         glm::vec3(3.0f, fConeHeight, 3.0f));
+    modelMatrix.Pop();
+  }
+
+  // Parthenon: base, top, and two rows of columns of three parts each.
+  modelMatrix.Push();
+  modelMatrix.Translate(glm::vec3(20.0f, 0.0f, -10.0f));
+  modelMatrix.RotateY(15.0f);
+  checksum += DrawPart(modelMatrix, glm::vec3(0.0f),
+                       glm::vec3(14.0f, 1.0f, 20.0f));
+  checksum += DrawPart(modelMatrix, glm::vec3(0.0f, 6.0f, 0.0f),
+                       glm::vec3(14.0f, 1.0f, 20.0f));
+
+  for (int column = 0; column < 7; ++column) {
+    for (int side = 0; side < 2; ++side) {
+      modelMatrix.Push();
+      modelMatrix.Translate(
+          glm::vec3(2.0f * column - 6.0f, 1.0f, side ? -9.0f : 9.0f));
+      checksum += DrawPart(modelMatrix, glm::vec3(0.0f),
+                           glm::vec3(1.0f, 0.25f, 1.0f));
+      checksum += DrawPart(modelMatrix, glm::vec3(0.0f, 4.75f, 0.0f),
+                           glm::vec3(1.0f, 0.25f, 1.0f));
+      checksum += DrawPart(modelMatrix, glm::vec3(0.0f, 0.25f, 0.0f),
+                           glm::vec3(0.8f, 4.5f, 0.8f));
+      modelMatrix.Pop();
+    }
+  }
+  modelMatrix.Pop();
+
+  modelMatrix.Pop();
+  return checksum;
+}
+
+template <typename Stack>
+double TimeStack(const char *strLabel, int numFrames, double baselineNs) {
+  Stack modelMatrix;
+  float checksum = 0.0f;
+
+  clock_t start = clock();
+  for (int frame = 0; frame < numFrames; ++frame)
+    checksum += DrawWorld(modelMatrix);
+  double frameNs = SecondsSince(start) * 1.0e9 / numFrames;
+
+  printf("%-20s %9.1f ns/frame   %5.2fx   (%g)\n", strLabel, frameNs,
+         baselineNs > 0.0 ? baselineNs / frameNs : 1.0, checksum / numFrames);
+  return frameNs;
+}
+
+void BenchmarkMatrixStacks() {
+#ifdef USE_SSE_MATRIX_KERNELS
+  printf("Matrix stacks, SSE kernels:\n");
+#else
+  printf("Matrix stacks, scalar kernels:\n");
+#endif
+
+  const int numFrames = 20000;
+  double baselineNs =
+      TimeStack<FullProductStack>("full mat4 products", numFrames, 0.0);
+  TimeStack<MatrixStack>("mat4 kernels", numFrames, baselineNs);
+  TimeStack<AffineMatrixStack>("mat4x3 kernels", numFrames, baselineNs);
+}
+
+float RandomFloat(float fMin, float fMax) {
+  return fMin + (fMax - fMin) * (rand() / (float)RAND_MAX);
+}
+
+glm::vec3 RandomVec3(float fMin, float fMax) {
+  return glm::vec3(RandomFloat(fMin, fMax), RandomFloat(fMin, fMax),
+                   RandomFloat(fMin, fMax));
+}
+
+// A random chain of the stack's ops, applied to both stacks.
+void RandomChain(AffineMatrixStack &affine, FullProductStack &full) {
+  for (int op = 0; op < 8; ++op) {
+    switch (rand() % 5) {
+    case 0: {
+      float fAngDeg = RandomFloat(-180.0f, 180.0f);
+      affine.RotateX(fAngDeg);
+      full.RotateX(fAngDeg);
+    } break;
+    case 1: {
+      float fAngDeg = RandomFloat(-180.0f, 180.0f);
+      affine.RotateY(fAngDeg);
+      full.RotateY(fAngDeg);
+    } break;
+    case 2: {
+      float fAngDeg = RandomFloat(-180.0f, 180.0f);
+      affine.RotateZ(fAngDeg);
+      full.RotateZ(fAngDeg);
+    } break;
+    case 3: {
+      glm::vec3 scaleVec = RandomVec3(0.25f, 4.0f);
+      affine.Scale(scaleVec);
+      full.Scale(scaleVec);
+    } break;
+    default: {
+      glm::vec3 offsetVec = RandomVec3(-50.0f, 50.0f);
+      affine.Translate(offsetVec);
+      full.Translate(offsetVec);
+    } break;
+    }
+  }
+}
+
+glm::mat4 Widen(const glm::mat4x3 &theMat) {
+  return glm::mat4(glm::vec4(theMat[0], 0.0f), glm::vec4(theMat[1], 0.0f),
+                   glm::vec4(theMat[2], 0.0f), glm::vec4(theMat[3], 1.0f));
+}
+
+// Largest difference between two matrices, relative to the larger of the
+// two's largest element.
+float RelativeError(const glm::mat4 &lhs, const glm::mat4 &rhs) {
+  float maxDiff = 0.0f;
+  float maxValue = 0.0f;
+  for (int col = 0; col < 4; ++col) {
+    for (int row = 0; row < 4; ++row) {
+      maxDiff = std::max(maxDiff, fabsf(lhs[col][row] - rhs[col][row]));
+      maxValue = std::max(maxValue, std::max(fabsf(lhs[col][row]),
+                                             fabsf(rhs[col][row])));
+    }
+  }
+
+  return maxValue > 0.0f ? maxDiff / maxValue : maxDiff;
+}
+
+void CheckAffineStack() {
+  printf("AffineMatrixStack against mat4 math, 10000 random chains:\n");
+
+  // The projection Hierarchy.cpp builds for its camera.
+  const float fFrustumScale = 1.0f / tanf(DegToRad(45.0f) / 2.0f);
+  const float fzNear = 1.0f, fzFar = 100.0f;
+  glm::mat4 projMat(0.0f);
+  projMat[0].x = fFrustumScale;
+  projMat[1].y = fFrustumScale;
+  projMat[2].z = (fzFar + fzNear) / (fzNear - fzFar);
+  projMat[2].w = -1.0f;
+  projMat[3].z = (2 * fzFar * fzNear) / (fzNear - fzFar);
+
+  srand(6);
+  const int numChains = 10000;
+  float inverseError = 0.0f;
+  float applyError = 0.0f;
+  float projectionError = 0.0f;
+  for (int chain = 0; chain < numChains; ++chain) {
+    AffineMatrixStack affine;
+    FullProductStack full;
+    RandomChain(affine, full);
+
+    // The inverse, checked by how far inverse * matrix is from identity.
+    const glm::mat4 fullMat = full.Top();
+    inverseError = std::max(
+        inverseError, RelativeError(Widen(affine.InverseTop()) * fullMat,
+                                    glm::inverse(fullMat) * fullMat));
+
+    // Composing with another random affine matrix.
+    AffineMatrixStack other;
+    FullProductStack otherFull;
+    RandomChain(other, otherFull);
+    affine.ApplyMatrix(other.TopAffine());
+    applyError = std::max(applyError, RelativeError(affine.Top(),
+                                                    fullMat * otherFull.Top()));
+
+    projectionError = std::max(
+        projectionError, RelativeError(affine.TopWithProjection(projMat),
+                                       projMat * affine.Top()));
+  }
+
+  // Inverse timings on one chain, nudged each pass so nothing is hoisted.
+  AffineMatrixStack timed;
+  FullProductStack timedFull;
+  RandomChain(timed, timedFull);
+  const glm::mat4 timedMat = timedFull.Top();
+  const int numInverses = 1000000;
+  float checksum = 0.0f;
+  clock_t start = clock();
+  for (int ix = 0; ix < numInverses; ++ix) {
+    timed.Translate(glm::vec3(1.0e-6f, 0.0f, 0.0f));
+    checksum += timed.InverseTop()[3].x;
+  }
+  double affineInverseNs = SecondsSince(start) * 1.0e9 / numInverses;
+
+  glm::mat4 fullMat = timedMat;
+  start = clock();
+  for (int ix = 0; ix < numInverses; ++ix) {
+    fullMat[3].x += 1.0e-6f;
+    checksum += glm::inverse(fullMat)[3].x;
+  }
+  double fullInverseNs = SecondsSince(start) * 1.0e9 / numInverses;
+
+  printf("InverseTop()         max error %.2g   %6.1f ns   glm::inverse %6.1f "
+         "ns   %5.2fx   (%g)\n",
+         inverseError, affineInverseNs, fullInverseNs,
+         fullInverseNs / affineInverseNs, checksum);
+  printf("ApplyMatrix()        max error %.2g\n", applyError);
+  printf("TopWithProjection()  max error %.2g\n", projectionError);
+}
+} // namespace
+
+int main() {
+  BenchmarkCraneFrames();
+  printf("\n");
+  BenchmarkMatrixStacks();
+  printf("\n");
+  CheckAffineStack();
+
+  return 0;
+}
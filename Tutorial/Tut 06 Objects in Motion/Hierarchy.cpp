@@ -6,11 +6,14 @@
 #include <stack>
 #include <math.h>
 #include <stdio.h>
+#include <assert.h>
 #include <glload/gl_3_3.h>
 #include <GL/freeglut.h>
 #include "../framework/framework.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "MatrixKernels.h"
+#include "Crane.h"
 
 GLuint theProgram;
 GLuint positionAttrib;
@@ -235,462 +238,26 @@ void InitializeVAO() {
   glBindVertexArray(0);
 }
 
-inline float DegToRad(float fAngDeg) {
-  const float fDegToRad = 3.14159f * 2.0f / 360.0f;
-  return fAngDeg * fDegToRad;
-}
-
-inline float Clamp(float fValue, float fMinValue, float fMaxValue) {
-  if (fValue < fMinValue)
-    return fMinValue;
-
-  if (fValue > fMaxValue)
-    return fMaxValue;
-
-  return fValue;
-}
-
-glm::mat3 RotateX(float fAngDeg) {
-  float fAngRad = DegToRad(fAngDeg);
-  float fCos = cosf(fAngRad);
-  float fSin = sinf(fAngRad);
-
-  glm::mat3 theMat(1.0f);
-  theMat[1].y = fCos;
-  theMat[2].y = -fSin;
-  theMat[1].z = fSin;
-  theMat[2].z = fCos;
-  return theMat;
-}
-
-glm::mat3 RotateY(float fAngDeg) {
-  float fAngRad = DegToRad(fAngDeg);
-  float fCos = cosf(fAngRad);
-  float fSin = sinf(fAngRad);
-
-  glm::mat3 theMat(1.0f);
-  theMat[0].x = fCos;
-  theMat[2].x = fSin;
-  theMat[0].z = -fSin;
-  theMat[2].z = fCos;
-  return theMat;
-}
-
-glm::mat3 RotateZ(float fAngDeg) {
-  float fAngRad = DegToRad(fAngDeg);
-  float fCos = cosf(fAngRad);
-  float fSin = sinf(fAngRad);
-
-  glm::mat3 theMat(1.0f);
-  theMat[0].x = fCos;
-  theMat[1].x = -fSin;
-  theMat[0].y = fSin;
-  theMat[1].y = fCos;
-  return theMat;
-}
-
-// Node.cpp
-
-class Node {
-public:
-  enum TRANSFORMATION_TYPE { TRANSLATION, ROTATION, SCALE };
-
-  struct Transformation {
-    float x;
-    float y;
-    float z;
-    TRANSFORMATION_TYPE type;
-  };
-
-  Node() : vis(true) {}
-
-  void Render(glm::mat4 m_currMat) {
-
-    /* translate => rotate => children =>
-       translate (center based on size) =>
-       scale => draw */
-
-    for (Transformation t : preRenderTransformations) {
-      switch (t.type) {
-      case TRANSFORMATION_TYPE::TRANSLATION:
-        Translate(m_currMat, t);
-        break;
-      case TRANSFORMATION_TYPE::ROTATION:
-        Rotate(m_currMat, t);
-        break;
-      case TRANSFORMATION_TYPE::SCALE:
-        Scale(m_currMat, t);
-        break;
-      }
-    }
-
-    for (size_t i = 0; i < children.size(); ++i) {
-      children[i]->Render(m_currMat);
-    }
-
-    if (vis) {
-      for (Transformation t : postRenderTransformations) {
-        switch (t.type) {
-        case TRANSFORMATION_TYPE::TRANSLATION:
-          Translate(m_currMat, t);
-          break;
-        case TRANSFORMATION_TYPE::ROTATION:
-          Rotate(m_currMat, t);
-          break;
-        case TRANSFORMATION_TYPE::SCALE:
-          Scale(m_currMat, t);
-          break;
-        }
-      }
-
-      glUniformMatrix4fv(modelToCameraMatrixUnif, 1, GL_FALSE,
-                         glm::value_ptr(m_currMat));
-      glDrawElements(GL_TRIANGLES, ARRAY_COUNT(indexData), GL_UNSIGNED_SHORT,
-                     0);
-    }
-  }
-
-  void AddChild(Node &child) { children.push_back(&child); }
-
-  void AddPreRenderTransformation(Transformation transformation) {
-    preRenderTransformations.push_back(transformation);
-  }
-
-  void AddPreRenderTranslation(glm::vec3 translation) {
-    AddPreRenderTransformation(
-        Transformation{translation.x, translation.y, translation.z, TRANSFORMATION_TYPE::TRANSLATION});
-  }
-
-  void AddPreRenderTranslation(float x, float y, float z) {
-    AddPreRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::TRANSLATION});
-  }
-
-  void AddPreRenderRotation(float x, float y, float z) {
-    AddPreRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::ROTATION});
-  }
-
-  void AddPreRenderScale(float x, float y, float z) {
-    AddPreRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::SCALE});
-  }
-
-  void AddPostRenderTransformation(Transformation transformation) {
-    postRenderTransformations.push_back(transformation);
-  }
-
-  void AddPostRenderTranslation(float x, float y, float z) {
-    AddPostRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::TRANSLATION});
-  }
-
-  void AddPostRenderRotation(float x, float y, float z) {
-    AddPostRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::ROTATION});
-  }
-
-  void AddPostRenderScale(float x, float y, float z) {
-    AddPostRenderTransformation(
-        Transformation{x, y, z, TRANSFORMATION_TYPE::SCALE});
-  }
-
-  bool vis; // visible yes or no, this is used for organization to build mid
-            // points to translate / rotate
-
-private:
-  void Translate(glm::mat4 &m_currMat, Transformation transformation) {
-    glm::mat4 translateMat(1.0f);
-    translateMat[3] =
-        glm::vec4(transformation.x, transformation.y, transformation.z, 1.0f);
-
-    m_currMat = m_currMat * translateMat;
-  }
-
-  void Scale(glm::mat4 &m_currMat, Transformation transformation) {
-    glm::mat4 scaleMat(1.0f);
-    scaleMat[0].x = transformation.x;
-    scaleMat[1].y = transformation.y;
-    scaleMat[2].z = transformation.z;
-
-    m_currMat = m_currMat * scaleMat;
-  }
-
-  void Rotate(glm::mat4 &m_currMat, Transformation transformation) {
-    // Order is important.
-    if (transformation.z) {
-      RotateZ(m_currMat, transformation.z);
-    }
-    if (transformation.y) {
-      RotateY(m_currMat, transformation.y);
-    }
-    if (transformation.x) {
-      RotateX(m_currMat, transformation.x);
-    }
-  }
-
-  void RotateX(glm::mat4 &m_currMat, float radians) {
-    m_currMat = m_currMat * glm::mat4(::RotateX(radians));
-  }
-
-  void RotateY(glm::mat4 &m_currMat, float radians) {
-    m_currMat = m_currMat * glm::mat4(::RotateY(radians));
-  }
+// The crane's matrices are kept by its hierarchy; this only uploads them.
+void RenderCrane(Crane &crane) {
+  const TransformHierarchy &hierarchy = crane.Update();
 
-  void RotateZ(glm::mat4 &m_currMat, float radians) {
-    m_currMat = m_currMat * glm::mat4(::RotateZ(radians));
-  }
-
-  std::vector<Node *> children;
-  std::vector<Transformation> preRenderTransformations;
-  std::vector<Transformation> postRenderTransformations;
-};
-
-class Crane {
-public:
-  Crane() : baseTranslation(glm::vec3(4.0f, -5.0f, -40.0f)), 
-        baseRotationY(45.0f),
-        baseLeftTranslation(glm::vec3(2.0f, 0.0f, 0.0f)),
-        baseRightTranslation(glm::vec3(-2.0f, 0.0f, 0.0f)),
-        baseLength(3.0f),
-        upperArmRotationX(-33.75f),
-        upperArmLength(9.0f),
-        lowerArmTranslation(glm::vec3(0.0f, 0.0f, 8.0f)),
-        lowerArmRotationX(146.25f), lowerArmLength(5.0f),
-        lowerArmWidth(1.5f),
-        wristTranslation(glm::vec3(0.0f, 0.0f, 5.0f)),
-        wristRotationZ(0.0f),
-        wristRotationX(67.5f),
-        wristLength(2.0f),
-        wristWidth(2.0f),
-        leftFingerTranslation(glm::vec3(1.0f, 0.0f, 1.0f)),
-        rightFingerTranslation(glm::vec3(-1.0f, 0.0f, 1.0f)),
-        fingerOpenRotationY(180.0f),
-        fingerLength(2.0f),
-        fingerWidth(0.5f),
-        lowerFingerRotationY(45.0f) {}
-
-  void Render() {
-    // Initialize all nodes
-    Node base, baseLeft, baseRight, upperArm, lowerArm, wrist, leftFinger,
-        leftLowerFinger, rightFinger, rightLowerFinger;
-
-    // Set up the hierarchy
-    base.AddChild(baseLeft);
-    base.AddChild(baseRight);
-    base.AddChild(upperArm);
-    upperArm.AddChild(lowerArm);
-    lowerArm.AddChild(wrist);
-    wrist.AddChild(leftFinger);
-    leftFinger.AddChild(leftLowerFinger);
-    wrist.AddChild(rightFinger);
-    rightFinger.AddChild(rightLowerFinger);
-
-    // TODO: turn all angles into radians
-    base.vis = false;
-    base.AddPreRenderTranslation(baseTranslation);
-    base.AddPreRenderRotation(0.0f, baseRotationY, 0.0f);
-
-    baseLeft.AddPreRenderTranslation(baseLeftTranslation);
-    baseLeft.AddPreRenderScale(1.0f, 1.0f, baseLength);
-
-    baseRight.AddPreRenderTranslation(baseRightTranslation);
-    baseRight.AddPreRenderScale(1.0f, 1.0f, baseLength);
-
-    upperArm.AddPreRenderRotation(upperArmRotationX, 0.0f, 0.0f);
-
-    upperArm.AddPostRenderTranslation(0.0f, 0.0f, upperArmLength / 2.0f - 1.0f);
-    upperArm.AddPostRenderScale(1.0f, 1.0f, upperArmLength / 2.0f);
-
-    lowerArm.AddPreRenderTranslation(lowerArmTranslation);
-    lowerArm.AddPreRenderRotation(lowerArmRotationX, 0.0f, 0.0f);
-
-    lowerArm.AddPostRenderTranslation(0.0f, 0.0f, lowerArmLength / 2.0f);
-    lowerArm.AddPostRenderScale(lowerArmWidth / 2.0f, lowerArmWidth / 2.0f, lowerArmLength / 2.0f);
-
-    wrist.AddPreRenderTranslation(wristTranslation);
-    wrist.AddPreRenderRotation(wristRotationX, 0.0f, wristRotationZ);
-
-    wrist.AddPostRenderScale(wristWidth / 2.0f, wristWidth / 2.0f, wristLength / 2.0f);
-
-    leftFinger.AddPreRenderTranslation(leftFingerTranslation);
-    leftFinger.AddPreRenderRotation(0.0f, fingerOpenRotationY, 0.0f);
-
-    leftFinger.AddPostRenderTranslation(0.0f, 0.0f, fingerLength / 2.0f);
-    leftFinger.AddPostRenderScale(fingerWidth / 2.0f, fingerWidth / 2.0f, fingerLength / 2.0f);
-
-    leftLowerFinger.AddPreRenderTranslation(0.0f, 0.0f, fingerLength);
-    leftLowerFinger.AddPreRenderRotation(0.0f, -lowerFingerRotationY, 0.0f);
-
-    leftLowerFinger.AddPostRenderTranslation(0.0f, 0.0f, fingerLength / 2.0f);
-    leftLowerFinger.AddPostRenderScale(fingerWidth / 2.0f, fingerWidth / 2.0f, fingerLength / 2.0f);
-
-    rightFinger.AddPreRenderTranslation(rightFingerTranslation);
-    rightFinger.AddPreRenderRotation(0.0f, -fingerOpenRotationY, 0.0f);
-
-    rightFinger.AddPostRenderTranslation(0.0f, 0.0f, fingerLength / 2.0f);
-    rightFinger.AddPostRenderScale(fingerWidth / 2.0f, fingerWidth / 2.0f, fingerLength / 2.0f);
-
-    rightLowerFinger.AddPreRenderTranslation(0.0f, 0.0f, fingerLength);
-    rightLowerFinger.AddPreRenderRotation(0.0f, lowerFingerRotationY, 0.0f);
-
-    rightLowerFinger.AddPostRenderTranslation(0.0f, 0.0f, fingerLength / 2.0f);
-    rightLowerFinger.AddPostRenderScale(fingerWidth / 2.0f, fingerWidth / 2.0f, fingerLength / 2.0f);
-
-    glm::mat4 node_mat(1.0f);
-
-    glUseProgram(theProgram);
-    glBindVertexArray(vao);
+  glUseProgram(theProgram);
+  glBindVertexArray(vao);
 
-    base.Render(node_mat);
+  for (size_t ix = 0; ix < hierarchy.GetNumNodes(); ++ix) {
+    if (!hierarchy.IsVisible(ix))
+      continue;
 
-    glBindVertexArray(0);
-    glUseProgram(0);
+    glUniformMatrix4fv(modelToCameraMatrixUnif, 1, GL_FALSE,
+                       glm::value_ptr(hierarchy.GetFinalMatrix(ix)));
+    glDrawElements(GL_TRIANGLES, ARRAY_COUNT(indexData), GL_UNSIGNED_SHORT, 0);
   }
 
-
-void addToBaseRotationY(float val) {
-  baseRotationY += val;
-  baseRotationY = fmodf(baseRotationY, 360.0f);
-}
-
-// void addToBaseLength(float val) {
-//   baseLength += val;
-// }
-
-void addToUpperArmRotationX(float val) {
-  upperArmRotationX += val;
-  upperArmRotationX = Clamp(upperArmRotationX, -90.0f, 0.0f);
-}
-
-// void addToUpperArmLength(float val) {
-//   upperArmLength += val;
-// }
-
-void addToLowerArmRotationX(float val) {
-  lowerArmRotationX += val;
-  lowerArmRotationX = Clamp(lowerArmRotationX, 0.0f, 146.25f);
-}
-
-// void addToLowerArmLength(float val) {
-//   lowerArmLength += val;
-// }
-
-// void addToLowerArmWidth(float val) {
-//   lowerArmWidth += val;
-// }
-
-void addToWristRotationZ(float val) {
-  wristRotationZ += val;
-  wristRotationZ = fmodf(wristRotationZ, 360.0f);
-}
-
-void addToWristRotationX(float val) {
-  wristRotationX += val;
-  wristRotationX = Clamp(wristRotationX, 0.0f, 90.0f);
-}
-
-// void addToWristLength(float val) {
-//   wristLength += val;
-// }
-
-// void addToWristWidth(float val) {
-//   wristWidth += val;
-// }
-
-void addToFingerOpenRotationY(float val) {
-  fingerOpenRotationY += val;
-  fingerOpenRotationY = Clamp(fingerOpenRotationY, 9.0f, 180.0f);
+  glBindVertexArray(0);
+  glUseProgram(0);
 }
 
-// void addToFingerLength(float val) {
-//   fingerLength += val;
-// }
-
-// void addToFingerWidth(float val) {
-//   fingerWidth += val;
-// }
-
-// void addToLowerFingerRotationY(float val) {
-//   lowerFingerRotationY += val;
-// }
-
-private:
-  glm::vec3 baseTranslation;
-  float baseRotationY;
-
-  glm::vec3 baseLeftTranslation;
-  glm::vec3 baseRightTranslation;
-  float baseLength;
-
-  float upperArmRotationX;
-  float upperArmLength;
-
-  glm::vec3 lowerArmTranslation;
-  float lowerArmRotationX;
-  float lowerArmLength;
-  float lowerArmWidth;
-
-  glm::vec3 wristTranslation;
-  float wristRotationZ; // ROLL
-  float wristRotationX; // PITCH
-  float wristLength;
-  float wristWidth;
-
-  glm::vec3 leftFingerTranslation;
-  glm::vec3 rightFingerTranslation;
-  float fingerOpenRotationY;
-  float fingerLength;
-  float fingerWidth;
-  float lowerFingerRotationY;
-};
-
-class MatrixStack {
-public:
-  MatrixStack() : m_currMat(1.0f) {}
-
-  const glm::mat4 &Top() { return m_currMat; }
-
-  void RotateX(float fAngDeg) {
-    m_currMat = m_currMat * glm::mat4(::RotateX(fAngDeg));
-  }
-
-  void RotateY(float fAngDeg) {
-    m_currMat = m_currMat * glm::mat4(::RotateY(fAngDeg));
-  }
-
-  void RotateZ(float fAngDeg) {
-    m_currMat = m_currMat * glm::mat4(::RotateZ(fAngDeg));
-  }
-
-  void Scale(const glm::vec3 &scaleVec) {
-    glm::mat4 scaleMat(1.0f);
-    scaleMat[0].x = scaleVec.x;
-    scaleMat[1].y = scaleVec.y;
-    scaleMat[2].z = scaleVec.z;
-
-    m_currMat = m_currMat * scaleMat;
-  }
-
-  void Translate(const glm::vec3 &offsetVec) {
-    glm::mat4 translateMat(1.0f);
-    translateMat[3] = glm::vec4(offsetVec, 1.0f);
-
-    m_currMat = m_currMat * translateMat;
-  }
-
-  void Push() { m_matrices.push(m_currMat); }
-
-  void Pop() {
-    m_currMat = m_matrices.top();
-    m_matrices.pop();
-  }
-
-private:
-  glm::mat4 m_currMat;
-  std::stack<glm::mat4> m_matrices;
-};
-
 class Hierarchy {
 public:
   Hierarchy()
@@ -983,7 +550,7 @@ void display() {
   glClearDepth(1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  g_crane.Render();
+  RenderCrane(g_crane);
 
   g_armature.Draw();
 
@@ -0,0 +1,298 @@
+// This file is licensed under the MIT License.
+
+#ifndef MATRIX_KERNELS_H
+#define MATRIX_KERNELS_H
+
+#include <math.h>
+#include <stack>
+#include <glm/glm.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE_MATRIX_KERNELS
+#include <xmmintrin.h>
+#endif
+
+inline float DegToRad(float fAngDeg) {
+  const float fDegToRad = 3.14159f * 2.0f / 360.0f;
+  return fAngDeg * fDegToRad;
+}
+
+inline float Clamp(float fValue, float fMinValue, float fMaxValue) {
+  if (fValue < fMinValue)
+    return fMinValue;
+
+  if (fValue > fMaxValue)
+    return fMaxValue;
+
+  return fValue;
+}
+
+inline glm::mat3 RotateX(float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  float fCos = cosf(fAngRad);
+  float fSin = sinf(fAngRad);
+
+  glm::mat3 theMat(1.0f);
+  theMat[1].y = fCos;
+  theMat[2].y = -fSin;
+  theMat[1].z = fSin;
+  theMat[2].z = fCos;
+  return theMat;
+}
+
+inline glm::mat3 RotateY(float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  float fCos = cosf(fAngRad);
+  float fSin = sinf(fAngRad);
+
+  glm::mat3 theMat(1.0f);
+  theMat[0].x = fCos;
+  theMat[2].x = fSin;
+  theMat[0].z = -fSin;
+  theMat[2].z = fCos;
+  return theMat;
+}
+
+inline glm::mat3 RotateZ(float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  float fCos = cosf(fAngRad);
+  float fSin = sinf(fAngRad);
+
+  glm::mat3 theMat(1.0f);
+  theMat[0].x = fCos;
+  theMat[1].x = -fSin;
+  theMat[0].y = fSin;
+  theMat[1].y = fCos;
+  return theMat;
+}
+
+// In-place right-multiplication by the basic transforms. Each one only
+// rewrites the columns the transform actually touches, instead of building a
+// full 4x4 matrix and doing a 64-multiply product. They work on both glm::mat4
+// and the affine glm::mat4x3, so both matrix stacks share the SSE path.
+
+#ifdef USE_SSE_MATRIX_KERNELS
+inline __m128 LoadColumn(const glm::vec4 &col) { return _mm_loadu_ps(&col.x); }
+
+inline void StoreColumn(glm::vec4 &col, __m128 value) {
+  _mm_storeu_ps(&col.x, value);
+}
+
+// A mat4x3's columns are packed back to back, so a four-float access would
+// spill into the next column, or past the end of the matrix for the last one.
+// These only touch the column's own three floats; the fourth lane is zero.
+inline __m128 LoadColumn(const glm::vec3 &col) {
+  __m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)&col.x);
+  return _mm_movelh_ps(xy, _mm_load_ss(&col.z));
+}
+
+inline void StoreColumn(glm::vec3 &col, __m128 value) {
+  _mm_storel_pi((__m64 *)&col.x, value);
+  _mm_store_ss(&col.z, _mm_movehl_ps(value, value));
+}
+#endif
+
+// colA = colA * cos + colB * sin, colB = colB * cos - colA * sin
+template <typename Column>
+inline void RotateColumns(Column &colA, Column &colB, float fCos, float fSin) {
+#ifdef USE_SSE_MATRIX_KERNELS
+  __m128 a = LoadColumn(colA);
+  __m128 b = LoadColumn(colB);
+  __m128 c = _mm_set1_ps(fCos);
+  __m128 s = _mm_set1_ps(fSin);
+
+  StoreColumn(colA, _mm_add_ps(_mm_mul_ps(a, c), _mm_mul_ps(b, s)));
+  StoreColumn(colB, _mm_sub_ps(_mm_mul_ps(b, c), _mm_mul_ps(a, s)));
+#else
+  Column a = colA;
+  colA = a * fCos + colB * fSin;
+  colB = colB * fCos - a * fSin;
+#endif
+}
+
+template <typename Matrix> void ApplyRotateX(Matrix &theMat, float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  RotateColumns(theMat[1], theMat[2], cosf(fAngRad), sinf(fAngRad));
+}
+
+template <typename Matrix> void ApplyRotateY(Matrix &theMat, float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  RotateColumns(theMat[2], theMat[0], cosf(fAngRad), sinf(fAngRad));
+}
+
+template <typename Matrix> void ApplyRotateZ(Matrix &theMat, float fAngDeg) {
+  float fAngRad = DegToRad(fAngDeg);
+  RotateColumns(theMat[0], theMat[1], cosf(fAngRad), sinf(fAngRad));
+}
+
+template <typename Matrix>
+void ApplyScale(Matrix &theMat, const glm::vec3 &scaleVec) {
+#ifdef USE_SSE_MATRIX_KERNELS
+  StoreColumn(theMat[0], _mm_mul_ps(LoadColumn(theMat[0]),
+                                    _mm_set1_ps(scaleVec.x)));
+  StoreColumn(theMat[1], _mm_mul_ps(LoadColumn(theMat[1]),
+                                    _mm_set1_ps(scaleVec.y)));
+  StoreColumn(theMat[2], _mm_mul_ps(LoadColumn(theMat[2]),
+                                    _mm_set1_ps(scaleVec.z)));
+#else
+  theMat[0] *= scaleVec.x;
+  theMat[1] *= scaleVec.y;
+  theMat[2] *= scaleVec.z;
+#endif
+}
+
+// Only the last column changes: c3 += c0 * x + c1 * y + c2 * z
+template <typename Matrix>
+void ApplyTranslate(Matrix &theMat, const glm::vec3 &offsetVec) {
+#ifdef USE_SSE_MATRIX_KERNELS
+  __m128 sum = LoadColumn(theMat[3]);
+  sum = _mm_add_ps(sum, _mm_mul_ps(LoadColumn(theMat[0]),
+                                   _mm_set1_ps(offsetVec.x)));
+  sum = _mm_add_ps(sum, _mm_mul_ps(LoadColumn(theMat[1]),
+                                   _mm_set1_ps(offsetVec.y)));
+  sum = _mm_add_ps(sum, _mm_mul_ps(LoadColumn(theMat[2]),
+                                   _mm_set1_ps(offsetVec.z)));
+  StoreColumn(theMat[3], sum);
+#else
+  theMat[3] += theMat[0] * offsetVec.x + theMat[1] * offsetVec.y +
+               theMat[2] * offsetVec.z;
+#endif
+}
+
+// Matrix stack on full mat4s, using the in-place kernels above. This is the one
+// to draw with: the Hierarchy Benchmark measures it faster per node than the
+// affine stack below, whose 3-float columns cost extra loads and whose Top()
+// must be widened to a mat4 for every upload.
+class MatrixStack {
+public:
+  MatrixStack() : m_currMat(1.0f) {}
+
+  const glm::mat4 &Top() const { return m_currMat; }
+
+  void RotateX(float fAngDeg) { ApplyRotateX(m_currMat, fAngDeg); }
+
+  void RotateY(float fAngDeg) { ApplyRotateY(m_currMat, fAngDeg); }
+
+  void RotateZ(float fAngDeg) { ApplyRotateZ(m_currMat, fAngDeg); }
+
+  void Scale(const glm::vec3 &scaleVec) { ApplyScale(m_currMat, scaleVec); }
+
+  void Translate(const glm::vec3 &offsetVec) {
+    ApplyTranslate(m_currMat, offsetVec);
+  }
+
+  void Push() { m_matrices.push(m_currMat); }
+
+  void Pop() {
+    m_currMat = m_matrices.top();
+    m_matrices.pop();
+  }
+
+private:
+  glm::mat4 m_currMat;
+  std::stack<glm::mat4> m_matrices;
+};
+
+// Matrix stack for affine transforms only. The bottom row of an affine
+// matrix is always (0, 0, 0, 1), so it is not stored: each level is a 3x4
+// matrix, a quarter smaller than a mat4, and composing two of them takes 36
+// multiplies instead of 64. Nothing here ever makes a projective matrix; a
+// projection is only applied on the way out, by TopWithProjection().
+//
+// Use it where the 3x4 itself is wanted, or for its inverse. Top() and
+// TopWithProjection() build a mat4 on every call, so per-node drawing is
+// better done with MatrixStack.
+class AffineMatrixStack {
+public:
+  AffineMatrixStack() : m_currMat(1.0f) {}
+
+  const glm::mat4x3 &TopAffine() const { return m_currMat; }
+
+  glm::mat4 Top() const {
+    return glm::mat4(glm::vec4(m_currMat[0], 0.0f),
+                     glm::vec4(m_currMat[1], 0.0f),
+                     glm::vec4(m_currMat[2], 0.0f),
+                     glm::vec4(m_currMat[3], 1.0f));
+  }
+
+  // Promotes to 4x4 by applying the projection: projMat * Top(), without
+  // building Top(). Each of its columns is a combination of projMat's
+  // first three columns, plus projMat's last one for the translation.
+  glm::mat4 TopWithProjection(const glm::mat4 &projMat) const {
+    glm::mat4 result;
+    for (int col = 0; col < 4; ++col) {
+      result[col] = projMat[0] * m_currMat[col].x +
+                    projMat[1] * m_currMat[col].y +
+                    projMat[2] * m_currMat[col].z;
+    }
+
+    result[3] += projMat[3];
+    return result;
+  }
+
+  // Inverse of the upper 3x3 from its cofactors, then the translation is
+  // undone by that inverse. Far cheaper than a general 4x4 inverse.
+  glm::mat4x3 InverseTop() const {
+    const glm::vec3 &c0 = m_currMat[0];
+    const glm::vec3 &c1 = m_currMat[1];
+    const glm::vec3 &c2 = m_currMat[2];
+
+    glm::vec3 row0 = glm::cross(c1, c2);
+    glm::vec3 row1 = glm::cross(c2, c0);
+    glm::vec3 row2 = glm::cross(c0, c1);
+    float invDet = 1.0f / glm::dot(c0, row0);
+    row0 *= invDet;
+    row1 *= invDet;
+    row2 *= invDet;
+
+    glm::mat4x3 invMat;
+    invMat[0] = glm::vec3(row0.x, row1.x, row2.x);
+    invMat[1] = glm::vec3(row0.y, row1.y, row2.y);
+    invMat[2] = glm::vec3(row0.z, row1.z, row2.z);
+    invMat[3] = -glm::vec3(glm::dot(row0, m_currMat[3]),
+                           glm::dot(row1, m_currMat[3]),
+                           glm::dot(row2, m_currMat[3]));
+    return invMat;
+  }
+
+  void RotateX(float fAngDeg) { ApplyRotateX(m_currMat, fAngDeg); }
+
+  void RotateY(float fAngDeg) { ApplyRotateY(m_currMat, fAngDeg); }
+
+  void RotateZ(float fAngDeg) { ApplyRotateZ(m_currMat, fAngDeg); }
+
+  void Scale(const glm::vec3 &scaleVec) { ApplyScale(m_currMat, scaleVec); }
+
+  void Translate(const glm::vec3 &offsetVec) {
+    ApplyTranslate(m_currMat, offsetVec);
+  }
+
+  // Right-multiplies by another affine matrix: 27 multiplies for the 3x3
+  // part and 9 for the translation.
+  void ApplyMatrix(const glm::mat4x3 &theMatrix) {
+    glm::mat4x3 result;
+    for (int col = 0; col < 3; ++col) {
+      result[col] = m_currMat[0] * theMatrix[col].x +
+                    m_currMat[1] * theMatrix[col].y +
+                    m_currMat[2] * theMatrix[col].z;
+    }
+
+    result[3] = m_currMat[0] * theMatrix[3].x + m_currMat[1] * theMatrix[3].y +
+                m_currMat[2] * theMatrix[3].z + m_currMat[3];
+    m_currMat = result;
+  }
+
+  void Push() { m_matrices.push(m_currMat); }
+
+  void Pop() {
+    m_currMat = m_matrices.top();
+    m_matrices.pop();
+  }
+
+private:
+  glm::mat4x3 m_currMat;
+  std::stack<glm::mat4x3> m_matrices;
+};
+
+#endif // MATRIX_KERNELS_H
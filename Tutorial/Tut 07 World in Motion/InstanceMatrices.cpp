@@ -0,0 +1,143 @@
+//This file is licensed under the MIT License.
+
+
+#include <math.h>
+#include "InstanceMatrices.h"
+#include "../framework/framework.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define USE_SSE_INSTANCE_MATRICES
+#include <xmmintrin.h>
+#endif
+
+void InstanceTransforms::Add( const glm::vec3 &position, float angleYDeg, const glm::vec3 &scale )
+{
+	float angRad = Framework::DegToRad(angleYDeg);
+
+	m_posX.push_back(position.x);
+	m_posY.push_back(position.y);
+	m_posZ.push_back(position.z);
+
+	m_cosY.push_back(cosf(angRad));
+	m_sinY.push_back(sinf(angRad));
+
+	m_scaleX.push_back(scale.x);
+	m_scaleY.push_back(scale.y);
+	m_scaleZ.push_back(scale.z);
+}
+
+void InstanceTransforms::Clear()
+{
+	m_posX.clear();
+	m_posY.clear();
+	m_posZ.clear();
+	m_cosY.clear();
+	m_sinY.clear();
+	m_scaleX.clear();
+	m_scaleY.clear();
+	m_scaleZ.clear();
+}
+
+#ifdef USE_SSE_INSTANCE_MATRICES
+//Each register holds one row of one column for four instances. Transposing turns them
+//into that column for each of the four instances.
+static void StoreColumn(glm::mat4 *pOut, int column,
+	__m128 row0, __m128 row1, __m128 row2, __m128 row3)
+{
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+	_mm_storeu_ps(&pOut[0][column].x, row0);
+	_mm_storeu_ps(&pOut[1][column].x, row1);
+	_mm_storeu_ps(&pOut[2][column].x, row2);
+	_mm_storeu_ps(&pOut[3][column].x, row3);
+}
+
+static __m128 MulAdd(float parent, __m128 value, __m128 sum)
+{
+	return _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(parent), value));
+}
+#endif
+
+//Translate * RotateY * Scale only has seven interesting values, so each column of the
+//result is a short combination of the parent's columns:
+//	col0 = P0 * (cos * sx) - P2 * (sin * sx)
+//	col1 = P1 * sy
+//	col2 = P0 * (sin * sz) + P2 * (cos * sz)
+//	col3 = P0 * tx + P1 * ty + P2 * tz + P3
+void CalcInstanceMatrices( const glm::mat4 &parentMatrix,
+	const InstanceTransforms &instances, std::vector<glm::mat4> &outMatrices )
+{
+	size_t numInstances = instances.Size();
+	outMatrices.resize(numInstances);
+	if(numInstances == 0)
+		return;
+
+	const float *posX = &instances.m_posX[0];
+	const float *posY = &instances.m_posY[0];
+	const float *posZ = &instances.m_posZ[0];
+	const float *cosY = &instances.m_cosY[0];
+	const float *sinY = &instances.m_sinY[0];
+	const float *scaleX = &instances.m_scaleX[0];
+	const float *scaleY = &instances.m_scaleY[0];
+	const float *scaleZ = &instances.m_scaleZ[0];
+
+	size_t ix = 0;
+
+#ifdef USE_SSE_INSTANCE_MATRICES
+	const glm::mat4 &P = parentMatrix;
+	const __m128 zero = _mm_setzero_ps();
+
+	for(; ix + 4 <= numInstances; ix += 4)
+	{
+		__m128 sx = _mm_loadu_ps(scaleX + ix);
+		__m128 sz = _mm_loadu_ps(scaleZ + ix);
+		__m128 c = _mm_loadu_ps(cosY + ix);
+		__m128 s = _mm_loadu_ps(sinY + ix);
+
+		__m128 col0A = _mm_mul_ps(c, sx);
+		__m128 col0B = _mm_sub_ps(zero, _mm_mul_ps(s, sx));
+		__m128 col2A = _mm_mul_ps(s, sz);
+		__m128 col2B = _mm_mul_ps(c, sz);
+		__m128 sy = _mm_loadu_ps(scaleY + ix);
+		__m128 tx = _mm_loadu_ps(posX + ix);
+		__m128 ty = _mm_loadu_ps(posY + ix);
+		__m128 tz = _mm_loadu_ps(posZ + ix);
+
+		glm::mat4 *pOut = &outMatrices[ix];
+
+		StoreColumn(pOut, 0,
+			MulAdd(P[2].x, col0B, _mm_mul_ps(_mm_set1_ps(P[0].x), col0A)),
+			MulAdd(P[2].y, col0B, _mm_mul_ps(_mm_set1_ps(P[0].y), col0A)),
+			MulAdd(P[2].z, col0B, _mm_mul_ps(_mm_set1_ps(P[0].z), col0A)),
+			MulAdd(P[2].w, col0B, _mm_mul_ps(_mm_set1_ps(P[0].w), col0A)));
+
+		StoreColumn(pOut, 1,
+			_mm_mul_ps(_mm_set1_ps(P[1].x), sy),
+			_mm_mul_ps(_mm_set1_ps(P[1].y), sy),
+			_mm_mul_ps(_mm_set1_ps(P[1].z), sy),
+			_mm_mul_ps(_mm_set1_ps(P[1].w), sy));
+
+		StoreColumn(pOut, 2,
+			MulAdd(P[2].x, col2B, _mm_mul_ps(_mm_set1_ps(P[0].x), col2A)),
+			MulAdd(P[2].y, col2B, _mm_mul_ps(_mm_set1_ps(P[0].y), col2A)),
+			MulAdd(P[2].z, col2B, _mm_mul_ps(_mm_set1_ps(P[0].z), col2A)),
+			MulAdd(P[2].w, col2B, _mm_mul_ps(_mm_set1_ps(P[0].w), col2A)));
+
+		StoreColumn(pOut, 3,
+			MulAdd(P[2].x, tz, MulAdd(P[1].x, ty, MulAdd(P[0].x, tx, _mm_set1_ps(P[3].x)))),
+			MulAdd(P[2].y, tz, MulAdd(P[1].y, ty, MulAdd(P[0].y, tx, _mm_set1_ps(P[3].y)))),
+			MulAdd(P[2].z, tz, MulAdd(P[1].z, ty, MulAdd(P[0].z, tx, _mm_set1_ps(P[3].z)))),
+			MulAdd(P[2].w, tz, MulAdd(P[1].w, ty, MulAdd(P[0].w, tx, _mm_set1_ps(P[3].w)))));
+	}
+#endif
+
+	//Whatever is left over, or everything when SSE is not available.
+	for(; ix < numInstances; ++ix)
+	{
+		glm::mat4 &outMatrix = outMatrices[ix];
+		outMatrix[0] = parentMatrix[0] * (cosY[ix] * scaleX[ix]) - parentMatrix[2] * (sinY[ix] * scaleX[ix]);
+		outMatrix[1] = parentMatrix[1] * scaleY[ix];
+		outMatrix[2] = parentMatrix[0] * (sinY[ix] * scaleZ[ix]) + parentMatrix[2] * (cosY[ix] * scaleZ[ix]);
+		outMatrix[3] = parentMatrix[0] * posX[ix] + parentMatrix[1] * posY[ix] +
+			parentMatrix[2] * posZ[ix] + parentMatrix[3];
+	}
+}
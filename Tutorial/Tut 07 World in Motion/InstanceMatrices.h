@@ -0,0 +1,43 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef INSTANCE_MATRICES_H
+#define INSTANCE_MATRICES_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+//Per-instance transforms for many copies of the same object. Each instance's matrix is
+//	parentMatrix * Translate(position) * RotateY(angle) * Scale(scale)
+//The values are kept in separate arrays, one per component, so that
+//CalcInstanceMatrices can work on four instances at a time.
+class InstanceTransforms
+{
+public:
+	void Add(const glm::vec3 &position, float angleYDeg, const glm::vec3 &scale);
+	void Clear();
+
+	size_t Size() const {return m_posX.size();}
+
+private:
+	std::vector<float> m_posX;
+	std::vector<float> m_posY;
+	std::vector<float> m_posZ;
+
+	//The sine and cosine are computed once in Add(), not every frame.
+	std::vector<float> m_cosY;
+	std::vector<float> m_sinY;
+
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+
+	friend void CalcInstanceMatrices(const glm::mat4 &parentMatrix,
+		const InstanceTransforms &instances, std::vector<glm::mat4> &outMatrices);
+};
+
+//Writes one matrix per instance to outMatrices, which is resized to fit.
+void CalcInstanceMatrices(const glm::mat4 &parentMatrix,
+	const InstanceTransforms &instances, std::vector<glm::mat4> &outMatrices);
+
+#endif //INSTANCE_MATRICES_H
@@ -0,0 +1,105 @@
+//This file is licensed under the MIT License.
+
+
+#include <algorithm>
+#include <string.h>
+#include "MeshBatcher.h"
+#include "../framework/PackedMesh.h"
+
+MeshBatcher::MeshBatcher( GLuint bindingIndex )
+	: m_buffer(0)
+	, m_bindingIndex(bindingIndex)
+	, m_alignment(1)
+{
+	//Every run's range has to start on an offset glBindBufferRange accepts.
+	GLint alignment = 1;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if(alignment > 1)
+		m_alignment = alignment;
+
+	glGenBuffers(1, &m_buffer);
+}
+
+MeshBatcher::~MeshBatcher()
+{
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void MeshBatcher::Add( const Framework::PackedMesh *pMesh, const glm::mat4 &matrix, const glm::vec4 &color )
+{
+	//Scenes only batch a handful of meshes.
+	size_t iBatch = 0;
+	for(; iBatch < m_batches.size(); iBatch++)
+	{
+		if(m_batches[iBatch].pMesh == pMesh)
+			break;
+	}
+
+	if(iBatch == m_batches.size())
+	{
+		m_batches.push_back(Batch());
+		m_batches.back().pMesh = pMesh;
+	}
+
+	Instance instance = {matrix, color};
+	m_batches[iBatch].instances.push_back(instance);
+}
+
+int MeshBatcher::Flush()
+{
+	//The bound range always covers the shaders' whole array, even for a shorter run.
+	const GLsizeiptr blockSize = MAX_INSTANCES_PER_DRAW * sizeof(Instance);
+
+	//Lay out each mesh's copies in runs of at most MAX_INSTANCES_PER_DRAW, each run starting
+	//on an aligned offset.
+	m_draws.clear();
+	GLintptr endOffset = 0;
+	for(size_t iBatch = 0; iBatch < m_batches.size(); iBatch++)
+	{
+		const Batch &batch = m_batches[iBatch];
+		for(size_t iFirst = 0; iFirst < batch.instances.size(); iFirst += MAX_INSTANCES_PER_DRAW)
+		{
+			Draw draw;
+			draw.pMesh = batch.pMesh;
+			draw.offset = ((endOffset + m_alignment - 1) / m_alignment) * m_alignment;
+			draw.numInstances = (GLsizei)std::min(batch.instances.size() - iFirst,
+				(size_t)MAX_INSTANCES_PER_DRAW);
+			m_draws.push_back(draw);
+
+			endOffset = draw.offset + draw.numInstances * sizeof(Instance);
+		}
+	}
+
+	if(m_draws.empty())
+		return 0;
+
+	m_staging.resize(m_draws.back().offset + blockSize);
+	size_t iDraw = 0;
+	for(size_t iBatch = 0; iBatch < m_batches.size(); iBatch++)
+	{
+		const std::vector<Instance> &instances = m_batches[iBatch].instances;
+		for(size_t iFirst = 0; iFirst < instances.size(); iFirst += MAX_INSTANCES_PER_DRAW, iDraw++)
+		{
+			memcpy(&m_staging[m_draws[iDraw].offset], &instances[iFirst],
+				m_draws[iDraw].numInstances * sizeof(Instance));
+		}
+	}
+
+	//Respecifying the whole buffer lets the driver hand out fresh storage, rather than wait
+	//for last frame's draws to finish reading it.
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, m_staging.size(), &m_staging[0], GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	for(iDraw = 0; iDraw < m_draws.size(); iDraw++)
+	{
+		const Draw &draw = m_draws[iDraw];
+		glBindBufferRange(GL_UNIFORM_BUFFER, m_bindingIndex, m_buffer, draw.offset, blockSize);
+		draw.pMesh->RenderInstanced(draw.numInstances);
+	}
+
+	for(size_t iBatch = 0; iBatch < m_batches.size(); iBatch++)
+		m_batches[iBatch].instances.clear();
+
+	return (int)m_draws.size();
+}
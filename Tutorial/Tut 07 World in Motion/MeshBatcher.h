@@ -0,0 +1,86 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef MESH_BATCHER_H
+#define MESH_BATCHER_H
+
+#include <vector>
+#include <glload/gl_3_3.h>
+#include <glm/glm.hpp>
+
+namespace Framework
+{
+	class PackedMesh;
+}
+
+//Collects copies of Framework::PackedMesh objects, each with its own matrix and color, and
+//draws them all in Flush(). Every copy's data goes up in one buffer upload. Each mesh is then
+//drawn with PackedMesh::RenderInstanced, up to MAX_INSTANCES_PER_DRAW copies at a time, with
+//that run of copies bound to the InstanceBlock uniform block:
+//
+//	struct Instance
+//	{
+//		mat4 <matrix>;
+//		vec4 <color>;
+//	};
+//
+//	layout(std140) uniform InstanceBlock
+//	{
+//		Instance instances[MAX_INSTANCES_PER_DRAW];
+//	};
+//
+//The shader reads its copy's data from instances[gl_InstanceID].
+class MeshBatcher
+{
+public:
+	//The most instances a 16384 byte uniform block holds, the smallest
+	//GL_MAX_UNIFORM_BLOCK_SIZE OpenGL allows. The shaders' arrays must have this size.
+	enum {MAX_INSTANCES_PER_DRAW = 204};
+
+	//Must be made after OpenGL is initialized.
+	explicit MeshBatcher(GLuint bindingIndex);
+	~MeshBatcher();
+
+	//The mesh must still be alive at the next Flush().
+	void Add(const Framework::PackedMesh *pMesh, const glm::mat4 &matrix, const glm::vec4 &color);
+
+	//Uploads the copies, renders them grouped by mesh and forgets them. The caller must have
+	//a program with the InstanceBlock bound to bindingIndex in use. Returns the number of
+	//RenderInstanced() calls, which is also the number of buffer range binds.
+	int Flush();
+
+private:
+	//Matches the std140 layout of InstanceBlock's array elements.
+	struct Instance
+	{
+		glm::mat4 matrix;
+		glm::vec4 color;
+	};
+
+	struct Batch
+	{
+		const Framework::PackedMesh *pMesh;
+		std::vector<Instance> instances;
+	};
+
+	//One RenderInstanced() call: its copies start at offset in the buffer.
+	struct Draw
+	{
+		const Framework::PackedMesh *pMesh;
+		GLintptr offset;
+		GLsizei numInstances;
+	};
+
+	GLuint m_buffer;
+	GLuint m_bindingIndex;
+	GLintptr m_alignment;
+	std::vector<Batch> m_batches;
+	std::vector<Draw> m_draws;
+	std::vector<char> m_staging;
+
+	//Buffer objects can't be copied.
+	MeshBatcher(const MeshBatcher &);
+	MeshBatcher &operator=(const MeshBatcher &);
+};
+
+#endif //MESH_BATCHER_H
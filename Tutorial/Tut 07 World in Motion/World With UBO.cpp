@@ -11,7 +11,9 @@
 #include <glutil/glutil.h>
 #include <GL/freeglut.h>
 #include "../framework/framework.h"
-#include "../framework/Mesh.h"
+#include "../framework/PackedMesh.h"
+#include "InstanceMatrices.h"
+#include "MeshBatcher.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -32,10 +34,12 @@ float g_fzFar = 1000.0f;
 ProgramData UniformColor;
 ProgramData ObjectColor;
 ProgramData UniformColorTint;
+ProgramData BatchedColorTint;
 
 GLuint g_GlobalMatricesUBO;
 
 static const int g_iGlobalMatricesBindingIndex = 0;
+static const int g_iInstanceBindingIndex = 1;
 
 ProgramData LoadProgram(const std::string &strVertexShader, const std::string &strFragmentShader)
 {
@@ -60,6 +64,10 @@ void InitializeProgram()
 	UniformColor = LoadProgram("PosOnlyWorldTransformUBO.vert", "ColorUniform.frag");
 	ObjectColor = LoadProgram("PosColorWorldTransformUBO.vert", "ColorPassthrough.frag");
 	UniformColorTint = LoadProgram("PosColorWorldTransformUBO.vert", "ColorMultUniform.frag");
+	BatchedColorTint = LoadProgram("PosColorBatchedUBO.vert", "ColorPassthrough.frag");
+
+	GLuint instanceBlockIndex = glGetUniformBlockIndex(BatchedColorTint.theProgram, "InstanceBlock");
+	glUniformBlockBinding(BatchedColorTint.theProgram, instanceBlockIndex, g_iInstanceBindingIndex);
 
 	glGenBuffers(1, &g_GlobalMatricesUBO);
 	glBindBuffer(GL_UNIFORM_BUFFER, g_GlobalMatricesUBO);
@@ -91,11 +99,30 @@ glm::mat4 CalcLookAtMatrix(const glm::vec3 &cameraPt, const glm::vec3 &lookPt, c
 	return rotMat * transMat;
 }
 
-Framework::Mesh *g_pConeMesh = NULL;
-Framework::Mesh *g_pCylinderMesh = NULL;
-Framework::Mesh *g_pCubeTintMesh = NULL;
-Framework::Mesh *g_pCubeColorMesh = NULL;
-Framework::Mesh *g_pPlaneMesh = NULL;
+Framework::PackedMesh *g_pConeMesh = NULL;
+Framework::PackedMesh *g_pCylinderMesh = NULL;
+Framework::PackedMesh *g_pCubeTintMesh = NULL;
+Framework::PackedMesh *g_pCubeColorMesh = NULL;
+Framework::PackedMesh *g_pPlaneMesh = NULL;
+
+//In batched mode, objects drawn with UniformColorTint are added to this and drawn all at once
+//with BatchedColorTint at the end of the scene.
+MeshBatcher *g_pBatcher = NULL;
+
+static bool g_bBatched = false;
+
+//One Render() or RenderInstanced() counts as one draw call, however many primitives or copies
+//it draws.
+struct FrameStats
+{
+	int numDrawCalls;
+	int numUniformUploads;
+	int numBufferUploads;
+	int numBufferBinds;
+};
+
+static FrameStats g_frameStats;
+static FrameStats g_lastFrameStats;
 
 //Called after the window and OpenGL are initialized. Called exactly once, before the main loop.
 void init()
@@ -104,11 +131,11 @@ void init()
 
 	try
 	{
-		g_pConeMesh = new Framework::Mesh("UnitConeTint.xml");
-		g_pCylinderMesh = new Framework::Mesh("UnitCylinderTint.xml");
-		g_pCubeTintMesh = new Framework::Mesh("UnitCubeTint.xml");
-		g_pCubeColorMesh = new Framework::Mesh("UnitCubeColor.xml");
-		g_pPlaneMesh = new Framework::Mesh("UnitPlane.xml");
+		g_pConeMesh = new Framework::PackedMesh("UnitConeTint.xml");
+		g_pCylinderMesh = new Framework::PackedMesh("UnitCylinderTint.xml");
+		g_pCubeTintMesh = new Framework::PackedMesh("UnitCubeTint.xml");
+		g_pCubeColorMesh = new Framework::PackedMesh("UnitCubeColor.xml");
+		g_pPlaneMesh = new Framework::PackedMesh("UnitPlane.xml");
 	}
 	catch(std::exception &except)
 	{
@@ -116,6 +143,8 @@ void init()
 		throw;
 	}
 
+	g_pBatcher = new MeshBatcher(g_iInstanceBindingIndex);
+
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CW);
@@ -130,36 +159,35 @@ void init()
 static float g_fYAngle = 0.0f;
 static float g_fXAngle = 0.0f;
 
-//Trees are 3x3 in X/Z, and fTrunkHeight+fConeHeight in the Y.
-void DrawTree(glutil::MatrixStack &modelMatrix, float fTrunkHeight = 2.0f, float fConeHeight = 3.0f)
+//Draws the mesh with the UniformColorTint program, or in batched mode adds it to the batcher.
+void DrawTinted(Framework::PackedMesh *pMesh, const glm::mat4 &modelToWorldMatrix, const glm::vec4 &color)
 {
-	//Draw trunk.
+	if(g_bBatched)
 	{
-		glutil::PushStack push(modelMatrix);
-
-		modelMatrix.Scale(glm::vec3(1.0f, fTrunkHeight, 1.0f));
-		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
-
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.694f, 0.4f, 0.106f, 1.0f);
-		g_pCylinderMesh->Render();
-		glUseProgram(0);
+		g_pBatcher->Add(pMesh, modelToWorldMatrix, color);
+		return;
 	}
 
-	//Draw the treetop
-	{
-		glutil::PushStack push(modelMatrix);
+	glUseProgram(UniformColorTint.theProgram);
+	glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelToWorldMatrix));
+	glUniform4fv(UniformColorTint.baseColorUnif, 1, glm::value_ptr(color));
+	pMesh->Render();
+	glUseProgram(0);
 
-		modelMatrix.Translate(glm::vec3(0.0f, fTrunkHeight, 0.0f));
-		modelMatrix.Scale(glm::vec3(3.0f, fConeHeight, 3.0f));
+	g_frameStats.numUniformUploads += 2;
+	g_frameStats.numDrawCalls++;
+}
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.0f, 1.0f, 0.0f, 1.0f);
-		g_pConeMesh->Render();
-		glUseProgram(0);
-	}
+void FlushBatches()
+{
+	glUseProgram(BatchedColorTint.theProgram);
+	int numDraws = g_pBatcher->Flush();
+	glUseProgram(0);
+
+	if(numDraws > 0)
+		g_frameStats.numBufferUploads++;
+	g_frameStats.numBufferBinds += numDraws;
+	g_frameStats.numDrawCalls += numDraws;
 }
 
 const float g_fColumnBaseHeight = 0.25f;
@@ -174,11 +202,8 @@ void DrawColumn(glutil::MatrixStack &modelMatrix, float fHeight = 5.0f)
 		modelMatrix.Scale(glm::vec3(1.0f, g_fColumnBaseHeight, 1.0f));
 		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 1.0f, 1.0f, 1.0f, 1.0f);
-		g_pCubeTintMesh->Render();
-		glUseProgram(0);
+		DrawTinted(g_pCubeTintMesh, modelMatrix.Top(),
+			glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
 	}
 
 	//Draw the top of the column.
@@ -189,11 +214,8 @@ void DrawColumn(glutil::MatrixStack &modelMatrix, float fHeight = 5.0f)
 		modelMatrix.Scale(glm::vec3(1.0f, g_fColumnBaseHeight, 1.0f));
 		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.9f, 0.9f, 0.9f, 0.9f);
-		g_pCubeTintMesh->Render();
-		glUseProgram(0);
+		DrawTinted(g_pCubeTintMesh, modelMatrix.Top(),
+			glm::vec4(0.9f, 0.9f, 0.9f, 0.9f));
 	}
 
 	//Draw the main column.
@@ -204,11 +226,8 @@ void DrawColumn(glutil::MatrixStack &modelMatrix, float fHeight = 5.0f)
 		modelMatrix.Scale(glm::vec3(0.8f, fHeight - (g_fColumnBaseHeight * 2.0f), 0.8f));
 		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.9f, 0.9f, 0.9f, 0.9f);
-		g_pCylinderMesh->Render();
-		glUseProgram(0);
+		DrawTinted(g_pCylinderMesh, modelMatrix.Top(),
+			glm::vec4(0.9f, 0.9f, 0.9f, 0.9f));
 	}
 }
 
@@ -227,11 +246,8 @@ void DrawParthenon(glutil::MatrixStack &modelMatrix)
 		modelMatrix.Scale(glm::vec3(g_fParthenonWidth, g_fParthenonBaseHeight, g_fParthenonLength));
 		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.9f, 0.9f, 0.9f, 0.9f);
-		g_pCubeTintMesh->Render();
-		glUseProgram(0);
+		DrawTinted(g_pCubeTintMesh, modelMatrix.Top(),
+			glm::vec4(0.9f, 0.9f, 0.9f, 0.9f));
 	}
 
 	//Draw top.
@@ -242,11 +258,8 @@ void DrawParthenon(glutil::MatrixStack &modelMatrix)
 		modelMatrix.Scale(glm::vec3(g_fParthenonWidth, g_fParthenonTopHeight, g_fParthenonLength));
 		modelMatrix.Translate(glm::vec3(0.0f, 0.5f, 0.0f));
 
-		glUseProgram(UniformColorTint.theProgram);
-		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
-		glUniform4f(UniformColorTint.baseColorUnif, 0.9f, 0.9f, 0.9f, 0.9f);
-		g_pCubeTintMesh->Render();
-		glUseProgram(0);
+		DrawTinted(g_pCubeTintMesh, modelMatrix.Top(),
+			glm::vec4(0.9f, 0.9f, 0.9f, 0.9f));
 	}
 
 	//Draw columns.
@@ -303,6 +316,9 @@ void DrawParthenon(glutil::MatrixStack &modelMatrix)
 		glUniformMatrix4fv(ObjectColor.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
 		g_pCubeColorMesh->Render();
 		glUseProgram(0);
+
+		g_frameStats.numUniformUploads++;
+		g_frameStats.numDrawCalls++;
 	}
 
 	//Draw headpiece.
@@ -320,6 +336,9 @@ void DrawParthenon(glutil::MatrixStack &modelMatrix)
 		glUniformMatrix4fv(ObjectColor.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(modelMatrix.Top()));
 		g_pCubeColorMesh->Render();
 		glUseProgram(0);
+
+		g_frameStats.numUniformUploads++;
+		g_frameStats.numDrawCalls++;
 	}
 }
 
@@ -439,16 +458,77 @@ static const TreeData g_forest[] =
 	{25.0f, 45.0f, 2.0f, 3.0f},
 };
 
-void DrawForest(glutil::MatrixStack &modelMatrix)
+//Trees are 3x3 in X/Z, and fTrunkHeight+fConeHeight in the Y.
+//The trunk and treetop of every tree, relative to the forest. The forest never changes,
+//so these are only built once.
+InstanceTransforms g_trunkInstances;
+InstanceTransforms g_treetopInstances;
+std::vector<glm::mat4> g_forestMatrices;
+
+void BuildForestInstances()
 {
 	for(int iTree = 0; iTree < ARRAY_COUNT(g_forest); iTree++)
 	{
 		const TreeData &currTree = g_forest[iTree];
 
-		glutil::PushStack push(modelMatrix);
-		modelMatrix.Translate(glm::vec3(currTree.fXPos, 0.0f, currTree.fZPos));
-		DrawTree(modelMatrix, currTree.fTrunkHeight, currTree.fConeHeight);
+		//Translate(x, 0, z) * Scale(1, trunk, 1) * Translate(0, 0.5, 0)
+		g_trunkInstances.Add(
+			glm::vec3(currTree.fXPos, currTree.fTrunkHeight * 0.5f, currTree.fZPos), 0.0f,
+			glm::vec3(1.0f, currTree.fTrunkHeight, 1.0f));
+
+		//Translate(x, 0, z) * Translate(0, trunk, 0) * Scale(3, cone, 3)
+		g_treetopInstances.Add(
+			glm::vec3(currTree.fXPos, currTree.fTrunkHeight, currTree.fZPos), 0.0f,
+			glm::vec3(3.0f, currTree.fConeHeight, 3.0f));
+	}
+}
+
+void DrawForest(glutil::MatrixStack &modelMatrix)
+{
+	if(g_trunkInstances.Size() == 0)
+		BuildForestInstances();
+
+	const glm::mat4 forestMatrix = modelMatrix.Top();
+	const glm::vec4 trunkColor(0.694f, 0.4f, 0.106f, 1.0f);
+	const glm::vec4 treetopColor(0.0f, 1.0f, 0.0f, 1.0f);
+
+	if(g_bBatched)
+	{
+		CalcInstanceMatrices(forestMatrix, g_trunkInstances, g_forestMatrices);
+		for(size_t iTree = 0; iTree < g_forestMatrices.size(); iTree++)
+			DrawTinted(g_pCylinderMesh, g_forestMatrices[iTree], trunkColor);
+
+		CalcInstanceMatrices(forestMatrix, g_treetopInstances, g_forestMatrices);
+		for(size_t iTree = 0; iTree < g_forestMatrices.size(); iTree++)
+			DrawTinted(g_pConeMesh, g_forestMatrices[iTree], treetopColor);
+
+		return;
+	}
+
+	//All the trunks, then all the treetops, so the program and color are set once each.
+	glUseProgram(UniformColorTint.theProgram);
+
+	CalcInstanceMatrices(forestMatrix, g_trunkInstances, g_forestMatrices);
+	glUniform4fv(UniformColorTint.baseColorUnif, 1, glm::value_ptr(trunkColor));
+	for(size_t iTree = 0; iTree < g_forestMatrices.size(); iTree++)
+	{
+		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(g_forestMatrices[iTree]));
+		g_pCylinderMesh->Render();
+	}
+	g_frameStats.numUniformUploads += 1 + int(g_forestMatrices.size());
+	g_frameStats.numDrawCalls += int(g_forestMatrices.size());
+
+	CalcInstanceMatrices(forestMatrix, g_treetopInstances, g_forestMatrices);
+	glUniform4fv(UniformColorTint.baseColorUnif, 1, glm::value_ptr(treetopColor));
+	for(size_t iTree = 0; iTree < g_forestMatrices.size(); iTree++)
+	{
+		glUniformMatrix4fv(UniformColorTint.modelToWorldMatrixUnif, 1, GL_FALSE, glm::value_ptr(g_forestMatrices[iTree]));
+		g_pConeMesh->Render();
 	}
+	g_frameStats.numUniformUploads += 1 + int(g_forestMatrices.size());
+	g_frameStats.numDrawCalls += int(g_forestMatrices.size());
+
+	glUseProgram(0);
 }
 
 static bool g_bDrawLookatPoint = false;
@@ -482,6 +562,8 @@ void display()
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	g_frameStats = FrameStats();
+
 	if(g_pConeMesh && g_pCylinderMesh && g_pCubeTintMesh && g_pCubeColorMesh && g_pPlaneMesh)
 	{
 		const glm::vec3 &camPos = ResolveCamPosition();
@@ -492,6 +574,7 @@ void display()
 		glBindBuffer(GL_UNIFORM_BUFFER, g_GlobalMatricesUBO);
 		glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(camMatrix.Top()));
 		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		g_frameStats.numBufferUploads++;
 
 		glutil::MatrixStack modelMatrix;
 
@@ -506,6 +589,9 @@ void display()
 			glUniform4f(UniformColor.baseColorUnif, 0.302f, 0.416f, 0.0589f, 1.0f);
 			g_pPlaneMesh->Render();
 			glUseProgram(0);
+
+			g_frameStats.numUniformUploads += 2;
+			g_frameStats.numDrawCalls++;
 		}
 
 		//Draw the trees
@@ -519,6 +605,9 @@ void display()
 			DrawParthenon(modelMatrix);
 		}
 
+		if(g_bBatched)
+			FlushBatches();
+
 		if(g_bDrawLookatPoint)
 		{
 			glDisable(GL_DEPTH_TEST);
@@ -533,9 +622,14 @@ void display()
 			g_pCubeColorMesh->Render();
 			glUseProgram(0);
 			glEnable(GL_DEPTH_TEST);
+
+			g_frameStats.numUniformUploads++;
+			g_frameStats.numDrawCalls++;
 		}
 	}
 
+	g_lastFrameStats = g_frameStats;
+
 	glutSwapBuffers();
 }
 
@@ -573,6 +667,8 @@ void keyboard(unsigned char key, int x, int y)
 		g_pCubeColorMesh = NULL;
 		delete g_pPlaneMesh;
 		g_pPlaneMesh = NULL;
+		delete g_pBatcher;
+		g_pBatcher = NULL;
 		glutLeaveMainLoop();
 		return;
 	case 'w': g_camTarget.z -= 4.0f; break;
@@ -605,6 +701,15 @@ void keyboard(unsigned char key, int x, int y)
 		printf("Target: %f, %f, %f\n", g_camTarget.x, g_camTarget.y, g_camTarget.z);
 		printf("Position: %f, %f, %f\n", g_sphereCamRelPos.x, g_sphereCamRelPos.y, g_sphereCamRelPos.z);
 		break;
+	case 'b':
+		g_bBatched = !g_bBatched;
+		printf("Batched drawing %s\n", g_bBatched ? "on" : "off");
+		break;
+	case 'n':
+		printf("Draw calls: %i, uniform uploads: %i, buffer uploads: %i, buffer binds: %i\n",
+			g_lastFrameStats.numDrawCalls, g_lastFrameStats.numUniformUploads,
+			g_lastFrameStats.numBufferUploads, g_lastFrameStats.numBufferBinds);
+		break;
 	}
 
 	g_sphereCamRelPos.y = glm::clamp(g_sphereCamRelPos.y, -78.75f, -1.0f);
@@ -0,0 +1,27 @@
+#version 330
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 color;
+
+smooth out vec4 interpColor;
+
+uniform mat4 cameraToClipMatrix;
+
+//MeshBatcher::MAX_INSTANCES_PER_DRAW copies, one per gl_InstanceID.
+struct Instance
+{
+	mat4 modelToCameraMatrix;
+	vec4 color;
+};
+
+layout(std140) uniform InstanceBlock
+{
+	Instance instances[204];
+};
+
+void main()
+{
+	vec4 temp = instances[gl_InstanceID].modelToCameraMatrix * position;
+	gl_Position = cameraToClipMatrix * temp;
+	interpColor = color * instances[gl_InstanceID].color;
+}
@@ -11,7 +11,9 @@
 // 	void MatrixStack::Rotate( const glm::vec3 axis, float angDegCCW )
 // 	{
 // 		m_currMatrix = glm::rotate(m_currMatrix, angDegCCW, axis);
-// 		m_currInverseMatrix = glm::rotate(m_currInverseMatrix, -angDegCCW, axis);
+// 		//inverse(M * R) = inverse(R) * inverse(M)
+// 		if(m_inverseValid)
+// 			m_currInverseMatrix = glm::rotate(glm::mat4(1.0f), -angDegCCW, axis) * m_currInverseMatrix;
 // 	}
 
 // 	void MatrixStack::RotateRadians( const glm::vec3 axisOfRotation, float angRadCCW )
@@ -36,6 +38,9 @@
 // 		theMat[1].z = axis.y * axis.z * (fInvCos) + (axis.x * fSin);
 // 		theMat[2].z = (axis.z * axis.z) + ((1 - axis.z * axis.z) * fCos);
 // 		m_currMatrix *= theMat;
+
+// 		if(!m_inverseValid)
+// 			return;
 		
 // 		fCos = cosf(-angRadCCW);
 // 		fInvCos = 1.0f - fCos;
@@ -54,7 +59,7 @@
 // 		theMat[0].z = axis.x * axis.z * (fInvCos) - (axis.y * fSin);
 // 		theMat[1].z = axis.y * axis.z * (fInvCos) + (axis.x * fSin);
 // 		theMat[2].z = (axis.z * axis.z) + ((1 - axis.z * axis.z) * fCos);
-// 		m_currInverseMatrix *= theMat;
+// 		m_currInverseMatrix = theMat * m_currInverseMatrix;
 // 	}
 
 // 	void MatrixStack::RotateX( float angDegCCW )
@@ -75,26 +80,28 @@
 // 	void MatrixStack::Scale( const glm::vec3 &scaleVec )
 // 	{
 // 		m_currMatrix = glm::scale(m_currMatrix, scaleVec);
-// 		m_currInverseMatrix = glm::scale(m_currInverseMatrix, glm::vec3(1.0f) / scaleVec);
+// 		if(m_inverseValid)
+// 			m_currInverseMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f) / scaleVec) * m_currInverseMatrix;
 // 	}
 
 // 	void MatrixStack::Translate( const glm::vec3 &offsetVec )
 // 	{
 // 		m_currMatrix = glm::translate(m_currMatrix, offsetVec);
-// 		m_currInverseMatrix = glm::translate(m_currInverseMatrix, -offsetVec);
+// 		if(m_inverseValid)
+// 			m_currInverseMatrix = glm::translate(glm::mat4(1.0f), -offsetVec) * m_currInverseMatrix;
 // 	}
 
 // 	void MatrixStack::Perspective( float degFOV, float aspectRatio, float zNear, float zFar )
 // 	{
 // 		m_currMatrix *= glm::perspective(degFOV, aspectRatio, zNear, zFar);
-// 		m_currInverseMatrix = glm::inverse(m_currMatrix); //If I'm going to use inverse on the input, might as well inverse the result to avoid a multiplication
+// 		m_inverseValid = false; //Computed by InverseTop() if anyone asks for it
 // 	}
 
 // 	void MatrixStack::Orthographic( float left, float right, float bottom, float top,
 // 		float zNear, float zFar )
 // 	{
 // 		m_currMatrix *= glm::ortho(left, right, bottom, top, zNear, zFar);
-// 		m_currInverseMatrix = glm::inverse(m_currMatrix); //If I'm going to use inverse on the input, might as well inverse the result to avoid a multiplication
+// 		m_inverseValid = false; //Computed by InverseTop() if anyone asks for it
 // 	}
 
 // 	void MatrixStack::PixelPerfectOrtho( glm::ivec2 size, glm::vec2 depthRange, bool isTopLeft /*= true*/ )
@@ -114,25 +121,26 @@
 // 	void MatrixStack::LookAt( const glm::vec3 &cameraPos, const glm::vec3 &lookatPos, const glm::vec3 &upDir )
 // 	{
 // 		m_currMatrix *= glm::lookAt(cameraPos, lookatPos, upDir);
-// 		m_currInverseMatrix = glm::inverse(m_currMatrix); //If I'm going to use inverse on the input, might as well inverse the result to avoid a multiplication
+// 		m_inverseValid = false; //Computed by InverseTop() if anyone asks for it
 // 	}
 
 // 	void MatrixStack::ApplyMatrix( const glm::mat4 &theMatrix )
 // 	{
 // 		m_currMatrix *= theMatrix;
-// 		m_currInverseMatrix = glm::inverse(m_currMatrix); //If I'm going to use inverse on the input, might as well inverse the result to avoid a multiplication
+// 		m_inverseValid = false; //Computed by InverseTop() if anyone asks for it
 // 	}
 
 // 	void MatrixStack::SetMatrix( const glm::mat4 &theMatrix )
 // 	{
 // 		m_currMatrix = theMatrix;
-// 		m_currInverseMatrix = glm::inverse(theMatrix);
+// 		m_inverseValid = false;
 // 	}
 
 // 	void MatrixStack::SetIdentity()
 // 	{
 // 		m_currMatrix = glm::mat4(1.0f);
 // 		m_currInverseMatrix = glm::mat4(1.0f);
+// 		m_inverseValid = true;
 // 	}
 // }
 
@@ -48,15 +48,13 @@
 // 	public:
 // 		///Initializes the matrix stack with the identity matrix.
 // 		MatrixStack()
-// 			: m_currMatrix(1) , m_currInverseMatrix(1)
+// 			: m_currMatrix(1) , m_currInverseMatrix(1), m_inverseValid(true)
 // 		{}
 
 // 		///Initializes the matrix stack with the given matrix.
 // 		explicit MatrixStack(const glm::mat4 &initialMatrix)
-// 			: m_currMatrix(initialMatrix)
-// 		{
-// 			m_currInverseMatrix = glm::inverse(initialMatrix);
-// 		}
+// 			: m_currMatrix(initialMatrix), m_inverseValid(false)
+// 		{}
 
 // 		/**
 // 		\name Stack Maintanence Functions
@@ -69,16 +67,23 @@
 // 		void Push()
 // 		{
 // 			m_stack.push(m_currMatrix);
-// 			m_inverseStack.push(m_currInverseMatrix);
+// 			m_inverseValidStack.push_back(m_inverseValid);
+// 			if(m_inverseValid)
+// 				m_inverseStack.push(m_currInverseMatrix);
 // 		}
 
 // 		///Restores the most recently preserved matrix.
 // 		void Pop()
 // 		{
 // 			m_currMatrix = m_stack.top();
-// 			m_currInverseMatrix = m_inverseStack.top();
 // 			m_stack.pop();
-// 			m_inverseStack.pop();
+// 			m_inverseValid = m_inverseValidStack.back();
+// 			m_inverseValidStack.pop_back();
+// 			if(m_inverseValid)
+// 			{
+// 				m_currInverseMatrix = m_inverseStack.top();
+// 				m_inverseStack.pop();
+// 			}
 // 		}
 
 // 		/**
@@ -88,7 +93,9 @@
 // 		**/
 // 		void Reset() {
 // 			m_currMatrix = m_stack.top();
-// 			m_currInverseMatrix = m_inverseStack.top();
+// 			m_inverseValid = m_inverseValidStack.back();
+// 			if(m_inverseValid)
+// 				m_currInverseMatrix = m_inverseStack.top();
 // 		}
 
 // 		///Retrieve the current matrix.
@@ -97,9 +104,20 @@
 // 			return m_currMatrix;
 // 		}
 
-// 		///Retrieve the current matrix.
+// 		/**
+// 		\brief Retrieve the inverse of the current matrix.
+
+// 		Translate, Scale and the rotations keep the inverse up to date analytically. Anything else
+// 		(ApplyMatrix, LookAt, the projections, SetMatrix) only marks it stale, and the full inverse is
+// 		computed here on first use and cached for this stack level.
+// 		**/
 // 		const glm::mat4 &InverseTop() const
 // 		{
+// 			if(!m_inverseValid)
+// 			{
+// 				m_currInverseMatrix = glm::inverse(m_currMatrix);
+// 				m_inverseValid = true;
+// 			}
 // 			return m_currInverseMatrix;
 // 		}
 // 		///@}
@@ -260,9 +278,12 @@
 
 // 	private:
 // 		std::stack<glm::mat4, std::vector<glm::mat4> > m_stack;
+// 		//Only holds the levels whose inverse was valid when pushed.
 // 		std::stack<glm::mat4, std::vector<glm::mat4> > m_inverseStack;
+// 		std::vector<bool> m_inverseValidStack;
 // 		glm::mat4 m_currMatrix;
-// 		glm::mat4 m_currInverseMatrix;
+// 		mutable glm::mat4 m_currInverseMatrix;
+// 		mutable bool m_inverseValid;
 // 	};
 
 // 	/**
@@ -0,0 +1,173 @@
+//This file is licensed under the MIT License.
+
+
+#include "GLStateCache.h"
+
+namespace
+{
+	template<typename T>
+	T &GetSlot(std::vector<T> &slots, GLuint index)
+	{
+		if(index >= slots.size())
+		{
+			T unknown = T();
+			unknown.bKnown = false;
+			slots.resize(index + 1, unknown);
+		}
+
+		return slots[index];
+	}
+}
+
+GLStateCache::GLStateCache()
+	: m_numCalls(0)
+	, m_numSkipped(0)
+{
+	Invalidate();
+}
+
+bool GLStateCache::Skip( bool bSame )
+{
+	++m_numCalls;
+	if(bSame)
+		++m_numSkipped;
+	return bSame;
+}
+
+void GLStateCache::UseProgram( GLuint program )
+{
+	if(Skip(m_program.bKnown && m_program.name == program))
+		return;
+
+	glUseProgram(program);
+	m_program.bKnown = true;
+	m_program.name = program;
+}
+
+void GLStateCache::BindVertexArray( GLuint vao )
+{
+	if(Skip(m_vao.bKnown && m_vao.name == vao))
+		return;
+
+	glBindVertexArray(vao);
+	m_vao.bKnown = true;
+	m_vao.name = vao;
+}
+
+void GLStateCache::BindUniformBufferRange( GLuint bindingIndex, GLuint buffer,
+										  GLintptr offset, GLsizeiptr size )
+{
+	BufferRange &range = GetSlot(m_uniformBuffers, bindingIndex);
+	if(Skip(range.bKnown && range.buffer == buffer && range.offset == offset && range.size == size))
+		return;
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, buffer, offset, size);
+	range.bKnown = true;
+	range.buffer = buffer;
+	range.offset = offset;
+	range.size = size;
+}
+
+void GLStateCache::BindUniformBufferBase( GLuint bindingIndex, GLuint buffer )
+{
+	//A range can't be empty, so a size of 0 stands for the whole buffer.
+	BufferRange &range = GetSlot(m_uniformBuffers, bindingIndex);
+	if(Skip(range.bKnown && range.buffer == buffer && range.offset == 0 && range.size == 0))
+		return;
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingIndex, buffer);
+	range.bKnown = true;
+	range.buffer = buffer;
+	range.offset = 0;
+	range.size = 0;
+}
+
+void GLStateCache::BindTexture( GLuint textureUnit, GLenum target, GLuint texture )
+{
+	//Only one target per unit is remembered. Binding another target replaces it, which
+	//can cost a call later but never skips one that was needed.
+	TextureBinding &binding = GetSlot(m_textures, textureUnit);
+	if(Skip(binding.bKnown && binding.target == target && binding.texture == texture))
+		return;
+
+	if(!(m_activeTexture.bKnown && m_activeTexture.name == textureUnit))
+	{
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		m_activeTexture.bKnown = true;
+		m_activeTexture.name = textureUnit;
+	}
+
+	glBindTexture(target, texture);
+	binding.bKnown = true;
+	binding.target = target;
+	binding.texture = texture;
+}
+
+void GLStateCache::BindSampler( GLuint textureUnit, GLuint sampler )
+{
+	Binding &binding = GetSlot(m_samplers, textureUnit);
+	if(Skip(binding.bKnown && binding.name == sampler))
+		return;
+
+	glBindSampler(textureUnit, sampler);
+	binding.bKnown = true;
+	binding.name = sampler;
+}
+
+void GLStateCache::SetCapability( GLenum capability, bool bEnable )
+{
+	Capability *pCap = NULL;
+	for(size_t ix = 0; ix < m_capabilities.size(); ix++)
+	{
+		if(m_capabilities[ix].capability == capability)
+			pCap = &m_capabilities[ix];
+	}
+
+	if(Skip(pCap && pCap->bEnabled == bEnable))
+		return;
+
+	if(bEnable)
+		glEnable(capability);
+	else
+		glDisable(capability);
+
+	if(!pCap)
+	{
+		Capability newCap = {capability, bEnable};
+		m_capabilities.push_back(newCap);
+	}
+	else
+		pCap->bEnabled = bEnable;
+}
+
+void GLStateCache::Enable( GLenum capability )
+{
+	SetCapability(capability, true);
+}
+
+void GLStateCache::Disable( GLenum capability )
+{
+	SetCapability(capability, false);
+}
+
+void GLStateCache::DepthMask( GLboolean bWrite )
+{
+	if(Skip(m_bDepthMaskKnown && m_depthMask == bWrite))
+		return;
+
+	glDepthMask(bWrite);
+	m_bDepthMaskKnown = true;
+	m_depthMask = bWrite;
+}
+
+void GLStateCache::Invalidate()
+{
+	m_program.bKnown = false;
+	m_vao.bKnown = false;
+	m_activeTexture.bKnown = false;
+	m_uniformBuffers.clear();
+	m_textures.clear();
+	m_samplers.clear();
+	m_capabilities.clear();
+	m_bDepthMaskKnown = false;
+}
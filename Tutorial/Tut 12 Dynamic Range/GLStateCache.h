@@ -0,0 +1,90 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <vector>
+#include <glload/gl_3_3.h>
+
+//Remembers the bindings and flags set through it, and drops calls that would set what is
+//already there. It only knows about calls made through it: anything that changes the same
+//state directly must be followed by Invalidate().
+//
+//Framework::Mesh::Render() binds its own VAO and leaves 0 bound afterwards, so it only
+//disagrees with the cache if a non-zero VAO was bound through BindVertexArray().
+class GLStateCache
+{
+public:
+	GLStateCache();
+
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+
+	void BindUniformBufferRange(GLuint bindingIndex, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	void BindUniformBufferBase(GLuint bindingIndex, GLuint buffer);
+
+	//Makes textureUnit active if it has to.
+	void BindTexture(GLuint textureUnit, GLenum target, GLuint texture);
+	void BindSampler(GLuint textureUnit, GLuint sampler);
+
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void DepthMask(GLboolean bWrite);
+
+	//Forget everything; the next call of each kind will go through.
+	void Invalidate();
+
+	void ResetCounts() {m_numCalls = 0; m_numSkipped = 0;}
+	//Every call made to the cache since ResetCounts(), and how many of them never reached GL.
+	int GetNumCalls() const {return m_numCalls;}
+	int GetNumSkipped() const {return m_numSkipped;}
+
+private:
+	//Values start out unknown, so the first call for each always goes through.
+	struct Binding
+	{
+		bool bKnown;
+		GLuint name;
+	};
+
+	struct BufferRange
+	{
+		bool bKnown;
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+
+	struct TextureBinding
+	{
+		bool bKnown;
+		GLenum target;
+		GLuint texture;
+	};
+
+	struct Capability
+	{
+		GLenum capability;
+		bool bEnabled;
+	};
+
+	Binding m_program;
+	Binding m_vao;
+	Binding m_activeTexture;
+	std::vector<BufferRange> m_uniformBuffers;
+	std::vector<TextureBinding> m_textures;
+	std::vector<Binding> m_samplers;
+	std::vector<Capability> m_capabilities;
+	bool m_bDepthMaskKnown;
+	GLboolean m_depthMask;
+
+	int m_numCalls;
+	int m_numSkipped;
+
+	//Counts the call, and returns true if it would change nothing.
+	bool Skip(bool bSame);
+	void SetCapability(GLenum capability, bool bEnable);
+};
+
+#endif //GL_STATE_CACHE_H
@@ -23,6 +23,10 @@
 
 #define ARRAY_COUNT( array ) (sizeof( array ) / (sizeof( array[0] ) * (sizeof( array ) != sizeof(void*) || sizeof( array[0] ) <= sizeof(void*))))
 
+//Program, uniform buffer and depth state changes all go through this, so that
+//the ones which would change nothing are dropped.
+GLStateCache g_stateCache;
+
 struct UnlitProgData
 {
 	GLuint theProgram;
@@ -33,10 +37,9 @@ struct UnlitProgData
 
 	void SetWindowData(const glm::mat4 cameraToClip)
 	{
-		glUseProgram(theProgram);
+		g_stateCache.UseProgram(theProgram);
 		glUniformMatrix4fv(cameraToClipMatrixUnif, 1, GL_FALSE,
 			glm::value_ptr(cameraToClip));
-		glUseProgram(0);
 	}
 };
 
@@ -124,6 +127,11 @@ const ProgramData &GetProgram(LightingProgramTypes eType)
 	return g_Programs[eType];
 }
 
+GLStateCache &GetStateCache()
+{
+	return g_stateCache;
+}
+
 
 LightManager g_lights;
 
@@ -256,8 +264,8 @@ void init()
 	const float depthZNear = 0.0f;
 	const float depthZFar = 1.0f;
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
+	g_stateCache.Enable(GL_DEPTH_TEST);
+	g_stateCache.DepthMask(GL_TRUE);
 	glDepthFunc(GL_LEQUAL);
 	glDepthRange(depthZNear, depthZFar);
 	glEnable(GL_DEPTH_CLAMP);
@@ -316,6 +324,8 @@ void display()
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	g_stateCache.ResetCounts();
+
 	glutil::MatrixStack modelMatrix;
 	modelMatrix.SetMatrix(g_viewPole.CalcMatrix());
 
@@ -344,7 +354,7 @@ void display()
 			modelMatrix.Translate(sunlightDir * 500.0f);
 			modelMatrix.Scale(30.0f, 30.0f, 30.0f);
 
-			glUseProgram(g_Unlit.theProgram);
+			g_stateCache.UseProgram(g_Unlit.theProgram);
 			glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 				glm::value_ptr(modelMatrix.Top()));
 
@@ -361,7 +371,7 @@ void display()
 			modelMatrix.Translate(moonlightDir * 400.0f);
 			modelMatrix.Scale(20.0f, 20.0f, 20.0f);
 
-			glUseProgram(g_Unlit.theProgram);
+			g_stateCache.UseProgram(g_Unlit.theProgram);
 			glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 				glm::value_ptr(modelMatrix.Top()));
 
@@ -379,7 +389,7 @@ void display()
 
 				modelMatrix.Translate(g_lights.GetWorldLightPosition(light));
 
-				glUseProgram(g_Unlit.theProgram);
+				g_stateCache.UseProgram(g_Unlit.theProgram);
 				glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 					glm::value_ptr(modelMatrix.Top()));
 
@@ -396,15 +406,15 @@ void display()
 			modelMatrix.SetIdentity();
 			modelMatrix.Translate(glm::vec3(0.0f, 0.0f, -g_viewPole.GetView().radius));
 
-			glDisable(GL_DEPTH_TEST);
-			glDepthMask(GL_FALSE);
-			glUseProgram(g_Unlit.theProgram);
+			g_stateCache.Disable(GL_DEPTH_TEST);
+			g_stateCache.DepthMask(GL_FALSE);
+			g_stateCache.UseProgram(g_Unlit.theProgram);
 			glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 				glm::value_ptr(modelMatrix.Top()));
 			glUniform4f(g_Unlit.objectColorUnif, 0.25f, 0.25f, 0.25f, 1.0f);
 			g_pScene->GetCubeMesh()->Render("flat");
-			glDepthMask(GL_TRUE);
-			glEnable(GL_DEPTH_TEST);
+			g_stateCache.DepthMask(GL_TRUE);
+			g_stateCache.Enable(GL_DEPTH_TEST);
 			glUniform4f(g_Unlit.objectColorUnif, 1.0f, 1.0f, 1.0f, 1.0f);
 			g_pScene->GetCubeMesh()->Render("flat");
 		}
@@ -429,6 +439,9 @@ void reshape (int w, int h)
 	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ProjectionBlock), &projData);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+	if(g_pScene)
+		g_pScene->SetLodProjection(45.0f, h);
+
 	glViewport(0, 0, (GLsizei) w, (GLsizei) h);
 	glutPostRedisplay();
 }
@@ -482,6 +495,22 @@ void keyboard(unsigned char key, int x, int y)
 		printf("Gamma: %f\n", g_gammaValue);
 		break;
 
+	case 'n':
+		if(g_pScene)
+		{
+			const Framework::NormalMatrixCache &normals = g_pScene->GetNormalMatrices();
+			printf("Normal matrices: %i computed, %i reused\n",
+				normals.GetNumComputed(), normals.GetNumReused());
+
+			const RenderQueue::Stats &stats = g_pScene->GetRenderStats();
+			printf("Draws: %i, program changes: %i, material changes: %i\n",
+				stats.numDraws, stats.numProgramChanges, stats.numMaterialChanges);
+
+			printf("GL state calls: %i made, %i skipped\n",
+				g_stateCache.GetNumCalls(), g_stateCache.GetNumSkipped());
+		}
+		break;
+
 	case 32:
 		{
 			float sunAlpha = g_lights.GetSunTime();
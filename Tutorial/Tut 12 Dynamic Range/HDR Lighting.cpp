@@ -15,6 +15,7 @@
 #include "../framework/Mesh.h"
 #include "../framework/MousePole.h"
 #include "../framework/Timer.h"
+#include "../framework/UniformRing.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -23,6 +24,10 @@
 
 #define ARRAY_COUNT( array ) (sizeof( array ) / (sizeof( array[0] ) * (sizeof( array ) != sizeof(void*) || sizeof( array[0] ) <= sizeof(void*))))
 
+//Program, uniform buffer and depth state changes all go through this, so that
+//the ones which would change nothing are dropped.
+GLStateCache g_stateCache;
+
 struct UnlitProgData
 {
 	GLuint theProgram;
@@ -33,10 +38,9 @@ struct UnlitProgData
 
 	void SetWindowData(const glm::mat4 cameraToClip)
 	{
-		glUseProgram(theProgram);
+		g_stateCache.UseProgram(theProgram);
 		glUniformMatrix4fv(cameraToClipMatrixUnif, 1, GL_FALSE,
 			glm::value_ptr(cameraToClip));
-		glUseProgram(0);
 	}
 };
 
@@ -124,6 +128,11 @@ const ProgramData &GetProgram(LightingProgramTypes eType)
 	return g_Programs[eType];
 }
 
+GLStateCache &GetStateCache()
+{
+	return g_stateCache;
+}
+
 
 LightManager g_lights;
 
@@ -174,7 +183,6 @@ struct ProjectionBlock
 	glm::mat4 cameraToClipMatrix;
 };
 
-GLuint g_lightUniformBuffer;
 GLuint g_materialUniformBuffer;
 GLuint g_projectionUniformBuffer;
 
@@ -242,6 +250,9 @@ void SetupHDRLighting()
 
 Scene *g_pScene = NULL;
 
+//The light block changes every frame, so it comes from the ring rather than its own buffer.
+Framework::UniformRing *g_pUniformRing = NULL;
+
 //Called after the window and OpenGL are initialized. Called exactly once, before the main loop.
 void init()
 {
@@ -272,25 +283,20 @@ void init()
 	const float depthZNear = 0.0f;
 	const float depthZFar = 1.0f;
 
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
+	g_stateCache.Enable(GL_DEPTH_TEST);
+	g_stateCache.DepthMask(GL_TRUE);
 	glDepthFunc(GL_LEQUAL);
 	glDepthRange(depthZNear, depthZFar);
 	glEnable(GL_DEPTH_CLAMP);
 
 	//Setup our Uniform Buffers
-	glGenBuffers(1, &g_lightUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_DYNAMIC_DRAW);
+	g_pUniformRing = new Framework::UniformRing(sizeof(LightBlockHDR), 1);
 
 	glGenBuffers(1, &g_projectionUniformBuffer);
 	glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
 	glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), NULL, GL_DYNAMIC_DRAW);
 
 	//Bind the static buffers.
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_lightBlockIndex, g_lightUniformBuffer,
-		0, sizeof(LightBlock));
-
 	glBindBufferRange(GL_UNIFORM_BUFFER, g_projectionBlockIndex, g_projectionUniformBuffer,
 		0, sizeof(ProjectionBlock));
 
@@ -313,15 +319,16 @@ void display()
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	g_stateCache.ResetCounts();
+
 	glutil::MatrixStack modelMatrix;
 	modelMatrix.SetMatrix(g_viewPole.CalcMatrix());
 
 	const glm::mat4 &worldToCamMat = modelMatrix.Top();
 	LightBlockHDR lightData = g_lights.GetLightInformationHDR(worldToCamMat);
 
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(lightData), &lightData);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	g_pUniformRing->BeginFrame();
+	g_pUniformRing->Upload(g_lightBlockIndex, &lightData, sizeof(lightData));
 
 	if(g_pScene)
 	{
@@ -340,7 +347,7 @@ void display()
 			modelMatrix.Translate(sunlightDir * 500.0f);
 			modelMatrix.Scale(30.0f, 30.0f, 30.0f);
 
-			glUseProgram(g_Unlit.theProgram);
+			g_stateCache.UseProgram(g_Unlit.theProgram);
 			glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 				glm::value_ptr(modelMatrix.Top()));
 
@@ -358,7 +365,7 @@ void display()
 
 				modelMatrix.Translate(g_lights.GetWorldLightPosition(light));
 
-				glUseProgram(g_Unlit.theProgram);
+				g_stateCache.UseProgram(g_Unlit.theProgram);
 				glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 					glm::value_ptr(modelMatrix.Top()));
 
@@ -375,20 +382,22 @@ void display()
 			modelMatrix.SetIdentity();
 			modelMatrix.Translate(glm::vec3(0.0f, 0.0f, -g_viewPole.GetView().radius));
 
-			glDisable(GL_DEPTH_TEST);
-			glDepthMask(GL_FALSE);
-			glUseProgram(g_Unlit.theProgram);
+			g_stateCache.Disable(GL_DEPTH_TEST);
+			g_stateCache.DepthMask(GL_FALSE);
+			g_stateCache.UseProgram(g_Unlit.theProgram);
 			glUniformMatrix4fv(g_Unlit.modelToCameraMatrixUnif, 1, GL_FALSE,
 				glm::value_ptr(modelMatrix.Top()));
 			glUniform4f(g_Unlit.objectColorUnif, 0.25f, 0.25f, 0.25f, 1.0f);
 			g_pScene->GetCubeMesh()->Render("flat");
-			glDepthMask(GL_TRUE);
-			glEnable(GL_DEPTH_TEST);
+			g_stateCache.DepthMask(GL_TRUE);
+			g_stateCache.Enable(GL_DEPTH_TEST);
 			glUniform4f(g_Unlit.objectColorUnif, 1.0f, 1.0f, 1.0f, 1.0f);
 			g_pScene->GetCubeMesh()->Render("flat");
 		}
 	}
 
+	g_pUniformRing->EndFrame();
+
 	glutPostRedisplay();
 	glutSwapBuffers();
 }
@@ -408,6 +417,9 @@ void reshape (int w, int h)
 	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ProjectionBlock), &projData);
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+	if(g_pScene)
+		g_pScene->SetLodProjection(45.0f, h);
+
 	glViewport(0, 0, (GLsizei) w, (GLsizei) h);
 	glutPostRedisplay();
 }
@@ -428,6 +440,8 @@ void keyboard(unsigned char key, int x, int y)
 	case 27:
 		delete g_pScene;
 		g_pScene = NULL;
+		delete g_pUniformRing;
+		g_pUniformRing = NULL;
 		glutLeaveMainLoop();
 		return;
 		
@@ -443,6 +457,22 @@ void keyboard(unsigned char key, int x, int y)
 	case 'L': SetupNighttimeLighting(); break;
 	case 'k': SetupHDRLighting(); break;
 
+	case 'n':
+		if(g_pScene)
+		{
+			const Framework::NormalMatrixCache &normals = g_pScene->GetNormalMatrices();
+			printf("Normal matrices: %i computed, %i reused\n",
+				normals.GetNumComputed(), normals.GetNumReused());
+
+			const RenderQueue::Stats &stats = g_pScene->GetRenderStats();
+			printf("Draws: %i, program changes: %i, material changes: %i\n",
+				stats.numDraws, stats.numProgramChanges, stats.numMaterialChanges);
+
+			printf("GL state calls: %i made, %i skipped\n",
+				g_stateCache.GetNumCalls(), g_stateCache.GetNumSkipped());
+		}
+		break;
+
 	case 32:
 		{
 			float sunAlpha = g_lights.GetSunTime();
@@ -0,0 +1,282 @@
+//This file is licensed under the MIT License.
+
+
+//Console timings for the Lights.h code paths. No window or GL context is made.
+//
+//1: Interpolator segment lookup over 10000 keys: the cursor-hinted binary search in
+//WeightedLinearInterpolator against the linear scan it replaced.
+//2: LightManager's per-frame update cost as the number of point lights grows.
+//3: How closely linear and spline light paths follow a circle for their number of keys,
+//and what baking them costs.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../framework/framework.h"
+#include "Lights.h"
+#include <glm/glm.hpp>
+
+namespace
+{
+	double SecondsSince(clock_t start)
+	{
+		return (clock() - start) / (double)CLOCKS_PER_SEC;
+	}
+
+	//Same keys as the interpolator it derives from, but looked up the way
+	//WeightedLinearInterpolator did before the cursor hint.
+	class LinearScanInterpolator : public Framework::TimedLinearInterpolator<float>
+	{
+	public:
+		float InterpolateLinear(float fAlpha) const
+		{
+			if(m_values.empty())
+				return 0.0f;
+			if(m_values.size() == 1)
+				return m_values[0].data;
+
+			size_t segment = 1;
+			for(; segment < m_values.size(); ++segment)
+			{
+				if(fAlpha < m_values[segment].weight)
+					break;
+			}
+
+			if(segment == m_values.size())
+				return m_values.back().data;
+
+			float sectionAlpha = fAlpha - m_values[segment - 1].weight;
+			sectionAlpha /= m_values[segment].weight - m_values[segment - 1].weight;
+
+			return m_values[segment - 1].data * (1.0f - sectionAlpha) +
+				m_values[segment].data * sectionAlpha;
+		}
+	};
+
+	const int NUMBER_OF_KEYS = 10000;
+
+	void MakeKeys(MaxIntensityVector &keys)
+	{
+		std::vector<float> times;
+		for(int key = 0; key < NUMBER_OF_KEYS; key++)
+			times.push_back(rand() / (float)RAND_MAX);
+		std::sort(times.begin(), times.end());
+
+		for(int key = 0; key < NUMBER_OF_KEYS; key++)
+			keys.push_back(MaxIntensityData(rand() / (float)RAND_MAX, times[key]));
+	}
+
+	void MakeSteppedAlphas(std::vector<float> &alphas, float step, int count)
+	{
+		float alpha = 0.0f;
+		for(int ix = 0; ix < count; ix++)
+		{
+			alphas.push_back(alpha);
+			alpha = fmodf(alpha + step, 1.0f);
+		}
+	}
+
+	void MakeRandomAlphas(std::vector<float> &alphas, int count)
+	{
+		for(int ix = 0; ix < count; ix++)
+			alphas.push_back(rand() / (float)RAND_MAX);
+	}
+
+	void TimeLookups(const char *strPattern, const LinearScanInterpolator &interp,
+		const std::vector<float> &alphas, int linearCount)
+	{
+		const int hintedPasses = 20;
+		float hintedSum = 0.0f;
+		clock_t start = clock();
+		for(int pass = 0; pass < hintedPasses; pass++)
+		{
+			for(size_t ix = 0; ix < alphas.size(); ix++)
+				hintedSum += interp.Interpolate(alphas[ix]);
+		}
+		double hintedNs = SecondsSince(start) * 1.0e9 / (hintedPasses * alphas.size());
+
+		float linearSum = 0.0f;
+		start = clock();
+		for(int ix = 0; ix < linearCount; ix++)
+			linearSum += interp.InterpolateLinear(alphas[ix]);
+		double linearNs = SecondsSince(start) * 1.0e9 / linearCount;
+
+		//Both must land on the same values.
+		int mismatches = 0;
+		for(int ix = 0; ix < linearCount; ix++)
+		{
+			if(interp.Interpolate(alphas[ix]) != interp.InterpolateLinear(alphas[ix]))
+				mismatches++;
+		}
+
+		printf("%-12s hinted %8.1f ns   linear %10.1f ns   %7.0fx   mismatches %d   (%g %g)\n",
+			strPattern, hintedNs, linearNs, linearNs / hintedNs, mismatches,
+			hintedSum / hintedPasses, linearSum);
+	}
+
+	void BenchmarkSegmentSearch()
+	{
+		printf("Segment lookup, %d keys, per lookup:\n", NUMBER_OF_KEYS);
+
+		MaxIntensityVector keys;
+		MakeKeys(keys);
+
+		LinearScanInterpolator interp;
+		interp.SetValues(keys, false);
+
+		//A 30 second loop at 60 frames a second moves about five keys a frame, so the
+		//cursor rarely hits. Fine steps stay in a segment for about ten lookups.
+		std::vector<float> frameAlphas;
+		std::vector<float> fineAlphas;
+		std::vector<float> randomAlphas;
+		MakeSteppedAlphas(frameAlphas, 1.0f / (30.0f * 60.0f), 100000);
+		MakeSteppedAlphas(fineAlphas, 0.1f / NUMBER_OF_KEYS, 100000);
+		MakeRandomAlphas(randomAlphas, 100000);
+
+		TimeLookups("frame steps", interp, frameAlphas, 20000);
+		TimeLookups("fine steps", interp, fineAlphas, 20000);
+		TimeLookups("random", interp, randomAlphas, 20000);
+		printf("\n");
+	}
+
+	void BenchmarkLightUpdate()
+	{
+		printf("LightManager::FastForwardTime(TIMER_ALL, 1/60), per frame:\n");
+
+		const int lightCounts[] = {3, 16, 64, 256, 1024, 4096, 16384, 65536};
+		const int numPaths = 8;
+
+		for(int countIx = 0; countIx < (int)ARRAY_COUNT(lightCounts); countIx++)
+		{
+			LightManager lightMgr;
+
+			//Some extra paths for the added lights to share, as callers would.
+			std::vector<int> paths;
+			for(int pathIx = 0; pathIx < numPaths; pathIx++)
+			{
+				std::vector<glm::vec3> positions;
+				for(int key = 0; key < 6; key++)
+				{
+					float angle = (key + pathIx * 0.1f) * 3.14159f / 3.0f;
+					positions.push_back(glm::vec3(cosf(angle) * 50.0f, 10.0f + pathIx,
+						sinf(angle) * 50.0f));
+				}
+				paths.push_back(lightMgr.AddLightPath(positions));
+			}
+
+			for(int light = lightMgr.GetNumberOfPointLights(); light < lightCounts[countIx]; light++)
+			{
+				lightMgr.AddPointLight(paths[light % numPaths], 10.0f + (light % 13),
+					(light % 97) / 97.0f, glm::vec4(0.2f, 0.2f, 0.2f, 1.0f));
+			}
+
+			//Enough frames to run for a good fraction of a second at every count.
+			const int numFrames = std::max(200, 4000000 / lightCounts[countIx]);
+			clock_t start = clock();
+			for(int frame = 0; frame < numFrames; frame++)
+				lightMgr.FastForwardTime(TIMER_ALL, 1.0f / 60.0f);
+			double frameUs = SecondsSince(start) * 1.0e6 / numFrames;
+
+			glm::vec3 lastPos = lightMgr.GetWorldLightPosition(lightMgr.GetNumberOfPointLights() - 1);
+			printf("%6d lights   %9.2f us   %6.2f ns/light   (%g)\n",
+				lightMgr.GetNumberOfPointLights(), frameUs,
+				frameUs * 1000.0 / lightMgr.GetNumberOfPointLights(), lastPos.x);
+		}
+		printf("\n");
+	}
+
+	const float PATH_RADIUS = 25.0f;
+	//The error LightManager bakes its paths to.
+	const float PATH_BAKE_ERROR = 0.25f;
+
+	void MakeCircleKeys(std::vector<glm::vec3> &keys, int numKeys)
+	{
+		for(int key = 0; key < numKeys; key++)
+		{
+			float angle = key * 2.0f * 3.14159265f / numKeys;
+			keys.push_back(glm::vec3(cosf(angle) * PATH_RADIUS, 10.0f, sinf(angle) * PATH_RADIUS));
+		}
+	}
+
+	//How far the path strays from the circle, the sharpest turn between two of its table's
+	//chords, and what a lookup costs.
+	template<typename Path>
+	void MeasurePath(const char *strName, size_t numKeys, const Path &path)
+	{
+		const int numChecks = 100000;
+		float maxError = 0.0f;
+		for(int check = 0; check < numChecks; check++)
+		{
+			glm::vec3 pos = path.Interpolate(check / (float)numChecks);
+			maxError = std::max(maxError, fabsf(sqrtf(pos.x * pos.x + pos.z * pos.z) - PATH_RADIUS));
+		}
+
+		const std::vector<glm::vec3> &table = path.GetTable();
+		float sharpestTurn = 0.0f;
+		for(size_t entry = 2; entry < table.size(); entry++)
+		{
+			glm::vec3 lhs = glm::normalize(table[entry - 1] - table[entry - 2]);
+			glm::vec3 rhs = glm::normalize(table[entry] - table[entry - 1]);
+			float cosTurn = glm::clamp(glm::dot(lhs, rhs), -1.0f, 1.0f);
+			sharpestTurn = std::max(sharpestTurn, acosf(cosTurn) * 180.0f / 3.14159265f);
+		}
+
+		const int numPasses = 20;
+		float sum = 0.0f;
+		clock_t start = clock();
+		for(int pass = 0; pass < numPasses; pass++)
+		{
+			for(int check = 0; check < numChecks; check++)
+				sum += path.Interpolate(check / (float)numChecks).x;
+		}
+		double lookupNs = SecondsSince(start) * 1.0e9 / (numPasses * numChecks);
+
+		printf("%-8s %3d keys   %5d table entries   max error %6.3f   sharpest turn %5.1f deg"
+			"   %5.1f ns   (%g)\n", strName, (int)numKeys, (int)table.size(), maxError,
+			sharpestTurn, lookupNs, sum);
+	}
+
+	void BenchmarkPathShapes()
+	{
+		printf("A circle of radius %g as a light path, baked to %g:\n", PATH_RADIUS, PATH_BAKE_ERROR);
+
+		const int linearKeys[] = {8, 16, 32};
+		for(int keysIx = 0; keysIx < (int)ARRAY_COUNT(linearKeys); keysIx++)
+		{
+			std::vector<glm::vec3> keys;
+			MakeCircleKeys(keys, linearKeys[keysIx]);
+
+			Framework::ConstVelLinearInterpolator<glm::vec3> path;
+			path.SetValues(keys);
+			path.Bake(PATH_BAKE_ERROR);
+			MeasurePath("linear", keys.size(), path);
+		}
+
+		const int splineKeys[] = {4, 6, 8};
+		for(int keysIx = 0; keysIx < (int)ARRAY_COUNT(splineKeys); keysIx++)
+		{
+			std::vector<glm::vec3> keys;
+			MakeCircleKeys(keys, splineKeys[keysIx]);
+
+			Framework::ConstVelSplineInterpolator<glm::vec3> path;
+			path.SetValues(keys);
+			path.Bake(PATH_BAKE_ERROR);
+			MeasurePath("spline", keys.size(), path);
+		}
+	}
+}
+
+int main()
+{
+	srand(12);
+
+	BenchmarkSegmentSearch();
+	BenchmarkLightUpdate();
+	BenchmarkPathShapes();
+
+	return 0;
+}
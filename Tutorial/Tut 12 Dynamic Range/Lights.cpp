@@ -14,6 +14,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE_LIGHT_UPDATE
+#include <emmintrin.h>
+#endif
+
 static float g_fLightHeight = 10.5f;
 static float g_fLightRadius = 70.0f;
 
@@ -34,16 +39,41 @@ glm::vec4 CalcLightPosition(const Framework::Timer &timer, float alphaOffset)
 const float g_fHalfLightDistance = 70.0f;
 const float g_fLightAttenuation = 1.0f / (g_fHalfLightDistance * g_fHalfLightDistance);
 
+//How far, in world units, a baked light path may stray from its keys.
+const float g_fMaxLightPathError = 0.25f;
+
+//alpha = frac(time * rate + phase) for each light. Neither time nor phase is ever
+//negative, so truncating gives the floor.
+static void CalcLightAlphas( float time, const float *rate, const float *phase,
+							float *alpha, size_t numLights )
+{
+	size_t light = 0;
+
+#ifdef USE_SSE_LIGHT_UPDATE
+	const __m128 timeVec = _mm_set1_ps(time);
+	for(; light + 4 <= numLights; light += 4)
+	{
+		__m128 loops = _mm_add_ps(_mm_mul_ps(timeVec, _mm_loadu_ps(rate + light)),
+			_mm_loadu_ps(phase + light));
+		__m128 wholeLoops = _mm_cvtepi32_ps(_mm_cvttps_epi32(loops));
+		_mm_storeu_ps(alpha + light, _mm_sub_ps(loops, wholeLoops));
+	}
+#endif
+
+	for(; light < numLights; light++)
+	{
+		float loops = time * rate[light] + phase[light];
+		alpha[light] = loops - floorf(loops);
+	}
+}
+
 LightManager::LightManager()
 	: m_sunTimer(Framework::Timer::TT_LOOP, 30.0f)
 	, m_ambientInterpolator()
+	, m_lightTimer(Framework::Timer::TT_INFINITE, 1.0f)
+	, m_bSunKeysShared(false)
 {
-	m_lightTimers.reserve(NUMBER_OF_POINT_LIGHTS);
-	m_lightPos.reserve(NUMBER_OF_POINT_LIGHTS);
-	for(size_t _ = 0; _ < NUMBER_OF_POINT_LIGHTS; ++_)
-		m_lightPos.push_back(LightInterpolator());
-
-	m_lightIntensity.resize(NUMBER_OF_POINT_LIGHTS, glm::vec4(0.2f, 0.2f, 0.2f, 1.0f));
+	const glm::vec4 defaultIntensity(0.2f, 0.2f, 0.2f, 1.0f);
 
 	std::vector<glm::vec3> posValues;
 	posValues.reserve(60);
@@ -56,23 +86,17 @@ LightManager::LightManager()
 	posValues.push_back(glm::vec3(70.0f, 30.0f, -50.0f));
 	posValues.push_back(glm::vec3(70.0f, 30.0f, 50.0f));
 	posValues.push_back(glm::vec3(50.0f, 30.0f, 70.0f));
-	m_lightPos[0].SetValues(posValues);
-	m_lightTimers.push_back(Framework::Timer(Framework::Timer::TT_LOOP, 15.0f));
+	AddPointLight(AddLightPath(posValues), 15.0f, 0.0f, defaultIntensity);
 
-	//Right-side light.
+	//Right-side light. The spline rounds the helix off from four keys a turn, where
+	//straight lines needed eight a turn and still showed corners.
 	posValues.clear();
 	posValues.push_back(glm::vec3(100.0f, 6.0f, 75.0f));
-	posValues.push_back(glm::vec3(90.0f, 8.0f, 90.0f));
 	posValues.push_back(glm::vec3(75.0f, 10.0f, 100.0f));
-	posValues.push_back(glm::vec3(60.0f, 12.0f, 90.0f));
 	posValues.push_back(glm::vec3(50.0f, 14.0f, 75.0f));
-	posValues.push_back(glm::vec3(60.0f, 16.0f, 60.0f));
 	posValues.push_back(glm::vec3(75.0f, 18.0f, 50.0f));
-	posValues.push_back(glm::vec3(90.0f, 20.0f, 60.0f));
 	posValues.push_back(glm::vec3(100.0f, 22.0f, 75.0f));
-	posValues.push_back(glm::vec3(90.0f, 24.0f, 90.0f));
 	posValues.push_back(glm::vec3(75.0f, 26.0f, 100.0f));
-	posValues.push_back(glm::vec3(60.0f, 28.0f, 90.0f));
 	posValues.push_back(glm::vec3(50.0f, 30.0f, 75.0f));
 
 	posValues.push_back(glm::vec3(105.0f, 9.0f, -70.0f));
@@ -83,8 +107,7 @@ LightManager::LightManager()
 	posValues.push_back(glm::vec3(105.0f, 34.0f, -90.0f));
 	posValues.push_back(glm::vec3(72.0f, 44.0f, -90.0f));
 
-	m_lightPos[1].SetValues(posValues);
-	m_lightTimers.push_back(Framework::Timer(Framework::Timer::TT_LOOP, 25.0f));
+	AddPointLight(AddLightPath(posValues, LIGHT_PATH_SPLINE), 25.0f, 0.0f, defaultIntensity);
 
 	//Left-side light.
 	posValues.clear();
@@ -112,8 +135,63 @@ LightManager::LightManager()
 	posValues.push_back(glm::vec3(-60.0f, 20.0f, 90.0f));
 	posValues.push_back(glm::vec3(-40.0f, 25.0f, 90.0f));
 
-	m_lightPos[2].SetValues(posValues);
-	m_lightTimers.push_back(Framework::Timer(Framework::Timer::TT_LOOP, 15.0f));
+	AddPointLight(AddLightPath(posValues), 15.0f, 0.0f, defaultIntensity);
+
+	UpdateFrameValues();
+}
+
+int LightManager::AddLightPath( const std::vector<glm::vec3> &positions, LightPathType eType )
+{
+	std::vector<glm::vec3> table;
+	glm::vec3 start;
+	if(eType == LIGHT_PATH_SPLINE)
+	{
+		Framework::ConstVelSplineInterpolator<glm::vec3> path;
+		path.SetValues(positions);
+		path.Bake(g_fMaxLightPathError);
+		table = path.GetTable();
+		start = path.Interpolate(0.0f);
+	}
+	else
+	{
+		Framework::ConstVelLinearInterpolator<glm::vec3> path;
+		path.SetValues(positions);
+		path.Bake(g_fMaxLightPathError);
+		table = path.GetTable();
+		start = path.Interpolate(0.0f);
+	}
+
+	//A single key doesn't bake; the light just sits there.
+	if(table.size() < 2)
+		table.assign(2, start);
+
+	m_lightPaths.push_back(std::vector<glm::vec3>());
+	m_lightPaths.back().swap(table);
+
+	return (int)m_lightPaths.size() - 1;
+}
+
+int LightManager::AddPointLight( int pathHandle, float loopDuration, float phase,
+								const glm::vec4 &intensity )
+{
+	assert(0 <= pathHandle && pathHandle < (int)m_lightPaths.size());
+
+	m_lightPath.push_back(pathHandle);
+	m_lightRate.push_back(1.0f / loopDuration);
+	//CalcLightAlphas relies on phases being in [0, 1).
+	m_lightPhase.push_back(phase - floorf(phase));
+	m_lightIntensity.push_back(intensity);
+
+	m_lightAlpha.push_back(0.0f);
+	CalcLightAlphas(m_lightTimer.GetTimeSinceStart(), &m_lightRate.back(), &m_lightPhase.back(),
+		&m_lightAlpha.back(), 1);
+
+	glm::vec3 startPos = Framework::InterpolateTable(m_lightPaths[pathHandle], m_lightAlpha.back());
+	m_lightPosX.push_back(startPos.x);
+	m_lightPosY.push_back(startPos.y);
+	m_lightPosZ.push_back(startPos.z);
+
+	return (int)m_lightPath.size() - 1;
 }
 
 void LightManager::SetSunlightValues( SunlightValue *pValues, int iSize )
@@ -136,6 +214,9 @@ void LightManager::SetSunlightValues( SunlightValue *pValues, int iSize )
 	MaxIntensityVector maxIntensity;
 	maxIntensity.push_back(MaxIntensityData(1.0f, 0.0f));
 	m_maxIntensityInterpolator.SetValues(maxIntensity, false);
+
+	m_bSunKeysShared = false;
+	UpdateFrameValues();
 }
 
 void LightManager::SetSunlightValues( SunlightValueHDR *pValues, int iSize )
@@ -160,6 +241,9 @@ void LightManager::SetSunlightValues( SunlightValueHDR *pValues, int iSize )
 	m_moonlightInterpolator.SetValues(moonlight);
 	m_backgroundInterpolator.SetValues(background);
 	m_maxIntensityInterpolator.SetValues(maxIntensity);
+
+	m_bSunKeysShared = true;
+	UpdateFrameValues();
 }
 
 struct UpdateTimer
@@ -204,15 +288,17 @@ struct FFTimer
 void LightManager::UpdateTime()
 {
 	m_sunTimer.Update();
-	std::for_each(m_lightTimers.begin(), m_lightTimers.end(), UpdateTimer());
+	m_lightTimer.Update();
 	std::for_each(m_extraTimers.begin(), m_extraTimers.end(), UpdateTimer());
+
+	UpdateFrameValues();
 }
 
 void LightManager::SetPause(TimerTypes eTimer, bool pause)
 {
 	if(eTimer == TIMER_ALL || eTimer == TIMER_LIGHTS)
 	{
-		std::for_each(m_lightTimers.begin(), m_lightTimers.end(), PauseTimer(pause));
+		m_lightTimer.SetPause(pause);
 		std::for_each(m_extraTimers.begin(), m_extraTimers.end(), PauseTimer(pause));
 	}
 
@@ -230,7 +316,7 @@ bool LightManager::IsPaused( TimerTypes eTimer ) const
 	if(eTimer == TIMER_ALL || eTimer == TIMER_SUN)
 		return m_sunTimer.IsPaused();
 
-	return m_lightTimers.front().IsPaused();
+	return m_lightTimer.IsPaused();
 }
 
 void LightManager::RewindTime(TimerTypes eTimer, float secRewind )
@@ -240,9 +326,11 @@ void LightManager::RewindTime(TimerTypes eTimer, float secRewind )
 
 	if(eTimer == TIMER_ALL || eTimer == TIMER_LIGHTS)
 	{
-		std::for_each(m_lightTimers.begin(), m_lightTimers.end(), RewindTimer(secRewind));
+		m_lightTimer.Rewind(secRewind);
 		std::for_each(m_extraTimers.begin(), m_extraTimers.end(), RewindTimer(secRewind));
 	}
+
+	UpdateFrameValues();
 }
 
 void LightManager::FastForwardTime(TimerTypes eTimer,  float secFF )
@@ -252,31 +340,97 @@ void LightManager::FastForwardTime(TimerTypes eTimer,  float secFF )
 
 	if(eTimer == TIMER_ALL || eTimer == TIMER_LIGHTS)
 	{
-		std::for_each(m_lightTimers.begin(), m_lightTimers.end(), FFTimer(secFF));
+		m_lightTimer.Fastforward(secFF);
 		std::for_each(m_extraTimers.begin(), m_extraTimers.end(), FFTimer(secFF));
 	}
+
+	UpdateFrameValues();
+}
+
+void LightManager::UpdateFrameValues()
+{
+	const float sunAlpha = m_sunTimer.GetAlpha();
+
+	//The ambient, sunlight and background keys always come from the same table.
+	Framework::InterpolatorPosition sunPos = m_ambientInterpolator.Locate(sunAlpha);
+	m_frame.ambientIntensity = m_ambientInterpolator.Interpolate(sunPos);
+	m_frame.sunlightIntensity = m_sunlightInterpolator.Interpolate(sunPos);
+	m_frame.backgroundColor = m_backgroundInterpolator.Interpolate(sunPos);
+
+	if(m_bSunKeysShared)
+	{
+		m_frame.moonlightIntensity = m_moonlightInterpolator.Interpolate(sunPos);
+		m_frame.maxIntensity = m_maxIntensityInterpolator.Interpolate(sunPos);
+	}
+	else
+	{
+		m_frame.moonlightIntensity = m_moonlightInterpolator.Interpolate(sunAlpha);
+		m_frame.maxIntensity = m_maxIntensityInterpolator.Interpolate(sunAlpha);
+	}
+
+	float angle = 2.0f * 3.14159f * sunAlpha;
+	glm::vec4 sunDirection(0.0f);
+	sunDirection[0] = sinf(angle);
+	sunDirection[1] = cosf(angle);
+
+	//Keep the sun from being perfectly centered overhead.
+	m_frame.sunlightDirection =
+		glm::rotate(glm::mat4(1.0f), 5.0f, glm::vec3(0.0f, 1.0f, 0.0f)) * sunDirection;
+
+	UpdatePointLights();
+}
+
+void LightManager::UpdatePointLights()
+{
+	const size_t numLights = m_lightPath.size();
+	if(numLights == 0)
+		return;
+
+	CalcLightAlphas(m_lightTimer.GetTimeSinceStart(), &m_lightRate[0], &m_lightPhase[0],
+		&m_lightAlpha[0], numLights);
+
+	//The paths are baked, so each of these is a table lookup. This part stays scalar:
+	//lights can each read a different table, and SSE2 has no gather.
+	for(size_t light = 0; light < numLights; light++)
+	{
+		glm::vec3 pos = Framework::InterpolateTable(m_lightPaths[m_lightPath[light]],
+			m_lightAlpha[light]);
+		m_lightPosX[light] = pos.x;
+		m_lightPosY[light] = pos.y;
+		m_lightPosZ[light] = pos.z;
+	}
+}
+
+void LightManager::FillPointLights( PerLight *pLights, const glm::mat4 &worldToCameraMat ) const
+{
+	const int numLights = std::min(NUMBER_OF_POINT_LIGHTS, GetNumberOfPointLights());
+	for(int light = 0; light < numLights; light++)
+	{
+		glm::vec4 worldLightPos(m_lightPosX[light], m_lightPosY[light], m_lightPosZ[light], 1.0f);
+
+		pLights[light].cameraSpaceLightPos = worldToCameraMat * worldLightPos;
+		pLights[light].lightIntensity = m_lightIntensity[light];
+	}
+
+	for(int light = numLights; light < NUMBER_OF_POINT_LIGHTS; light++)
+	{
+		pLights[light].cameraSpaceLightPos = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		pLights[light].lightIntensity = glm::vec4(0.0f);
+	}
 }
 
 LightBlock LightManager::GetLightInformation( const glm::mat4 &worldToCameraMat ) const
 {
 	LightBlock lightData;
 
-	lightData.ambientIntensity = m_ambientInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	lightData.ambientIntensity = m_frame.ambientIntensity;
 	lightData.lightAttenuation = g_fLightAttenuation;
 
 	lightData.lights[0].cameraSpaceLightPos =
-		worldToCameraMat * GetSunlightDirection();
-	lightData.lights[0].lightIntensity = m_sunlightInterpolator.Interpolate(m_sunTimer.GetAlpha());
+		worldToCameraMat * m_frame.sunlightDirection;
+	lightData.lights[0].lightIntensity = m_frame.sunlightIntensity;
 
-	for(int light = 0; light < NUMBER_OF_POINT_LIGHTS; light++)
-	{
-		glm::vec4 worldLightPos =
-			glm::vec4(m_lightPos[light].Interpolate(m_lightTimers[light].GetAlpha()), 1.0f);
-		glm::vec4 lightPosCameraSpace = worldToCameraMat * worldLightPos;
-
-		lightData.lights[light + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS].cameraSpaceLightPos = lightPosCameraSpace;
-		lightData.lights[light + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS].lightIntensity = m_lightIntensity[light];
-	}
+	FillPointLights(lightData.lights + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS, worldToCameraMat);
 
 	return lightData;
 }
@@ -286,27 +440,19 @@ LightBlockHDR LightManager::GetLightInformationHDR( const glm::mat4 &worldToCame
 {
 	LightBlockHDR lightData;
 
-	lightData.ambientIntensity = m_ambientInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	lightData.ambientIntensity = m_frame.ambientIntensity;
 	lightData.lightAttenuation = g_fLightAttenuation;
-	lightData.maxIntensity = m_maxIntensityInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	lightData.maxIntensity = m_frame.maxIntensity;
 
 	lightData.lights[0].cameraSpaceLightPos =
-		worldToCameraMat * GetSunlightDirection();
-	lightData.lights[0].lightIntensity = m_sunlightInterpolator.Interpolate(m_sunTimer.GetAlpha());
+		worldToCameraMat * m_frame.sunlightDirection;
+	lightData.lights[0].lightIntensity = m_frame.sunlightIntensity;
 
 	lightData.lights[1].cameraSpaceLightPos =
-		worldToCameraMat * -GetSunlightDirection();
-	lightData.lights[1].lightIntensity = m_moonlightInterpolator.Interpolate(m_sunTimer.GetAlpha());
+		worldToCameraMat * -m_frame.sunlightDirection;
+	lightData.lights[1].lightIntensity = m_frame.moonlightIntensity;
 
-	for(int light = 0; light < NUMBER_OF_POINT_LIGHTS; light++)
-	{
-		glm::vec4 worldLightPos =
-			glm::vec4(m_lightPos[light].Interpolate(m_lightTimers[light].GetAlpha()), 1.0f);
-		glm::vec4 lightPosCameraSpace = worldToCameraMat * worldLightPos;
-
-		lightData.lights[light + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS].cameraSpaceLightPos = lightPosCameraSpace;
-		lightData.lights[light + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS].lightIntensity = m_lightIntensity[light];
-	}
+	FillPointLights(lightData.lights + NUMBER_OF_LIGHTS - NUMBER_OF_POINT_LIGHTS, worldToCameraMat);
 
 	return lightData;
 }
@@ -323,35 +469,27 @@ LightBlockGamma LightManager::GetLightInformationGamma( const glm::mat4 &worldTo
 
 glm::vec4 LightManager::GetSunlightDirection() const
 {
-	float angle = 2.0f * 3.14159f * m_sunTimer.GetAlpha();
-	glm::vec4 sunDirection(0.0f);
-	sunDirection[0] = sinf(angle);
-	sunDirection[1] = cosf(angle);
-
-	//Keep the sun from being perfectly centered overhead.
-	sunDirection = glm::rotate(glm::mat4(1.0f), 5.0f, glm::vec3(0.0f, 1.0f, 0.0f)) * sunDirection;
-
-	return sunDirection;
+	return m_frame.sunlightDirection;
 }
 
 glm::vec4 LightManager::GetSunlightIntensity() const
 {
-	return m_sunlightInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	return m_frame.sunlightIntensity;
 }
 
 glm::vec4 LightManager::GetMoonlightIntensity() const
 {
-	return m_moonlightInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	return m_frame.moonlightIntensity;
 }
 
 int LightManager::GetNumberOfPointLights() const
 {
-	return m_lightPos.size();
+	return (int)m_lightPath.size();
 }
 
 glm::vec3 LightManager::GetWorldLightPosition( int lightIx ) const
 {
-	return m_lightPos[lightIx].Interpolate(m_lightTimers[lightIx].GetAlpha());
+	return glm::vec3(m_lightPosX[lightIx], m_lightPosY[lightIx], m_lightPosZ[lightIx]);
 }
 
 void LightManager::SetPointLightIntensity( int iLightIx, const glm::vec4 &intensity )
@@ -382,12 +520,12 @@ float LightManager::GetTimerValue( const std::string &timerName ) const
 
 glm::vec4 LightManager::GetBackgroundColor() const
 {
-	return m_backgroundInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	return m_frame.backgroundColor;
 }
 
 float LightManager::GetMaxIntensity() const
 {
-	return m_maxIntensityInterpolator.Interpolate(m_sunTimer.GetAlpha());
+	return m_frame.maxIntensity;
 }
 
 float LightManager::GetSunTime() const
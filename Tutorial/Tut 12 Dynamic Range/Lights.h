@@ -7,6 +7,7 @@
 #define LIGHTS_H
 
 #include <map>
+#include <algorithm>
 #include "../framework/Timer.h"
 #include <glm/glm.hpp>
 
@@ -17,6 +18,26 @@ typedef std::vector<LightVectorData> LightVector;
 
 namespace Framework
 {
+	//Where an alpha falls among an interpolator's keys: the index of the key that ends
+	//its segment, and how far through that segment it is.
+	struct InterpolatorPosition
+	{
+		size_t segment;
+		float sectionAlpha;
+	};
+
+	//Looks fAlpha up in a table of values evenly spaced over [0, 1], blending the two
+	//entries either side of it. The table must have at least two entries.
+	template<typename ValueType>
+	ValueType InterpolateTable(const std::vector<ValueType> &table, float fAlpha)
+	{
+		float tablePos = glm::clamp(fAlpha, 0.0f, 1.0f) * (table.size() - 1);
+		size_t entry = std::min((size_t)tablePos, table.size() - 2);
+		float entryAlpha = tablePos - entry;
+
+		return table[entry] * (1.0f - entryAlpha) + table[entry + 1] * entryAlpha;
+	}
+
 	template<typename ValueType>
 	class WeightedLinearInterpolator
 	{
@@ -27,32 +48,40 @@ namespace Framework
 
 		ValueType Interpolate(float fAlpha) const
 		{
-			if(m_values.empty())
-				return ValueType();
-			if(m_values.size() == 1)
-				return m_values[0].data;
+			return Interpolate(Locate(fAlpha));
+		}
 
-			//Find which segment we are within.
-			size_t segment = 1;
-			for(; segment < m_values.size(); ++segment)
-			{
-				if(fAlpha < m_values[segment].weight)
-					break;
-			}
+		//Interpolators whose keys have the same weights can share one Locate().
+		InterpolatorPosition Locate(float fAlpha) const
+		{
+			InterpolatorPosition pos = {m_values.size(), 0.0f};
+			if(m_values.size() < 2)
+				return pos;
 
-			if(segment == m_values.size())
-				return m_values.back().data;
+			pos.segment = FindSegment(fAlpha);
+			if(pos.segment == m_values.size())
+				return pos;
 
-			float sectionAlpha = fAlpha - m_values[segment - 1].weight;
-			sectionAlpha /= m_values[segment].weight - m_values[segment - 1].weight;
+			pos.sectionAlpha = fAlpha - m_values[pos.segment - 1].weight;
+			pos.sectionAlpha /= m_values[pos.segment].weight - m_values[pos.segment - 1].weight;
+			return pos;
+		}
 
-			float invSecAlpha = 1.0f - sectionAlpha;
+		ValueType Interpolate(const InterpolatorPosition &pos) const
+		{
+			if(m_values.empty())
+				return ValueType();
+			if(m_values.size() == 1 || pos.segment >= m_values.size())
+				return m_values.back().data;
 
-			return m_values[segment - 1].data * invSecAlpha + m_values[segment].data * sectionAlpha;
+			float invSecAlpha = 1.0f - pos.sectionAlpha;
+
+			return m_values[pos.segment - 1].data * invSecAlpha +
+				m_values[pos.segment].data * pos.sectionAlpha;
 		}
 
 	protected:
-		WeightedLinearInterpolator() {}
+		WeightedLinearInterpolator() : m_cursor(1) {}
 
 		struct Data
 		{
@@ -61,6 +90,38 @@ namespace Framework
 		};
 
 		std::vector<Data> m_values;
+
+	private:
+		//The segment found by the last lookup. Callers mostly ask for the same alpha
+		//several times a frame, or one a little later, so it is checked before searching.
+		mutable size_t m_cursor;
+
+		static bool AlphaBefore(float fAlpha, const Data &value) {return fAlpha < value.weight;}
+
+		//Returns the index of the value that ends fAlpha's segment: the first one past
+		//m_values[0] with a greater weight, or m_values.size() if fAlpha is past them all.
+		//The weights must not decrease.
+		size_t FindSegment(float fAlpha) const
+		{
+			const size_t numValues = m_values.size();
+			if(m_cursor < numValues && fAlpha < m_values[m_cursor].weight &&
+				m_values[m_cursor - 1].weight <= fAlpha)
+				return m_cursor;
+
+			if(m_cursor + 1 < numValues && fAlpha < m_values[m_cursor + 1].weight &&
+				m_values[m_cursor].weight <= fAlpha)
+			{
+				++m_cursor;
+				return m_cursor;
+			}
+
+			size_t segment = std::upper_bound(m_values.begin() + 1, m_values.end(),
+				fAlpha, AlphaBefore) - m_values.begin();
+
+			if(segment < numValues)
+				m_cursor = segment;
+			return segment;
+		}
 	};
 
 	template<typename ValueType>
@@ -162,10 +223,69 @@ namespace Framework
 			: m_totalDist(0.0f)
 		{}
 
+		using WeightedLinearInterpolator<ValueType>::Interpolate;
+
+		//Once baked, this is a table lookup and one lerp rather than a segment search.
+		ValueType Interpolate(float fAlpha) const
+		{
+			if(m_table.empty())
+				return WeightedLinearInterpolator<ValueType>::Interpolate(fAlpha);
+
+			return InterpolateTable(m_table, fAlpha);
+		}
+
+		//Resamples the path into a table of points evenly spaced in alpha. The table
+		//cuts the corners at the keys, so the number of samples is doubled until no key
+		//is further than maxError from the table's path, or until maxSamples is reached.
+		//Returns the largest error left. SetValues() throws the table away.
+		float Bake(float maxError, size_t maxSamples = 4096)
+		{
+			m_table.clear();
+			if(this->m_values.size() < 2)
+				return 0.0f;
+			if(maxSamples < 2)
+				maxSamples = 2;
+
+			float error = 0.0f;
+			for(size_t numSamples = 2 * this->m_values.size(); ; numSamples *= 2)
+			{
+				if(numSamples > maxSamples)
+					numSamples = maxSamples;
+
+				std::vector<ValueType> table(numSamples);
+				for(size_t sample = 0; sample < numSamples; ++sample)
+				{
+					table[sample] = WeightedLinearInterpolator<ValueType>::Interpolate(
+						sample / (float)(numSamples - 1));
+				}
+
+				//Both paths are straight between a key and a table sample, so the
+				//furthest they get apart is at one of the keys.
+				m_table.swap(table);
+				error = 0.0f;
+				for(size_t key = 0; key < this->m_values.size(); ++key)
+				{
+					error = std::max(error, distance(this->m_values[key].data,
+						Interpolate(this->m_values[key].weight)));
+				}
+
+				if(error <= maxError || numSamples == maxSamples)
+					break;
+			}
+
+			return error;
+		}
+
+		void Unbake() {m_table.clear();}
+		bool IsBaked() const {return !m_table.empty();}
+		//Empty unless baked.
+		const std::vector<ValueType> &GetTable() const {return m_table;}
+
 		template<typename BidirectionalRange>
 		void SetValues(const BidirectionalRange &data, bool isLoop = true)
 		{
 			this->m_values.clear();
+			m_table.clear();
 
 			typename BidirectionalRange::const_iterator curr = data.begin();
 			typename BidirectionalRange::const_iterator last = data.end();
@@ -210,6 +330,261 @@ namespace Framework
 
 	private:
 		float m_totalDist;
+		std::vector<ValueType> m_table;
+	};
+
+	//The cubic Hermite curve from p1 to p2, with tangents m1 and m2 already scaled to
+	//the segment's length.
+	template<typename ValueType>
+	ValueType HermiteCurve(const ValueType &p1, const ValueType &m1,
+		const ValueType &p2, const ValueType &m2, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+
+		return p1 * (2.0f * t3 - 3.0f * t2 + 1.0f) + m1 * (t3 - 2.0f * t2 + t) +
+			p2 * (-2.0f * t3 + 3.0f * t2) + m2 * (t3 - t2);
+	}
+
+	/**
+	\brief A TimedLinearInterpolator that follows a smooth curve through its keys.
+
+	Each segment is a cubic Hermite curve. The tangent at a key points from the key before it to
+	the key after it, divided by the time between them, so keys that are unevenly spaced in time
+	still give a smooth rate of change. An unlooped path's ends use the one neighbor they have.
+	**/
+	template<typename ValueType>
+	class TimedSplineInterpolator : public TimedLinearInterpolator<ValueType>
+	{
+	public:
+		typedef ValueType value_type;
+
+		TimedSplineInterpolator() : m_isLooping(true) {}
+
+		template<typename BidirectionalRange>
+		void SetValues(const BidirectionalRange &data, bool isLooping = true)
+		{
+			TimedLinearInterpolator<ValueType>::SetValues(data, isLooping);
+			m_isLooping = isLooping;
+		}
+
+		ValueType Interpolate(float fAlpha) const
+		{
+			const size_t numValues = this->m_values.size();
+			InterpolatorPosition pos = this->Locate(fAlpha);
+			if(numValues < 2 || pos.segment >= numValues)
+				return WeightedLinearInterpolator<ValueType>::Interpolate(pos);
+
+			//A looped path repeats its first key at the end, so the neighbor past either
+			//end is one in from the other end, a whole loop away in time.
+			const size_t seg = pos.segment;
+			ValueType p0 = this->m_values[seg - 1].data;
+			float t0 = this->m_values[seg - 1].weight;
+			if(seg >= 2)
+			{
+				p0 = this->m_values[seg - 2].data;
+				t0 = this->m_values[seg - 2].weight;
+			}
+			else if(m_isLooping && numValues > 2)
+			{
+				p0 = this->m_values[numValues - 2].data;
+				t0 = this->m_values[numValues - 2].weight - 1.0f;
+			}
+
+			ValueType p3 = this->m_values[seg].data;
+			float t3 = this->m_values[seg].weight;
+			if(seg + 1 < numValues)
+			{
+				p3 = this->m_values[seg + 1].data;
+				t3 = this->m_values[seg + 1].weight;
+			}
+			else if(m_isLooping && numValues > 2)
+			{
+				p3 = this->m_values[1].data;
+				t3 = this->m_values[1].weight + 1.0f;
+			}
+
+			const ValueType &p1 = this->m_values[seg - 1].data;
+			const ValueType &p2 = this->m_values[seg].data;
+			float t1 = this->m_values[seg - 1].weight;
+			float t2 = this->m_values[seg].weight;
+			float duration = t2 - t1;
+
+			return HermiteCurve(p1, (p2 - p0) * (duration / (t2 - t0)),
+				p2, (p3 - p1) * (duration / (t3 - t1)), pos.sectionAlpha);
+		}
+
+	private:
+		bool m_isLooping;
+	};
+
+	/**
+	\brief Moves along a Catmull-Rom spline through the values at a constant velocity.
+
+	This is the curved counterpart of ConstVelLinearInterpolator, and needs the same free "distance"
+	function. A spline's speed varies along each segment, so SetValues measures the curve and
+	builds a table that maps alpha, as a fraction of the total length, onto the spline's own
+	parameter. Interpolate is then a table lookup followed by one curve evaluation.
+	**/
+	template<typename ValueType>
+	class ConstVelSplineInterpolator
+	{
+	public:
+		typedef ValueType value_type;
+
+		explicit ConstVelSplineInterpolator()
+			: m_totalDist(0.0f)
+			, m_isLoop(true)
+		{}
+
+		//samplesPerSegment sets both how finely the curve is measured and the size of
+		//the alpha table.
+		template<typename BidirectionalRange>
+		void SetValues(const BidirectionalRange &data, bool isLoop = true,
+			size_t samplesPerSegment = 16)
+		{
+			m_keys.assign(data.begin(), data.end());
+			m_isLoop = isLoop;
+			m_params.clear();
+			m_table.clear();
+			m_totalDist = 0.0f;
+
+			if(NumSegments() == 0)
+				return;
+			if(samplesPerSegment < 1)
+				samplesPerSegment = 1;
+
+			//Measure the curve as a polyline through evenly spaced parameters.
+			const size_t numSamples = NumSegments() * samplesPerSegment + 1;
+			std::vector<float> lengths(numSamples, 0.0f);
+			ValueType prev = Evaluate(0.0f);
+			for(size_t sample = 1; sample < numSamples; ++sample)
+			{
+				ValueType curr = Evaluate(sample / (float)samplesPerSegment);
+				m_totalDist += distance(prev, curr);
+				lengths[sample] = m_totalDist;
+				prev = curr;
+			}
+
+			//Invert it: for evenly spaced lengths, find the parameter that reaches each.
+			m_params.resize(numSamples);
+			size_t sample = 0;
+			for(size_t entry = 0; entry < numSamples; ++entry)
+			{
+				float targetDist = m_totalDist * entry / (float)(numSamples - 1);
+				while(sample + 2 < numSamples && lengths[sample + 1] <= targetDist)
+					++sample;
+
+				float span = lengths[sample + 1] - lengths[sample];
+				float spanAlpha = span > 0.0f ? (targetDist - lengths[sample]) / span : 0.0f;
+				spanAlpha = glm::clamp(spanAlpha, 0.0f, 1.0f);
+				m_params[entry] = (sample + spanAlpha) / samplesPerSegment;
+			}
+		}
+
+		ValueType Interpolate(float fAlpha) const
+		{
+			if(m_keys.empty())
+				return ValueType();
+			if(!m_table.empty())
+				return InterpolateTable(m_table, fAlpha);
+			if(m_params.empty())
+				return m_keys[0];
+
+			return Evaluate(InterpolateTable(m_params, fAlpha));
+		}
+
+		//Resamples the curve into a table of points evenly spaced in alpha, as
+		//ConstVelLinearInterpolator::Bake does, so that Interpolate is one lerp. The table's
+		//chords cut inside the curve, so the number of samples is doubled until no point of
+		//the curve halfway between two samples is further than maxError from their chord, or
+		//until maxSamples is reached. Returns the largest error left. SetValues() throws the
+		//table away.
+		float Bake(float maxError, size_t maxSamples = 4096)
+		{
+			m_table.clear();
+			if(m_params.empty())
+				return 0.0f;
+			if(maxSamples < 2)
+				maxSamples = 2;
+
+			float error = 0.0f;
+			for(size_t numSamples = 2 * NumSegments() + 1; ; numSamples *= 2)
+			{
+				if(numSamples > maxSamples)
+					numSamples = maxSamples;
+
+				std::vector<ValueType> table(numSamples);
+				for(size_t sample = 0; sample < numSamples; ++sample)
+					table[sample] = Interpolate(sample / (float)(numSamples - 1));
+
+				error = 0.0f;
+				for(size_t sample = 1; sample < numSamples; ++sample)
+				{
+					ValueType curve = Interpolate((sample - 0.5f) / (numSamples - 1));
+					error = std::max(error,
+						distance(curve, (table[sample - 1] + table[sample]) * 0.5f));
+				}
+
+				if(error <= maxError || numSamples == maxSamples)
+				{
+					m_table.swap(table);
+					break;
+				}
+			}
+
+			return error;
+		}
+
+		void Unbake() {m_table.clear();}
+		bool IsBaked() const {return !m_table.empty();}
+		//Empty unless baked.
+		const std::vector<ValueType> &GetTable() const {return m_table;}
+
+		size_t NumSegments() const
+		{
+			if(m_keys.size() < 2)
+				return 0;
+			return m_isLoop ? m_keys.size() : m_keys.size() - 1;
+		}
+
+		float distance(const glm::vec3 &lhs, const glm::vec3 &rhs) const
+		{
+			return glm::length(rhs - lhs);
+		}
+
+		float Distance() const {return m_totalDist;}
+
+	private:
+		std::vector<ValueType> m_keys;
+		std::vector<float> m_params;	//The spline parameter at evenly spaced alphas.
+		std::vector<ValueType> m_table;	//Points at evenly spaced alphas, once baked.
+		float m_totalDist;
+		bool m_isLoop;
+
+		//Wraps around a looped path, and repeats the end keys of an open one.
+		const ValueType &Key(int keyIx) const
+		{
+			const int numKeys = (int)m_keys.size();
+			if(m_isLoop)
+				return m_keys[((keyIx % numKeys) + numKeys) % numKeys];
+
+			return m_keys[glm::clamp(keyIx, 0, numKeys - 1)];
+		}
+
+		//param runs from 0 to NumSegments(); its integer part picks the segment.
+		ValueType Evaluate(float param) const
+		{
+			int segment = std::min((int)param, (int)NumSegments() - 1);
+			float t = param - segment;
+
+			const ValueType &p0 = Key(segment - 1);
+			const ValueType &p1 = Key(segment);
+			const ValueType &p2 = Key(segment + 1);
+			const ValueType &p3 = Key(segment + 2);
+
+			return HermiteCurve(p1, (p2 - p0) * 0.5f, p2, (p3 - p1) * 0.5f, t);
+		}
 	};
 }
 
@@ -269,6 +644,12 @@ struct SunlightValueHDR
 	float maxIntensity;
 };
 
+enum LightPathType
+{
+	LIGHT_PATH_LINEAR,	//Straight lines between the keys.
+	LIGHT_PATH_SPLINE,	//A Catmull-Rom spline through the keys.
+};
+
 enum TimerTypes
 {
 	TIMER_SUN,
@@ -304,6 +685,17 @@ public:
 	glm::vec4 GetSunlightIntensity() const;
 	glm::vec4 GetMoonlightIntensity() const;
 
+	//Returns a handle for AddPointLight(). Any number of lights can share a path. The path is
+	//a loop through the positions, travelled at a constant speed. A spline path needs far
+	//fewer keys to look round than a linear one; either way it is baked into a table of
+	//points, so the two cost the same to update.
+	int AddLightPath(const std::vector<glm::vec3> &positions,
+		LightPathType eType = LIGHT_PATH_LINEAR);
+	//The light goes around its path once every loopDuration seconds, starting phase of the
+	//way around. Returns the light's index. Only the first NUMBER_OF_POINT_LIGHTS lights
+	//go into the light blocks.
+	int AddPointLight(int pathHandle, float loopDuration, float phase, const glm::vec4 &intensity);
+
 	int GetNumberOfPointLights() const;
 	glm::vec3 GetWorldLightPosition(int iLightIx) const;
 	void SetPointLightIntensity(int iLightIx, const glm::vec4 &intensity);
@@ -314,7 +706,6 @@ public:
 	float GetSunTime() const;
 
 private:
-	typedef Framework::ConstVelLinearInterpolator<glm::vec3> LightInterpolator;
 	typedef std::map<std::string, Framework::Timer> ExtraTimerMap;
 
 	Framework::Timer m_sunTimer;
@@ -324,10 +715,47 @@ private:
 	Framework::TimedLinearInterpolator<glm::vec4> m_moonlightInterpolator;
 	Framework::TimedLinearInterpolator<float> m_maxIntensityInterpolator;
 
-	std::vector<LightInterpolator> m_lightPos;
+	//The point lights, one array per property. All of them run off m_lightTimer: a
+	//light's alpha along its path is frac(time * rate + phase).
+	Framework::Timer m_lightTimer;
+	std::vector<std::vector<glm::vec3> > m_lightPaths;	//Each path's baked table.
+	std::vector<int> m_lightPath;
+	std::vector<float> m_lightRate;
+	std::vector<float> m_lightPhase;
 	std::vector<glm::vec4> m_lightIntensity;
-	std::vector<Framework::Timer> m_lightTimers;
+
+	//Results of the last update.
+	std::vector<float> m_lightAlpha;
+	std::vector<float> m_lightPosX;
+	std::vector<float> m_lightPosY;
+	std::vector<float> m_lightPosZ;
+
 	ExtraTimerMap m_extraTimers;
+
+	//Every interpolated sun value for the current timer values. The getters read these, so
+	//each interpolator is evaluated once per UpdateTime() rather than once per getter.
+	struct FrameValues
+	{
+		glm::vec4 ambientIntensity;
+		glm::vec4 backgroundColor;
+		glm::vec4 sunlightIntensity;
+		glm::vec4 moonlightIntensity;
+		float maxIntensity;
+		glm::vec4 sunlightDirection;
+	};
+
+	FrameValues m_frame;
+
+	//True when the moonlight and max intensity keys have the same times as the ambient
+	//ones, so all the sun interpolators can share one segment search.
+	bool m_bSunKeysShared;
+
+	//Must be called after anything that changes a timer or a set of keys.
+	void UpdateFrameValues();
+	void UpdatePointLights();
+
+	//Writes the first NUMBER_OF_POINT_LIGHTS lights, in camera space.
+	void FillPointLights(PerLight *pLights, const glm::mat4 &worldToCameraMat) const;
 };
 
 #endif //LIGHTS_H
@@ -0,0 +1,172 @@
+//This file is licensed under the MIT License.
+
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include "RenderQueue.h"
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	bool SameMaterial(const DrawItem &lhs, const DrawItem &rhs)
+	{
+		return lhs.materialBlockIndex == rhs.materialBlockIndex &&
+			lhs.materialBuffer == rhs.materialBuffer &&
+			lhs.materialOffset == rhs.materialOffset &&
+			lhs.materialSize == rhs.materialSize;
+	}
+
+	bool SameMesh(const DrawItem &lhs, const DrawItem &rhs)
+	{
+		return lhs.pMesh == rhs.pMesh && lhs.pPackedMesh == rhs.pPackedMesh &&
+			lhs.meshName == rhs.meshName;
+	}
+}
+
+RenderQueue::RenderQueue()
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void RenderQueue::Add( const DrawItem &item )
+{
+	m_items.push_back(item);
+}
+
+unsigned int RenderQueue::CalcKey( const DrawItem &item )
+{
+	size_t programId = 0;
+	for(; programId < m_programs.size(); programId++)
+	{
+		if(m_programs[programId] == item.program)
+			break;
+	}
+	if(programId == m_programs.size())
+		m_programs.push_back(item.program);
+
+	size_t materialId = 0;
+	for(; materialId < m_materials.size(); materialId++)
+	{
+		if(SameMaterial(*m_materials[materialId], item))
+			break;
+	}
+	if(materialId == m_materials.size())
+		m_materials.push_back(&item);
+
+	size_t meshId = 0;
+	for(; meshId < m_meshes.size(); meshId++)
+	{
+		if(SameMesh(*m_meshes[meshId], item))
+			break;
+	}
+	if(meshId == m_meshes.size())
+		m_meshes.push_back(&item);
+
+	assert(programId < (1 << PROGRAM_BITS));
+	assert(materialId < (1 << MATERIAL_BITS));
+	assert(meshId < (1 << MESH_BITS));
+
+	return (unsigned int)((programId << (MATERIAL_BITS + MESH_BITS)) |
+		(materialId << MESH_BITS) | meshId);
+}
+
+//Least-significant-digit radix sort, a byte at a time. It is stable, so items that share
+//a key are drawn in the order they were added. Passes where every key has the same
+//byte would not move anything, so they are skipped.
+void RenderQueue::SortEntries()
+{
+	const size_t numEntries = m_entries.size();
+	m_sortScratch.resize(numEntries);
+
+	SortEntry *pSrc = &m_entries[0];
+	SortEntry *pDst = &m_sortScratch[0];
+
+	for(int shift = 0; shift < 32; shift += 8)
+	{
+		size_t offsets[256] = {0};
+		for(size_t ix = 0; ix < numEntries; ix++)
+			++offsets[(pSrc[ix].key >> shift) & 0xFF];
+
+		if(offsets[(pSrc[0].key >> shift) & 0xFF] == numEntries)
+			continue;
+
+		size_t total = 0;
+		for(int digit = 0; digit < 256; digit++)
+		{
+			size_t count = offsets[digit];
+			offsets[digit] = total;
+			total += count;
+		}
+
+		for(size_t ix = 0; ix < numEntries; ix++)
+			pDst[offsets[(pSrc[ix].key >> shift) & 0xFF]++] = pSrc[ix];
+
+		std::swap(pSrc, pDst);
+	}
+
+	if(pSrc != &m_entries[0])
+		m_entries.swap(m_sortScratch);
+}
+
+void RenderQueue::Submit( GLStateCache &state )
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	if(m_items.empty())
+		return;
+
+	//Keys are made here rather than in Add(), so that the pointers kept in
+	//m_materials and m_meshes are not moved by m_items growing.
+	m_entries.resize(m_items.size());
+	for(size_t ix = 0; ix < m_items.size(); ix++)
+	{
+		m_entries[ix].key = CalcKey(m_items[ix]);
+		m_entries[ix].item = (unsigned int)ix;
+	}
+
+	SortEntries();
+
+	const DrawItem *pPrevItem = NULL;
+
+	for(size_t ix = 0; ix < m_entries.size(); ix++)
+	{
+		const DrawItem &item = m_items[m_entries[ix].item];
+
+		if(!pPrevItem || item.program != pPrevItem->program)
+			++m_stats.numProgramChanges;
+		if(!pPrevItem || !SameMaterial(*pPrevItem, item))
+			++m_stats.numMaterialChanges;
+		pPrevItem = &item;
+
+		state.UseProgram(item.program);
+		state.BindUniformBufferRange(item.materialBlockIndex, item.materialBuffer,
+			item.materialOffset, item.materialSize);
+
+		glUniformMatrix4fv(item.modelToCameraMatrixUnif, 1, GL_FALSE,
+			glm::value_ptr(item.modelToCameraMatrix));
+		glUniformMatrix3fv(item.normalModelToCameraMatrixUnif, 1, GL_FALSE,
+			glm::value_ptr(item.normalMatrix));
+
+		if(item.pPackedMesh)
+		{
+			if(item.meshName.empty())
+				item.pPackedMesh->Render();
+			else
+				item.pPackedMesh->Render(item.meshName, item.lod);
+		}
+		else
+		{
+			if(item.meshName.empty())
+				item.pMesh->Render();
+			else
+				item.pMesh->Render(item.meshName);
+		}
+
+		++m_stats.numDraws;
+	}
+
+	m_items.clear();
+	m_programs.clear();
+	m_materials.clear();
+	m_meshes.clear();
+}
@@ -0,0 +1,92 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glload/gl_3_3.h>
+#include "../framework/Mesh.h"
+#include "../framework/PackedMesh.h"
+#include "GLStateCache.h"
+
+//Everything needed to draw one object. The queue does not own the program, buffer or mesh.
+struct DrawItem
+{
+	GLuint program;
+	GLuint modelToCameraMatrixUnif;
+	GLuint normalModelToCameraMatrixUnif;
+
+	//The range of the uniform buffer holding the material, bound to materialBlockIndex.
+	GLuint materialBlockIndex;
+	GLuint materialBuffer;
+	GLintptr materialOffset;
+	GLsizeiptr materialSize;
+
+	//Exactly one of these is set.
+	const Framework::Mesh *pMesh;
+	const Framework::PackedMesh *pPackedMesh;
+	std::string meshName;	//Empty to draw the whole mesh.
+	int lod;				//The packed mesh's level of detail, with a meshName.
+
+	glm::mat4 modelToCameraMatrix;
+	glm::mat3 normalMatrix;
+};
+
+//Collects a frame's draws, then submits them sorted by program, then material, then mesh.
+//Bindings go through a GLStateCache, which drops the ones that match the previous draw.
+class RenderQueue
+{
+public:
+	struct Stats
+	{
+		int numDraws;
+		int numProgramChanges;
+		int numMaterialChanges;
+	};
+
+	RenderQueue();
+
+	void Add(const DrawItem &item);
+
+	//Draws everything added since the last Submit() and empties the queue.
+	//The last draw's program and material stay bound.
+	void Submit(GLStateCache &state);
+
+	//Counts are for the most recent Submit().
+	const Stats &GetStats() const {return m_stats;}
+
+private:
+	//The key's bits, from the top: program, material, mesh. Each is the order in which
+	//that state was first seen this frame.
+	enum
+	{
+		MESH_BITS = 12,
+		MATERIAL_BITS = 12,
+		PROGRAM_BITS = 8,
+	};
+
+	struct SortEntry
+	{
+		unsigned int key;
+		unsigned int item;
+	};
+
+	std::vector<DrawItem> m_items;
+	std::vector<SortEntry> m_entries;
+	std::vector<SortEntry> m_sortScratch;
+
+	//The states seen this frame; an item's index in each is its part of the key.
+	std::vector<GLuint> m_programs;
+	std::vector<const DrawItem *> m_materials;
+	std::vector<const DrawItem *> m_meshes;
+
+	Stats m_stats;
+
+	unsigned int CalcKey(const DrawItem &item);
+	void SortEntries();
+};
+
+#endif //RENDER_QUEUE_H
@@ -4,8 +4,6 @@
 
 
 #include "Scene.h"
-#include <string.h>
-#include <glm/gtc/type_ptr.hpp>
 
 //One for the ground, and one for each of the 5 objects.
 const int MATERIAL_COUNT = 6;
@@ -46,42 +44,36 @@ static void GetMaterials( std::vector<MaterialBlock> &materials )
 }
 
 Scene::Scene()
-	: m_pTerrainMesh(new Framework::Mesh("Ground.xml"))
+	: m_pTerrainMesh(new Framework::PackedMesh("Ground.xml", Framework::PACKED_MESH_QUANTIZE))
 	, m_pCubeMesh(new Framework::Mesh("UnitCube.xml"))
 	, m_pTetraMesh(new Framework::Mesh("UnitTetrahedron.xml"))
 	, m_pCylMesh(new Framework::Mesh("UnitCylinder.xml"))
-	, m_pSphereMesh(new Framework::Mesh("UnitSphere.xml"))
+	, m_pSphereMesh(new Framework::PackedMesh("UnitSphere.xml", Framework::PACKED_MESH_LODS))
+	, m_lodProjectionScale(0.0f)
+	, m_materialPool(MATERIAL_COUNT)
+	, m_normalMatrices(MATERIAL_COUNT)
 {
-	//Align the size of each MaterialBlock to the uniform buffer alignment.
-	int uniformBufferAlignSize = 0;
-	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformBufferAlignSize);
-
-	m_sizeMaterialBlock = sizeof(MaterialBlock);
-	m_sizeMaterialBlock += uniformBufferAlignSize -
-		(m_sizeMaterialBlock % uniformBufferAlignSize);
-
-	int sizeMaterialUniformBuffer = m_sizeMaterialBlock * MATERIAL_COUNT;
-
 	std::vector<MaterialBlock> materials;
 	GetMaterials(materials);
 	assert(materials.size() == MATERIAL_COUNT);
 
-	std::vector<GLubyte> mtlBuffer;
-	mtlBuffer.resize(sizeMaterialUniformBuffer, 0);
-
-	GLubyte *bufferPtr = &mtlBuffer[0];
-
 	for(size_t mtl = 0; mtl < materials.size(); ++mtl)
-		memcpy(bufferPtr + (mtl * m_sizeMaterialBlock), &materials[mtl], sizeof(MaterialBlock));
+		m_materialHandles.push_back(m_materialPool.Allocate(materials[mtl]));
 
-	glGenBuffers(1, &m_materialUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, m_materialUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeMaterialUniformBuffer, bufferPtr, GL_STATIC_DRAW);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_materialPool.Upload();
+}
+
+void Scene::SetLodProjection( float fovDeg, int viewportHeight )
+{
+	const float fovRad = fovDeg * 3.14159f / 180.0f;
+	m_lodProjectionScale = viewportHeight / (2.0f * tanf(fovRad / 2.0f));
 }
 
 void Scene::Draw( glutil::MatrixStack &modelMatrix, int materialBlockIndex, float alphaTetra )
 {
+	m_normalMatrices.ResetCounts();
+	m_materialPool.Upload();
+
 	//Render the ground plane.
 	{
 		glutil::PushStack push(modelMatrix);
@@ -148,50 +140,70 @@ void Scene::Draw( glutil::MatrixStack &modelMatrix, int materialBlockIndex, floa
 		DrawObject(m_pSphereMesh.get(), "lit", GetProgram(LP_MTL_COLOR_DIFFUSE_SPECULAR),
 			materialBlockIndex, 5, modelMatrix);
 	}
+
+	m_renderQueue.Submit(GetStateCache());
 }
 
 void Scene::DrawObject( const Framework::Mesh *pMesh, const ProgramData &prog,
 					   int materialBlockIndex, int mtlIx,
 					   const glutil::MatrixStack &modelMatrix )
 {
-	glBindBufferRange(GL_UNIFORM_BUFFER, materialBlockIndex, m_materialUniformBuffer,
-		mtlIx * m_sizeMaterialBlock, sizeof(MaterialBlock));
-
-	glm::mat3 normMatrix(modelMatrix.Top());
-	normMatrix = glm::transpose(glm::inverse(normMatrix));
+	DrawObject(pMesh, std::string(), prog, materialBlockIndex, mtlIx, modelMatrix);
+}
 
-	glUseProgram(prog.theProgram);
-	glUniformMatrix4fv(prog.modelToCameraMatrixUnif, 1, GL_FALSE,
-		glm::value_ptr(modelMatrix.Top()));
+void Scene::DrawObject(const Framework::Mesh *pMesh, const std::string &meshName, 
+					   const ProgramData &prog, int materialBlockIndex, int mtlIx,
+					   const glutil::MatrixStack &modelMatrix)
+{
+	DrawItem item = MakeDrawItem(prog, materialBlockIndex, mtlIx, modelMatrix);
+	item.pMesh = pMesh;
+	item.meshName = meshName;
 
-	glUniformMatrix3fv(prog.normalModelToCameraMatrixUnif, 1, GL_FALSE,
-		glm::value_ptr(normMatrix));
-	pMesh->Render();
-	glUseProgram(0);
+	m_renderQueue.Add(item);
+}
 
-	glBindBufferBase(GL_UNIFORM_BUFFER, materialBlockIndex, 0);
+void Scene::DrawObject( const Framework::PackedMesh *pMesh, const ProgramData &prog,
+					   int materialBlockIndex, int mtlIx,
+					   const glutil::MatrixStack &modelMatrix )
+{
+	DrawObject(pMesh, std::string(), prog, materialBlockIndex, mtlIx, modelMatrix);
 }
 
-void Scene::DrawObject(const Framework::Mesh *pMesh, const std::string &meshName, 
+void Scene::DrawObject( const Framework::PackedMesh *pMesh, const std::string &meshName,
 					   const ProgramData &prog, int materialBlockIndex, int mtlIx,
-					   const glutil::MatrixStack &modelMatrix)
+					   const glutil::MatrixStack &modelMatrix )
+{
+	DrawItem item = MakeDrawItem(prog, materialBlockIndex, mtlIx, modelMatrix);
+	item.pPackedMesh = pMesh;
+	item.meshName = meshName;
+	if(m_lodProjectionScale > 0.0f)
+		item.lod = pMesh->SelectLod(modelMatrix.Top(), m_lodProjectionScale);
+	item.modelToCameraMatrix *= pMesh->GetPositionDecodeMatrix();
+
+	m_renderQueue.Add(item);
+}
+
+DrawItem Scene::MakeDrawItem( const ProgramData &prog, int materialBlockIndex, int mtlIx,
+							 const glutil::MatrixStack &modelMatrix )
 {
-	glBindBufferRange(GL_UNIFORM_BUFFER, materialBlockIndex, m_materialUniformBuffer,
-		mtlIx * m_sizeMaterialBlock, sizeof(MaterialBlock));
+	DrawItem item;
+	item.program = prog.theProgram;
+	item.modelToCameraMatrixUnif = prog.modelToCameraMatrixUnif;
+	item.normalModelToCameraMatrixUnif = prog.normalModelToCameraMatrixUnif;
 
-	glm::mat3 normMatrix(modelMatrix.Top());
-	normMatrix = glm::transpose(glm::inverse(normMatrix));
+	item.materialBlockIndex = materialBlockIndex;
+	item.materialBuffer = m_materialPool.GetBuffer();
+	item.materialOffset = m_materialPool.GetOffset(m_materialHandles[mtlIx]);
+	item.materialSize = m_materialPool.GetBlockSize();
 
-	glUseProgram(prog.theProgram);
-	glUniformMatrix4fv(prog.modelToCameraMatrixUnif, 1, GL_FALSE,
-		glm::value_ptr(modelMatrix.Top()));
+	item.pMesh = NULL;
+	item.pPackedMesh = NULL;
+	item.lod = 0;
 
-	glUniformMatrix3fv(prog.normalModelToCameraMatrixUnif, 1, GL_FALSE,
-		glm::value_ptr(normMatrix));
-	pMesh->Render(meshName);
-	glUseProgram(0);
+	item.modelToCameraMatrix = modelMatrix.Top();
+	item.normalMatrix = m_normalMatrices.Get(mtlIx, modelMatrix.Top());
 
-	glBindBufferBase(GL_UNIFORM_BUFFER, materialBlockIndex, 0);
+	return item;
 }
 
 
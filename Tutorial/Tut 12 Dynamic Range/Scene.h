@@ -7,11 +7,16 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glload/gl_3_3.h>
 #include <glutil/glutil.h>
 #include "../framework/framework.h"
 #include "../framework/Mesh.h"
+#include "../framework/NormalMatrixCache.h"
+#include "../framework/PackedMesh.h"
+#include "RenderQueue.h"
+#include "UniformBlockPool.h"
 
 struct ProgramData
 {
@@ -36,24 +41,52 @@ public:
 
 	void Draw(glutil::MatrixStack &modelMatrix, int materialBlockIndex, float alphaTetra);
 
+	//Levels of detail are picked for a viewport this many pixels high, seen with this
+	//vertical field of view. Until it is set, every mesh is drawn in full.
+	void SetLodProjection(float fovDeg, int viewportHeight);
+
 	Framework::Mesh *GetCubeMesh() {return m_pCubeMesh.get();}
-	Framework::Mesh *GetSphereMesh() {return m_pSphereMesh.get();}
+	Framework::PackedMesh *GetSphereMesh() {return m_pSphereMesh.get();}
+
+	//Counts are for the most recent Draw().
+	const Framework::NormalMatrixCache &GetNormalMatrices() const {return m_normalMatrices;}
+	const RenderQueue::Stats &GetRenderStats() const {return m_renderQueue.GetStats();}
 
 private:
-	std::auto_ptr<Framework::Mesh> m_pTerrainMesh;
+	std::auto_ptr<Framework::PackedMesh> m_pTerrainMesh;
 	std::auto_ptr<Framework::Mesh> m_pCubeMesh;
 	std::auto_ptr<Framework::Mesh> m_pTetraMesh;
 	std::auto_ptr<Framework::Mesh> m_pCylMesh;
-	std::auto_ptr<Framework::Mesh> m_pSphereMesh;
+	std::auto_ptr<Framework::PackedMesh> m_pSphereMesh;
+
+	//The viewport's height over 2 tan(fovY / 2); 0 draws every level 0.
+	float m_lodProjectionScale;
+
+	//Indexed by material; Draw() uploads any changes before queueing anything.
+	UniformBlockPool<MaterialBlock> m_materialPool;
+	std::vector<UniformBlockPool<MaterialBlock>::Handle> m_materialHandles;
+
+	//One slot per object. Each object has its own material, so the material
+	//index doubles as the slot.
+	Framework::NormalMatrixCache m_normalMatrices;
 
-	int m_sizeMaterialBlock;
-	GLuint m_materialUniformBuffer;
+	//Draw() queues every object here and submits them all at the end.
+	RenderQueue m_renderQueue;
 
 	void DrawObject( const Framework::Mesh *pMesh, const ProgramData &prog,
 		int materialBlockIndex, int mtlIx, const glutil::MatrixStack &modelMatrix );
 	void DrawObject(const Framework::Mesh *pMesh, const std::string &meshName, 
 		const ProgramData &prog, int materialBlockIndex, int mtlIx,
 		const glutil::MatrixStack &modelMatrix);
+	void DrawObject(const Framework::PackedMesh *pMesh, const ProgramData &prog,
+		int materialBlockIndex, int mtlIx, const glutil::MatrixStack &modelMatrix);
+	void DrawObject(const Framework::PackedMesh *pMesh, const std::string &meshName,
+		const ProgramData &prog, int materialBlockIndex, int mtlIx,
+		const glutil::MatrixStack &modelMatrix);
+
+	//Everything but the mesh.
+	DrawItem MakeDrawItem(const ProgramData &prog, int materialBlockIndex, int mtlIx,
+		const glutil::MatrixStack &modelMatrix);
 };
 
 #include "../framework/framework.h"
@@ -73,5 +106,6 @@ enum LightingProgramTypes
 
 //Defined by the user of the Scene.
 const ProgramData &GetProgram(LightingProgramTypes eType);
+GLStateCache &GetStateCache();
 
 #endif //SCENE_H
\ No newline at end of file
@@ -0,0 +1,163 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef UNIFORM_BLOCK_POOL_H
+#define UNIFORM_BLOCK_POOL_H
+
+#include <assert.h>
+#include <string.h>
+#include <vector>
+#include <glload/gl_3_3.h>
+
+//A uniform buffer of BlockType blocks that grows as blocks are allocated. Each block
+//starts on a GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT boundary, so any one of them can be
+//bound with glBindBufferRange.
+//
+//Blocks are named by handles. Freed handles go on a free list and are reused before the
+//pool grows, so a handle's offset never changes while it is allocated. Changes are kept
+//in a CPU-side copy until Upload(), which sends only the span of blocks that changed.
+template<typename BlockType>
+class UniformBlockPool
+{
+public:
+	typedef int Handle;
+
+	explicit UniformBlockPool(int initialCapacity = 16)
+		: m_buffer(0)
+		, m_blockStride(0)
+		, m_bufferCapacity(0)
+		, m_dirtyBegin(0)
+		, m_dirtyEnd(0)
+	{
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if(alignment < 1)
+			alignment = 1;
+
+		m_blockStride = ((sizeof(BlockType) + alignment - 1) / alignment) * alignment;
+
+		m_storage.reserve(initialCapacity * m_blockStride);
+		glGenBuffers(1, &m_buffer);
+	}
+
+	~UniformBlockPool()
+	{
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	Handle Allocate(const BlockType &block)
+	{
+		Handle handle;
+		if(!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = (Handle)m_bAllocated.size();
+			m_bAllocated.push_back(false);
+			m_storage.resize(m_storage.size() + m_blockStride, 0);
+		}
+
+		m_bAllocated[handle] = true;
+		Set(handle, block);
+		return handle;
+	}
+
+	//The block's contents are left in the buffer; only the handle is given back.
+	void Free(Handle handle)
+	{
+		assert(IsAllocated(handle));
+		m_bAllocated[handle] = false;
+		m_freeHandles.push_back(handle);
+	}
+
+	const BlockType &Get(Handle handle) const
+	{
+		assert(IsAllocated(handle));
+		return *reinterpret_cast<const BlockType *>(&m_storage[handle * m_blockStride]);
+	}
+
+	void Set(Handle handle, const BlockType &block)
+	{
+		memcpy(&Edit(handle), &block, sizeof(BlockType));
+	}
+
+	//Marks the block as changed. The reference is only good until the next Allocate().
+	BlockType &Edit(Handle handle)
+	{
+		assert(IsAllocated(handle));
+		MarkDirty(handle);
+		return *reinterpret_cast<BlockType *>(&m_storage[handle * m_blockStride]);
+	}
+
+	//Sends the changed blocks to the buffer. If the pool outgrew the buffer, the buffer
+	//is re-specified with everything in it; its name stays the same.
+	void Upload()
+	{
+		const bool bGrow = m_bAllocated.size() > m_bufferCapacity;
+		if(!bGrow && m_dirtyBegin == m_dirtyEnd)
+			return;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+
+		if(bGrow)
+		{
+			m_bufferCapacity = m_storage.capacity() / m_blockStride;
+			glBufferData(GL_UNIFORM_BUFFER, m_bufferCapacity * m_blockStride, NULL, GL_DYNAMIC_DRAW);
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, m_storage.size(), &m_storage[0]);
+		}
+		else
+		{
+			GLintptr offset = m_dirtyBegin * m_blockStride;
+			glBufferSubData(GL_UNIFORM_BUFFER, offset,
+				((m_dirtyEnd - m_dirtyBegin) * m_blockStride), &m_storage[offset]);
+		}
+
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		m_dirtyBegin = m_dirtyEnd = 0;
+	}
+
+	GLuint GetBuffer() const {return m_buffer;}
+	GLintptr GetOffset(Handle handle) const {return handle * m_blockStride;}
+	GLsizeiptr GetBlockSize() const {return sizeof(BlockType);}
+
+	bool IsAllocated(Handle handle) const
+	{
+		return handle >= 0 && handle < (Handle)m_bAllocated.size() && m_bAllocated[handle];
+	}
+
+private:
+	GLuint m_buffer;
+	size_t m_blockStride;
+	size_t m_bufferCapacity;	//In blocks.
+
+	std::vector<GLubyte> m_storage;
+	std::vector<bool> m_bAllocated;
+	std::vector<Handle> m_freeHandles;
+
+	//The blocks [m_dirtyBegin, m_dirtyEnd) changed since the last Upload().
+	size_t m_dirtyBegin;
+	size_t m_dirtyEnd;
+
+	void MarkDirty(Handle handle)
+	{
+		if(m_dirtyBegin == m_dirtyEnd)
+		{
+			m_dirtyBegin = handle;
+			m_dirtyEnd = handle + 1;
+			return;
+		}
+
+		if((size_t)handle < m_dirtyBegin)
+			m_dirtyBegin = handle;
+		if((size_t)handle >= m_dirtyEnd)
+			m_dirtyEnd = handle + 1;
+	}
+
+	UniformBlockPool(const UniformBlockPool &);
+	UniformBlockPool &operator=(const UniformBlockPool &);
+};
+
+#endif //UNIFORM_BLOCK_POOL_H
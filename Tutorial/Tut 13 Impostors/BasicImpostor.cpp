@@ -13,6 +13,7 @@
 #include "../framework/framework.h"
 #include "../framework/Mesh.h"
 #include "../framework/MousePole.h"
+#include "../framework/NormalMatrixCache.h"
 #include "../framework/Timer.h"
 #include "../framework/UniformBlockArray.h"
 #include <glm/glm.hpp>
@@ -335,6 +336,9 @@ void init()
 	CreateMaterials();
 }
 
+//Every object here has its own material, so the material index is its cache slot.
+Framework::NormalMatrixCache g_normalMatrices(NUM_MATERIALS);
+
 int g_currImpostor = IMP_BASIC;
 
 void DrawSphere(glutil::MatrixStack &modelMatrix,
@@ -364,8 +368,7 @@ void DrawSphere(glutil::MatrixStack &modelMatrix,
 		modelMatrix.Translate(position);
 		modelMatrix.Scale(radius * 2.0f); //The unit sphere has a radius 0.5f.
 
-		glm::mat3 normMatrix(modelMatrix.Top());
-		normMatrix = glm::transpose(glm::inverse(normMatrix));
+		const glm::mat3 &normMatrix = g_normalMatrices.Get(material, modelMatrix.Top());
 
 		glUseProgram(g_litMeshProg.theProgram);
 		glUniformMatrix4fv(g_litMeshProg.modelToCameraMatrixUnif, 1, GL_FALSE,
@@ -436,6 +439,8 @@ void display()
 {
 	g_sphereTimer.Update();
 
+	g_normalMatrices.ResetCounts();
+
 	glClearColor(0.75f, 0.75f, 1.0f, 1.0f);
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -465,8 +470,7 @@ void display()
 			glBindBufferRange(GL_UNIFORM_BUFFER, g_materialBlockIndex, g_materialUniformBuffer,
 				MTL_TERRAIN * g_materialBlockOffset, sizeof(MaterialBlock));
 
-			glm::mat3 normMatrix(modelMatrix.Top());
-			normMatrix = glm::transpose(glm::inverse(normMatrix));
+			const glm::mat3 &normMatrix = g_normalMatrices.Get(MTL_TERRAIN, modelMatrix.Top());
 
 			glUseProgram(g_litMeshProg.theProgram);
 			glUniformMatrix4fv(g_litMeshProg.modelToCameraMatrixUnif, 1, GL_FALSE,
@@ -575,6 +579,10 @@ void keyboard(unsigned char key, int x, int y)
 	case '3': g_drawImposter[2] = !g_drawImposter[2]; break;
 	case '4': g_drawImposter[3] = !g_drawImposter[3]; break;
 
+	case 'n':
+		printf("Normal matrices: %i computed, %i reused\n",
+			g_normalMatrices.GetNumComputed(), g_normalMatrices.GetNumReused());
+		break;
 	case 'l': g_currImpostor = IMP_BASIC; break;
 	case 'j': g_currImpostor = IMP_PERSPECTIVE; break;
 	case 'h': g_currImpostor = IMP_DEPTH; break;
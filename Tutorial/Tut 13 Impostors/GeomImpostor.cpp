@@ -13,6 +13,7 @@
 #include "../framework/framework.h"
 #include "../framework/Mesh.h"
 #include "../framework/MousePole.h"
+#include "../framework/NormalMatrixCache.h"
 #include "../framework/Timer.h"
 #include "../framework/UniformBlockArray.h"
 #include <glm/glm.hpp>
@@ -373,6 +374,8 @@ struct VertexData
 	float materialIndex;
 };
 
+Framework::NormalMatrixCache g_normalMatrices;
+
 //Called to update the display.
 //You should call glutSwapBuffers after all of your rendering to display what you rendered.
 //If you need continuous updates of the screen, call glutPostRedisplay() at the end of the function.
@@ -380,6 +383,8 @@ void display()
 {
 	g_sphereTimer.Update();
 
+	g_normalMatrices.ResetCounts();
+
 	glClearColor(0.75f, 0.75f, 1.0f, 1.0f);
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -409,8 +414,7 @@ void display()
 			glBindBufferRange(GL_UNIFORM_BUFFER, g_materialBlockIndex, g_materialTerrainUniformBuffer,
 				0, sizeof(MaterialEntry));
 
-			glm::mat3 normMatrix(modelMatrix.Top());
-			normMatrix = glm::transpose(glm::inverse(normMatrix));
+			const glm::mat3 &normMatrix = g_normalMatrices.Get(modelMatrix.Top());
 
 			glUseProgram(g_litMeshProg.theProgram);
 			glUniformMatrix4fv(g_litMeshProg.modelToCameraMatrixUnif, 1, GL_FALSE,
@@ -548,6 +552,10 @@ void keyboard(unsigned char key, int x, int y)
 	case '=': g_sphereTimer.Fastforward(0.5f); break;
 	case 't': g_bDrawCameraPos = !g_bDrawCameraPos; break;
 	case 'g': g_bDrawLights = !g_bDrawLights; break;
+	case 'n':
+		printf("Normal matrices: %i computed, %i reused\n",
+			g_normalMatrices.GetNumComputed(), g_normalMatrices.GetNumReused());
+		break;
 	}
 
 	g_viewPole.CharPress(key);
@@ -16,6 +16,7 @@
 #include "../framework/framework.h"
 #include "../framework/Mesh.h"
 #include "../framework/MousePole.h"
+#include "../framework/NormalMatrixCache.h"
 #include "../framework/Timer.h"
 #include "../framework/UniformBlockArray.h"
 #include "../framework/directories.h"
@@ -443,6 +444,8 @@ glm::vec4 CalcLightPosition()
 const float g_fHalfLightDistance = 25.0f;
 const float g_fLightAttenuation = 1.0f / (g_fHalfLightDistance * g_fHalfLightDistance);
 
+Framework::NormalMatrixCache g_normalMatrices;
+
 //Called to update the display.
 //You should call glutSwapBuffers after all of your rendering to display what you rendered.
 //If you need continuous updates of the screen, call glutPostRedisplay() at the end of the function.
@@ -450,6 +453,8 @@ void display()
 {
 	g_lightTimer.Update();
 
+	g_normalMatrices.ResetCounts();
+
 	glClearColor(0.75f, 0.75f, 1.0f, 1.0f);
 	glClearDepth(1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -487,8 +492,7 @@ void display()
 			modelMatrix.ApplyMatrix(g_objtPole.CalcMatrix());
 			modelMatrix.Scale(g_bUseInfinity ? 2.0f : 4.0f);
 
-			glm::mat3 normMatrix(modelMatrix.Top());
-			normMatrix = glm::transpose(glm::inverse(normMatrix));
+			const glm::mat3 &normMatrix = g_normalMatrices.Get(modelMatrix.Top());
 
 			ProgramData &prog = g_Programs[g_eMode];
 
@@ -620,6 +624,10 @@ void keyboard(unsigned char key, int x, int y)
 	case 't': g_bDrawCameraPos = !g_bDrawCameraPos; break;
 	case 'g': g_bDrawLights = !g_bDrawLights; break;
 	case 'y': g_bUseInfinity = !g_bUseInfinity; break;
+	case 'n':
+		printf("Normal matrices: %i computed, %i reused\n",
+			g_normalMatrices.GetNumComputed(), g_normalMatrices.GetNumReused());
+		break;
 	case 32:
 		g_eMode = (ShaderMode)(g_eMode + 1);
 		g_eMode = (ShaderMode)(g_eMode % NUM_SHADER_MODES);
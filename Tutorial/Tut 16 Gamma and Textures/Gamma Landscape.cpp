@@ -18,11 +18,13 @@
 #include <glutil/Shader.h>
 #include "../framework/framework.h"
 #include "../framework/Mesh.h"
+#include "../framework/PackedMesh.h"
 #include "../framework/Timer.h"
 #include "../framework/UniformBlockArray.h"
 #include "../framework/directories.h"
 #include "../framework/MousePole.h"
 #include "../framework/Interpolators.h"
+#include "../framework/UniformRing.h"
 #include "LightEnv.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -35,6 +37,7 @@ struct ProgramData
 	GLuint theProgram;
 
 	GLuint modelToCameraMatrixUnif;
+	GLuint normalModelToCameraMatrixUnif;
 	GLuint numberOfLightsUnif;
 };
 
@@ -66,6 +69,7 @@ ProgramData LoadProgram(const std::string &strVertexShader, const std::string &s
 	ProgramData data;
 	data.theProgram = Framework::CreateProgram(shaderList);
 	data.modelToCameraMatrixUnif = glGetUniformLocation(data.theProgram, "modelToCameraMatrix");
+	data.normalModelToCameraMatrixUnif = glGetUniformLocation(data.theProgram, "normalModelToCameraMatrix");
 	data.numberOfLightsUnif = glGetUniformLocation(data.theProgram, "numberOfLights");
 
 	GLuint projectionBlock = glGetUniformBlockIndex(data.theProgram, "Projection");
@@ -112,7 +116,7 @@ struct ProjectionBlock
 };
 
 GLuint g_projectionUniformBuffer = 0;
-GLuint g_lightUniformBuffer = 0;
+glm::mat4 g_cameraToClipMatrix;	//For culling the terrain's clusters.
 GLuint g_linearTexture = 0;
 // GLuint g_gammaTexture = 0;
 
@@ -205,9 +209,14 @@ namespace
 
 LightEnv *g_pLightEnv = NULL;
 
-Framework::Mesh *g_pTerrain = NULL;
+//terrain.xml is over a megabyte of text, so it loads through its packed copy, quantized to
+//less than half the size.
+Framework::PackedMesh *g_pTerrain = NULL;
 Framework::Mesh *g_pSphere = NULL;
 
+//The light block changes every frame, so it comes from the ring rather than its own buffer.
+Framework::UniformRing *g_pUniformRing = NULL;
+
 //Called after the window and OpenGL are initialized. Called exactly once, before the main loop.
 void init()
 {
@@ -217,7 +226,8 @@ void init()
 
 		InitializePrograms();
 
-		g_pTerrain = new Framework::Mesh("terrain.xml");
+		g_pTerrain = new Framework::PackedMesh("terrain.xml",
+			Framework::PACKED_MESH_QUANTIZE | Framework::PACKED_MESH_CLUSTERS);
 		g_pSphere = new Framework::Mesh("UnitSphere.xml");
 	}
 	catch(std::exception &except)
@@ -251,15 +261,10 @@ void init()
 	glBindBufferRange(GL_UNIFORM_BUFFER, g_projectionBlockIndex, g_projectionUniformBuffer,
 		0, sizeof(ProjectionBlock));
 
-	glGenBuffers(1, &g_lightUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_STREAM_DRAW);
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_lightBlockIndex, g_lightUniformBuffer,
-		0, sizeof(LightBlock));
-
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+	g_pUniformRing = new Framework::UniformRing(sizeof(LightBlock), 1);
+
 	LoadTextures();
 	CreateSamplers();
 }
@@ -297,25 +302,33 @@ void display()
 
 	LightBlock lightData = g_pLightEnv->GetLightBlock(g_viewPole.CalcMatrix());
 
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &lightData, GL_STREAM_DRAW);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	g_pUniformRing->BeginFrame();
+	g_pUniformRing->Upload(g_lightBlockIndex, &lightData, sizeof(LightBlock));
 
 	if(g_pSphere && g_pTerrain)
 	{
 		glutil::PushStack push(modelMatrix);
 		modelMatrix.RotateX(-90.0f);
 
+		//The decode scales, so the normals take the matrix from before it.
+		glm::mat3 normalMatrix(modelMatrix.Top());
+		const glm::mat4 modelToCamera = modelMatrix.Top();
+		modelMatrix.ApplyMatrix(g_pTerrain->GetPositionDecodeMatrix());
+
 		glUseProgram(g_progStandard.theProgram);
 		glUniformMatrix4fv(g_progStandard.modelToCameraMatrixUnif, 1, GL_FALSE,
 			glm::value_ptr(modelMatrix.Top()));
+		glUniformMatrix3fv(g_progStandard.normalModelToCameraMatrixUnif, 1, GL_FALSE,
+			glm::value_ptr(normalMatrix));
 		glUniform1i(g_progStandard.numberOfLightsUnif, g_pLightEnv->GetNumLights());
 
 		glActiveTexture(GL_TEXTURE0 + g_colorTexUnit);
 		glBindTexture(GL_TEXTURE_2D, g_linearTexture);
 		glBindSampler(g_colorTexUnit, g_samplers[g_currSampler]);
 
-		g_pTerrain->Render("lit-tex");
+		//Most of the terrain is behind or beside the camera, so only the clusters in view
+		//are drawn.
+		g_pTerrain->RenderVisible("lit-tex", modelToCamera, g_cameraToClipMatrix, GL_CW);
 
 		glBindSampler(g_colorTexUnit, 0);
 		glBindTexture(GL_TEXTURE_2D, 0);
@@ -380,6 +393,8 @@ void display()
 
 	}
 
+	g_pUniformRing->EndFrame();
+
 	glutPostRedisplay();
 	glutSwapBuffers();
 }
@@ -393,6 +408,7 @@ void reshape (int w, int h)
 
 	ProjectionBlock projData;
 	projData.cameraToClipMatrix = persMatrix.Top();
+	g_cameraToClipMatrix = persMatrix.Top();
 
 	glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
 	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ProjectionBlock), &projData);
@@ -418,6 +434,8 @@ void keyboard(unsigned char key, int x, int y)
 		g_pSphere = NULL;
 		g_pTerrain = NULL;
 		g_pLightEnv = NULL;
+		delete g_pUniformRing;
+		g_pUniformRing = NULL;
 		glutLeaveMainLoop();
 		return;
 	case 32:
@@ -7,13 +7,13 @@
 #include <stdexcept>
 #include <algorithm>
 #include <fstream>
-#include <sstream>
 #include <utility>
 #include <vector>
 #include <iostream>
 #include "LightEnv.h"
 #include <glload/gl_all.h>
 #include "../framework/framework.h"
+#include "../framework/FloatParse.h"
 #include "rapidxml.hpp"
 #include "rapidxml_helpers.h"
 #include <glm/gtc/matrix_transform.hpp>
@@ -50,23 +50,56 @@ namespace
 		throw std::runtime_error("Attribute " + name + " " + msg);
 	}
 
-	glm::vec4 ParseVec4(const std::string &strVec4)
+	bool ParseFloats(const char *pStr, float *pValues, int numValues)
 	{
-		std::stringstream strStream;
-		strStream << strVec4;
-		strStream.flush();
-		glm::vec4 ret;
-		strStream >> ret.x >> ret.y >> ret.z >> ret.w;
-		return ret;
+		for(int valIx = 0; valIx < numValues; ++valIx)
+		{
+			pStr = Framework::ParseFloat(pStr, pValues[valIx]);
+			if(!pStr)
+				return false;
+		}
+
+		return true;
 	}
 
-	glm::vec3 ParseVec3(const std::string &strVec3)
+	glm::vec3 ParseVec3(const xml_node<> &node)
 	{
-		std::stringstream strStream;
-		strStream << strVec3;
-		strStream.flush();
 		glm::vec3 ret;
-		strStream >> ret.x >> ret.y >> ret.z;
+		PARSE_THROW(ParseFloats(node.value(), &ret[0], 3),
+			"Light key '" + make_string(node) + "' must be a vec3.");
+		return ret;
+	}
+
+	const xml_attribute<> &GetAttrib(const xml_node<> &node, const char *attribName)
+	{
+		const xml_attribute<> *pAttrib = node.first_attribute(attribName);
+		PARSE_THROW(pAttrib, std::string("Could not find attribute ") + attribName +
+			" in node " + std::string(node.name(), node.name_size()));
+		return *pAttrib;
+	}
+
+	float GetAttribFloat(const xml_node<> &node, const char *attribName)
+	{
+		const xml_attribute<> &attrib = GetAttrib(node, attribName);
+		float ret = 0.0f;
+		if(!Framework::ParseFloat(attrib.value(), ret))
+			ThrowAttrib(attrib, "must be a float.");
+		return ret;
+	}
+
+	float GetAttribFloat(const xml_node<> &node, const char *attribName, float optional)
+	{
+		if(!node.first_attribute(attribName))
+			return optional;
+		return GetAttribFloat(node, attribName);
+	}
+
+	glm::vec4 GetAttribVec4(const xml_node<> &node, const char *attribName)
+	{
+		const xml_attribute<> &attrib = GetAttrib(node, attribName);
+		glm::vec4 ret;
+		if(!ParseFloats(attrib.value(), &ret[0], 4))
+			ThrowAttrib(attrib, "must be a vec4.");
 		return ret;
 	}
 }
@@ -100,14 +133,14 @@ LightEnv::LightEnv( const std::string& envFilename )
 	xml_node<> *pRootNode = doc.first_node("lightenv");
 	PARSE_THROW(pRootNode, ("lightenv node not found in light environment file: " + envFilename));
 
-	m_fLightAttenuation = rapidxml::get_attrib_float(*pRootNode, "atten", m_fLightAttenuation);
+	m_fLightAttenuation = GetAttribFloat(*pRootNode, "atten", m_fLightAttenuation);
 	m_fLightAttenuation = 1.0f / (m_fLightAttenuation * m_fLightAttenuation);
 
 	xml_node<> *pSunNode = pRootNode->first_node("sun");
 	PARSE_THROW(pSunNode, "lightenv node must have a first child that is called `sun`.");
 
 	m_sunTimer = Framework::Timer(Framework::Timer::TT_LOOP,
-		rapidxml::get_attrib_float(*pSunNode, "time", ThrowAttrib));
+		GetAttribFloat(*pSunNode, "time"));
 
 	LightVector ambient;
 	LightVector light;
@@ -118,21 +151,21 @@ LightEnv::LightEnv( const std::string& envFilename )
 		pKeyNode;
 		pKeyNode = pKeyNode->next_sibling("key"))
 	{
-		float keyTime = rapidxml::get_attrib_float(*pKeyNode, "time", ThrowAttrib);
+		float keyTime = GetAttribFloat(*pKeyNode, "time");
 		//Convert from hours to normalized time.
 		keyTime = keyTime / 24.0f;
 
 		ambient.push_back(LightData(
-			rapidxml::get_attrib_vec4(*pKeyNode, "ambient", ThrowAttrib), keyTime));
+			GetAttribVec4(*pKeyNode, "ambient"), keyTime));
 
 		light.push_back(LightData(
-			rapidxml::get_attrib_vec4(*pKeyNode, "intensity", ThrowAttrib), keyTime));
+			GetAttribVec4(*pKeyNode, "intensity"), keyTime));
 
 		background.push_back(LightData(
-			rapidxml::get_attrib_vec4(*pKeyNode, "background", ThrowAttrib), keyTime));
+			GetAttribVec4(*pKeyNode, "background"), keyTime));
 
 		maxIntensity.push_back(MaxIntensityData(
-			rapidxml::get_attrib_float(*pKeyNode, "max-intensity", ThrowAttrib), keyTime));
+			GetAttribFloat(*pKeyNode, "max-intensity"), keyTime));
 	}
 
 	if(ambient.empty())
@@ -152,17 +185,16 @@ LightEnv::LightEnv( const std::string& envFilename )
 
 		m_lightTimers.push_back(Framework::Timer(
 			Framework::Timer::TT_LOOP,
-			rapidxml::get_attrib_float(*pLightNode, "time", ThrowAttrib)));
+			GetAttribFloat(*pLightNode, "time")));
 
-		m_lightIntensity.push_back(rapidxml::get_attrib_vec4(
-			*pLightNode, "intensity", ThrowAttrib));
+		m_lightIntensity.push_back(GetAttribVec4(*pLightNode, "intensity"));
 
 		std::vector<glm::vec3> posValues;
 		for(xml_node<> *pKeyNode = pLightNode->first_node("key");
 			pKeyNode;
 			pKeyNode = pKeyNode->next_sibling("key"))
 		{
-			posValues.push_back(ParseVec3(make_string(*pKeyNode)));
+			posValues.push_back(ParseVec3(*pKeyNode));
 		}
 
 		if(posValues.empty())
@@ -16,12 +16,13 @@ uniform Projection
 };
 
 uniform mat4 modelToCameraMatrix;
+uniform mat3 normalModelToCameraMatrix;
 
 void main()
 {
 	cameraSpacePosition = (modelToCameraMatrix * vec4(position, 1.0)).xyz;
 	gl_Position = cameraToClipMatrix * vec4(cameraSpacePosition, 1.0);
-	//Assume the modelToCameraMatrix contains no scaling.
-	cameraSpaceNormal = (modelToCameraMatrix * vec4(normal, 0)).xyz;
+	//Assume the normalModelToCameraMatrix contains no scaling.
+	cameraSpaceNormal = normalModelToCameraMatrix * normal;
 	colorCoord = texCoord;
 }
@@ -13,6 +13,7 @@
 #include <glutil/MatrixStack.h>
 #include <glutil/MousePoles.h>
 #include "../framework/framework_all.h"
+#include "../framework/UniformRing.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -32,8 +33,8 @@ struct ProjectionBlock
 	glm::mat4 cameraToClipMatrix;
 };
 
-GLuint g_projectionUniformBuffer = 0;
-GLuint g_lightUniformBuffer = 0;
+//The projection and light blocks change every frame, so they come from the ring.
+Framework::UniformRing *g_pUniformRing = NULL;
 
 ////////////////////////////////
 //View setup.
@@ -177,14 +178,6 @@ void init()
 	glEnable(GL_DEPTH_CLAMP);
 	glEnable(GL_FRAMEBUFFER_SRGB);
 
-	//Setup our Uniform Buffers
-	glGenBuffers(1, &g_projectionUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), NULL, GL_STREAM_DRAW);
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_projectionBlockIndex, g_projectionUniformBuffer,
-		0, sizeof(ProjectionBlock));
-
 	try
 	{
 		LoadAndSetupScene();
@@ -195,14 +188,8 @@ void init()
 		throw;
 	}
 
-	glGenBuffers(1, &g_lightUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_STREAM_DRAW);
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_lightBlockIndex, g_lightUniformBuffer,
-		0, sizeof(LightBlock));
-
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	//Setup our Uniform Buffers
+	g_pUniformRing = new Framework::UniformRing(sizeof(LightBlock) + (2 * sizeof(ProjectionBlock)), 3);
 }
 
 using Framework::Timer;
@@ -230,8 +217,7 @@ void BuildLights( const glm::mat4 &camMatrix )
 
 	g_lightNumBinder.SetValue(2);
 
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &lightData, GL_STREAM_DRAW);
+	g_pUniformRing->Upload(g_lightBlockIndex, &lightData, sizeof(LightBlock));
 }
 
 //Called to update the display.
@@ -243,6 +229,7 @@ void display()
 		return;
 
 	g_timer.Update();
+	g_pUniformRing->BeginFrame();
 
 	glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
 	glClearDepth(1.0f);
@@ -268,9 +255,7 @@ void display()
 		ProjectionBlock projData;
 		projData.cameraToClipMatrix = persMatrix.Top();
 
-		glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), &projData, GL_STREAM_DRAW);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		g_pUniformRing->Upload(g_projectionBlockIndex, &projData, sizeof(ProjectionBlock));
 	}
 
 	glViewport(0, 0, (GLsizei)displaySize.x, (GLsizei)displaySize.y);
@@ -305,9 +290,7 @@ void display()
 		ProjectionBlock projData;
 		projData.cameraToClipMatrix = persMatrix.Top();
 
-		glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), &projData, GL_STREAM_DRAW);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		g_pUniformRing->Upload(g_projectionBlockIndex, &projData, sizeof(ProjectionBlock));
 	}
 
 	if(!g_bDepthClampProj)
@@ -317,6 +300,8 @@ void display()
 	g_pScene->Render(modelMatrix.Top());
 	glEnable(GL_DEPTH_CLAMP);
 
+	g_pUniformRing->EndFrame();
+
     glutPostRedisplay();
 	glutSwapBuffers();
 }
@@ -342,6 +327,8 @@ void keyboard(unsigned char key, int x, int y)
 	case 27:
 		delete g_pScene;
 		g_pScene = NULL;
+		delete g_pUniformRing;
+		g_pUniformRing = NULL;
 		glutLeaveMainLoop();
 		return;
 	case 32:
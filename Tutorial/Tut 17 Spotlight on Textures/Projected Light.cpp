@@ -13,6 +13,7 @@
 #include <glutil/MatrixStack.h>
 #include <glutil/MousePoles.h>
 #include "../framework/framework_all.h"
+#include "../framework/UniformRing.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/quaternion.hpp>
@@ -32,8 +33,8 @@ struct ProjectionBlock
 	glm::mat4 cameraToClipMatrix;
 };
 
-GLuint g_projectionUniformBuffer = 0;
-GLuint g_lightUniformBuffer = 0;
+//The projection and light blocks change every frame, so they come from the ring.
+Framework::UniformRing *g_pUniformRing = NULL;
 
 const int NUM_SAMPLERS = 2;
 GLuint g_samplers[NUM_SAMPLERS];
@@ -253,14 +254,6 @@ void init()
 	glEnable(GL_DEPTH_CLAMP);
 	glEnable(GL_FRAMEBUFFER_SRGB);
 
-	//Setup our Uniform Buffers
-	glGenBuffers(1, &g_projectionUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), NULL, GL_STREAM_DRAW);
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_projectionBlockIndex, g_projectionUniformBuffer,
-		0, sizeof(ProjectionBlock));
-
 	CreateSamplers();
 	LoadTextures();
 
@@ -274,14 +267,8 @@ void init()
 		throw;
 	}
 
-	glGenBuffers(1, &g_lightUniformBuffer);
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), NULL, GL_STREAM_DRAW);
-
-	glBindBufferRange(GL_UNIFORM_BUFFER, g_lightBlockIndex, g_lightUniformBuffer,
-		0, sizeof(LightBlock));
-
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	//Setup our Uniform Buffers
+	g_pUniformRing = new Framework::UniformRing(sizeof(LightBlock) + sizeof(ProjectionBlock), 2);
 }
 
 using Framework::Timer;
@@ -315,8 +302,7 @@ void BuildLights( const glm::mat4 &camMatrix )
 	else
 		g_lightNumBinder.SetValue(0);
 
-	glBindBuffer(GL_UNIFORM_BUFFER, g_lightUniformBuffer);
-	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), &lightData, GL_STREAM_DRAW);
+	g_pUniformRing->Upload(g_lightBlockIndex, &lightData, sizeof(LightBlock));
 }
 
 //Called to update the display.
@@ -328,6 +314,7 @@ void display()
 		return;
 
 	g_timer.Update();
+	g_pUniformRing->BeginFrame();
 
 	glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
 	glClearDepth(1.0f);
@@ -354,9 +341,7 @@ void display()
 		ProjectionBlock projData;
 		projData.cameraToClipMatrix = persMatrix.Top();
 
-		glBindBuffer(GL_UNIFORM_BUFFER, g_projectionUniformBuffer);
-		glBufferData(GL_UNIFORM_BUFFER, sizeof(ProjectionBlock), &projData, GL_STREAM_DRAW);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		g_pUniformRing->Upload(g_projectionBlockIndex, &projData, sizeof(ProjectionBlock));
 	}
 
 	glActiveTexture(GL_TEXTURE0 + g_lightProjTexUnit);
@@ -423,6 +408,8 @@ void display()
 	glBindTexture(GL_TEXTURE_2D, 0);
 	glBindSampler(g_lightProjTexUnit, 0);
 
+	g_pUniformRing->EndFrame();
+
     glutPostRedisplay();
 	glutSwapBuffers();
 }
@@ -448,6 +435,8 @@ void keyboard(unsigned char key, int x, int y)
 	case 27:
 		delete g_pScene;
 		g_pScene = NULL;
+		delete g_pUniformRing;
+		g_pUniformRing = NULL;
 		glutLeaveMainLoop();
 		return;
 	case 32:
@@ -0,0 +1,102 @@
+//This file is licensed under the MIT License.
+
+
+#include <stdlib.h>
+#include "FloatParse.h"
+
+namespace Framework
+{
+	namespace
+	{
+		//Every power of ten here is exactly representable as a float.
+		const float g_exactPowersOf10[] =
+		{
+			1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+		};
+
+		const int MAX_FAST_PATH_DIGITS = 7;
+		const int MAX_FAST_PATH_EXPONENT = 10;
+
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+		}
+
+		bool IsDigit(char c)
+		{
+			return '0' <= c && c <= '9';
+		}
+
+		//Whether strtod would read on past a plain decimal that stops at c: an exponent,
+		//hex digits, more digits than the fast path takes, or a second '.'.
+		bool ContinuesNumber(char c)
+		{
+			return IsDigit(c) || c == '.' || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+		}
+	}
+
+	const char *ParseFloat( const char *pStr, float &value )
+	{
+		while(IsSpace(*pStr))
+			++pStr;
+
+		const char *pStart = pStr;
+		bool isNegative = false;
+		if(*pStr == '-' || *pStr == '+')
+		{
+			isNegative = (*pStr == '-');
+			++pStr;
+		}
+
+		unsigned int mantissa = 0;
+		int numDigits = 0;
+		int exponent = 0;
+		bool hasDigits = false;
+
+		for(; IsDigit(*pStr); ++pStr)
+		{
+			hasDigits = true;
+			if(mantissa == 0 && *pStr == '0')
+				continue;
+
+			if(++numDigits > MAX_FAST_PATH_DIGITS)
+				break;
+			mantissa = mantissa * 10 + (*pStr - '0');
+		}
+
+		if(*pStr == '.' && numDigits <= MAX_FAST_PATH_DIGITS)
+		{
+			for(++pStr; IsDigit(*pStr); ++pStr)
+			{
+				hasDigits = true;
+				--exponent;
+				if(mantissa == 0 && *pStr == '0')
+					continue;
+
+				if(++numDigits > MAX_FAST_PATH_DIGITS)
+					break;
+				mantissa = mantissa * 10 + (*pStr - '0');
+			}
+		}
+
+		const bool isFastPath = hasDigits &&
+			numDigits <= MAX_FAST_PATH_DIGITS &&
+			-exponent <= MAX_FAST_PATH_EXPONENT &&
+			!ContinuesNumber(*pStr);
+
+		if(isFastPath)
+		{
+			value = float(mantissa) / g_exactPowersOf10[-exponent];
+			if(isNegative)
+				value = -value;
+			return pStr;
+		}
+
+		char *pEnd = NULL;
+		value = (float)strtod(pStart, &pEnd);
+		if(pEnd == pStart)
+			return NULL;
+
+		return pEnd;
+	}
+}
@@ -0,0 +1,21 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_FLOAT_PARSE_H
+#define FRAMEWORK_FLOAT_PARSE_H
+
+namespace Framework
+{
+	//Parses one float, skipping leading whitespace, and returns a pointer just past it (or
+	//NULL if there is no number there). The number ends at the first character that can't
+	//continue it, so text need not be null-terminated as long as something like whitespace
+	//or '<' follows.
+	//
+	//Plain decimals with at most 7 significant digits and 10 fractional digits are built
+	//from an integer mantissa and a single float division. Both operands are exact, so the
+	//result is correctly rounded. Anything else (exponents, hex, inf, nan, long mantissas)
+	//goes to strtod, and the double is rounded to float, as the mesh loader always did.
+	const char *ParseFloat(const char *pStr, float &value);
+}
+
+#endif //FRAMEWORK_FLOAT_PARSE_H
@@ -0,0 +1,105 @@
+//This file is licensed under the MIT License.
+
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "MappedFile.h"
+
+namespace Framework
+{
+#ifdef _WIN32
+	MappedFile::MappedFile( const std::string &strFilename )
+		: m_pData(NULL)
+		, m_size(0)
+		, m_hFile(INVALID_HANDLE_VALUE)
+		, m_hMapping(NULL)
+	{
+		m_hFile = CreateFileA(strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(m_hFile == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER fileSize;
+		if(!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart <= 0 ||
+			(unsigned __int64)fileSize.QuadPart > (size_t)-1)
+		{
+			Close();
+			return;
+		}
+
+		m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(!m_hMapping)
+		{
+			Close();
+			return;
+		}
+
+		m_pData = static_cast<const char *>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+		if(!m_pData)
+		{
+			Close();
+			return;
+		}
+
+		m_size = (size_t)fileSize.QuadPart;
+	}
+
+	void MappedFile::Close()
+	{
+		if(m_pData)
+			UnmapViewOfFile(m_pData);
+		if(m_hMapping)
+			CloseHandle(m_hMapping);
+		if(m_hFile != INVALID_HANDLE_VALUE)
+			CloseHandle(m_hFile);
+
+		m_pData = NULL;
+		m_size = 0;
+		m_hMapping = NULL;
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	MappedFile::MappedFile( const std::string &strFilename )
+		: m_pData(NULL)
+		, m_size(0)
+	{
+		int file = open(strFilename.c_str(), O_RDONLY);
+		if(file < 0)
+			return;
+
+		//The mapping keeps its own reference to the file, so it can be closed straight away.
+		struct stat fileStat;
+		if(fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+		{
+			void *pData = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+			if(pData != MAP_FAILED)
+			{
+				m_pData = static_cast<const char *>(pData);
+				m_size = (size_t)fileStat.st_size;
+			}
+		}
+
+		close(file);
+	}
+
+	void MappedFile::Close()
+	{
+		if(m_pData)
+			munmap(const_cast<char *>(m_pData), m_size);
+
+		m_pData = NULL;
+		m_size = 0;
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+}
@@ -0,0 +1,41 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MAPPED_FILE_H
+#define FRAMEWORK_MAPPED_FILE_H
+
+#include <stddef.h>
+#include <string>
+
+namespace Framework
+{
+	//A read-only view of a whole file, mapped into memory rather than read into it. Pages are
+	//only brought in as they are touched, and they are backed by the file itself, so they
+	//do not count against the heap.
+	class MappedFile
+	{
+	public:
+		//Check IsOpen(): a missing, empty or unmappable file leaves it closed.
+		explicit MappedFile(const std::string &strFilename);
+		~MappedFile();
+
+		bool IsOpen() const {return m_pData != NULL;}
+		const char *GetData() const {return m_pData;}
+		size_t GetSize() const {return m_size;}
+
+		void Close();
+
+	private:
+		const char *m_pData;
+		size_t m_size;
+#ifdef _WIN32
+		void *m_hFile;
+		void *m_hMapping;
+#endif
+
+		MappedFile(const MappedFile &);
+		MappedFile &operator=(const MappedFile &);
+	};
+}
+
+#endif //FRAMEWORK_MAPPED_FILE_H
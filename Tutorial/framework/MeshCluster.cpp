@@ -0,0 +1,333 @@
+//This file is licensed under the MIT License.
+
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "MeshCluster.h"
+#include "MeshOptimize.h"
+
+namespace Framework
+{
+	namespace
+	{
+		//Each free neighbour adds this much of a triangle's cost, so that the triangles
+		//that would be left cut off are taken first.
+		const float LIVE_NEIGHBOUR_COST = 0.1f;
+
+		struct TriangleInfo
+		{
+			float centroid[3];
+			float normal[3];	//Unit length, or zero for a triangle with no area.
+		};
+
+		void GetTriangleInfo(const std::vector<float> &positions, const GLuint *pCorners,
+			TriangleInfo &info)
+		{
+			const float *pA = &positions[pCorners[0] * 3];
+			const float *pB = &positions[pCorners[1] * 3];
+			const float *pC = &positions[pCorners[2] * 3];
+
+			double ab[3], ac[3];
+			for(int component = 0; component < 3; component++)
+			{
+				info.centroid[component] = (pA[component] + pB[component] + pC[component]) / 3.0f;
+				ab[component] = (double)pB[component] - pA[component];
+				ac[component] = (double)pC[component] - pA[component];
+			}
+
+			double normal[3];
+			normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+			normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+			normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+			const double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] +
+				normal[2] * normal[2]);
+			for(int component = 0; component < 3; component++)
+				info.normal[component] = length > 0.0 ? (float)(normal[component] / length) : 0.0f;
+		}
+
+		float Dot(const float *pLhs, const float *pRhs)
+		{
+			return pLhs[0] * pRhs[0] + pLhs[1] * pRhs[1] + pLhs[2] * pRhs[2];
+		}
+
+		float DistanceSqr(const float *pLhs, const float *pRhs)
+		{
+			float distanceSqr = 0.0f;
+			for(int component = 0; component < 3; component++)
+			{
+				const float offset = pLhs[component] - pRhs[component];
+				distanceSqr += offset * offset;
+			}
+
+			return distanceSqr;
+		}
+
+		//The sphere around the triangles' corners, and the cone around their normals.
+		void SetClusterBounds(const std::vector<float> &positions,
+			const std::vector<GLuint> &indices, const std::vector<TriangleInfo> &infos,
+			const std::vector<GLuint> &members, MeshCluster &cluster)
+		{
+			float minValue[3], maxValue[3];
+			for(int component = 0; component < 3; component++)
+			{
+				minValue[component] = positions[indices[members[0] * 3] * 3 + component];
+				maxValue[component] = minValue[component];
+			}
+
+			float axis[3] = {0.0f, 0.0f, 0.0f};
+			for(size_t member = 0; member < members.size(); member++)
+			{
+				for(int corner = 0; corner < 3; corner++)
+				{
+					const float *pPosition = &positions[indices[members[member] * 3 + corner] * 3];
+					for(int component = 0; component < 3; component++)
+					{
+						minValue[component] = std::min(minValue[component], pPosition[component]);
+						maxValue[component] = std::max(maxValue[component], pPosition[component]);
+					}
+				}
+
+				for(int component = 0; component < 3; component++)
+					axis[component] += infos[members[member]].normal[component];
+			}
+
+			for(int component = 0; component < 3; component++)
+				cluster.center[component] = (minValue[component] + maxValue[component]) * 0.5f;
+
+			float radiusSqr = 0.0f;
+			for(size_t member = 0; member < members.size(); member++)
+			{
+				for(int corner = 0; corner < 3; corner++)
+				{
+					const float *pPosition = &positions[indices[members[member] * 3 + corner] * 3];
+					radiusSqr = std::max(radiusSqr, DistanceSqr(pPosition, cluster.center));
+				}
+			}
+			cluster.radius = sqrtf(radiusSqr);
+
+			const float axisLength = sqrtf(Dot(axis, axis));
+			cluster.coneCos = -1.0f;
+			for(int component = 0; component < 3; component++)
+				cluster.coneAxis[component] = axisLength > 0.0f ? axis[component] / axisLength : 0.0f;
+			if(axisLength == 0.0f)
+				return;
+
+			cluster.coneCos = 1.0f;
+			for(size_t member = 0; member < members.size(); member++)
+			{
+				const float *pNormal = infos[members[member]].normal;
+				if(Dot(pNormal, pNormal) > 0.0f)
+					cluster.coneCos = std::min(cluster.coneCos, Dot(pNormal, cluster.coneAxis));
+			}
+		}
+
+		//Triangles that still share a corner with a triangle, counting it once per corner.
+		int GetLiveNeighbours(const std::vector<GLuint> &indices,
+			const std::vector<int> &liveTriangles, GLuint triangle)
+		{
+			return liveTriangles[indices[triangle * 3]] + liveTriangles[indices[triangle * 3 + 1]] +
+				liveTriangles[indices[triangle * 3 + 2]] - 3;
+		}
+
+		//How poorly a triangle fits a cluster: its distance from the cluster's centroid,
+		//stretched for facing away from the cluster's normals.
+		float GetFitCost(const TriangleInfo &info, const float *pCentroid, const float *pAxis)
+		{
+			const float axisLength = sqrtf(Dot(pAxis, pAxis));
+			const float facing = axisLength > 0.0f ? Dot(info.normal, pAxis) / axisLength : 1.0f;
+			return sqrtf(DistanceSqr(info.centroid, pCentroid)) * (2.0f - facing);
+		}
+	}
+
+	int BuildClusters( MeshData &mesh, int maxTriangles )
+	{
+		mesh.clusters.clear();
+		mesh.bClustersBuilt = true;
+
+		std::vector<float> positions;
+		std::vector<GLuint> indices;
+		if(!GetPositions(mesh, positions) || !HasOnlyTriangles(mesh) || maxTriangles < 1)
+			return 0;
+
+		GetTriangles(mesh, indices);
+		if(indices.empty() || positions.size() / 3 != GetNumVertices(mesh))
+			return 0;
+
+		const size_t numVertices = positions.size() / 3;
+		const size_t numTriangles = indices.size() / 3;
+		std::vector<TriangleInfo> infos(numTriangles);
+		for(size_t triangle = 0; triangle < numTriangles; triangle++)
+			GetTriangleInfo(positions, &indices[triangle * 3], infos[triangle]);
+
+		//Each vertex's triangles, as one array sliced by firstTriangle.
+		std::vector<size_t> firstTriangle(numVertices + 1, 0);
+		for(size_t ix = 0; ix < indices.size(); ix++)
+			firstTriangle[indices[ix] + 1]++;
+		for(size_t vertex = 0; vertex < numVertices; vertex++)
+			firstTriangle[vertex + 1] += firstTriangle[vertex];
+
+		std::vector<GLuint> vertexTriangles(indices.size());
+		std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+		for(size_t ix = 0; ix < indices.size(); ix++)
+			vertexTriangles[fill[indices[ix]]++] = (GLuint)(ix / 3);
+
+		//Triangles not yet in a cluster, per vertex.
+		std::vector<int> liveTriangles(numVertices);
+		for(size_t vertex = 0; vertex < numVertices; vertex++)
+			liveTriangles[vertex] = (int)(firstTriangle[vertex + 1] - firstTriangle[vertex]);
+
+		std::vector<bool> assigned(numTriangles, false);
+		std::vector<size_t> candidateOf(numTriangles, (size_t)-1);
+		std::vector<GLuint> candidates;
+		std::vector<GLuint> members;
+		std::vector<GLuint> output;
+		output.reserve(indices.size());
+
+		size_t cursor = 0;
+		while(output.size() < indices.size())
+		{
+			//The next cluster starts next to the last, where it left candidates behind, so
+			//that clusters close together in the mesh are close together in the list too. Of
+			//those, the one with the fewest free neighbours goes first, so that corners get
+			//filled in rather than left as scraps.
+			GLuint seed = (GLuint)numTriangles;
+			int seedNeighbours = 0;
+			for(size_t candidate = 0; candidate < candidates.size(); candidate++)
+			{
+				const GLuint triangle = candidates[candidate];
+				if(assigned[triangle])
+					continue;
+
+				const int neighbours = GetLiveNeighbours(indices, liveTriangles, triangle);
+				if(seed == numTriangles || neighbours < seedNeighbours)
+				{
+					seed = triangle;
+					seedNeighbours = neighbours;
+				}
+			}
+
+			while(seed == numTriangles)
+			{
+				if(!assigned[cursor])
+					seed = (GLuint)cursor;
+				cursor++;
+			}
+
+			const size_t clusterId = mesh.clusters.size();
+			candidates.clear();
+			members.clear();
+
+			float centroidSum[3] = {0.0f, 0.0f, 0.0f};
+			float normalSum[3] = {0.0f, 0.0f, 0.0f};
+			GLuint next = seed;
+			while(true)
+			{
+				assigned[next] = true;
+				members.push_back(next);
+				for(int corner = 0; corner < 3; corner++)
+					liveTriangles[indices[next * 3 + corner]]--;
+				for(int component = 0; component < 3; component++)
+				{
+					centroidSum[component] += infos[next].centroid[component];
+					normalSum[component] += infos[next].normal[component];
+				}
+
+				if(members.size() >= (size_t)maxTriangles)
+					break;
+
+				for(int corner = 0; corner < 3; corner++)
+				{
+					const GLuint vertex = indices[next * 3 + corner];
+					for(size_t slot = firstTriangle[vertex]; slot < firstTriangle[vertex + 1]; slot++)
+					{
+						const GLuint neighbour = vertexTriangles[slot];
+						if(!assigned[neighbour] && candidateOf[neighbour] != clusterId)
+						{
+							candidateOf[neighbour] = clusterId;
+							candidates.push_back(neighbour);
+						}
+					}
+				}
+
+				float centroid[3];
+				for(int component = 0; component < 3; component++)
+					centroid[component] = centroidSum[component] / members.size();
+
+				size_t best = candidates.size();
+				float bestCost = 0.0f;
+				for(size_t candidate = 0; candidate < candidates.size(); candidate++)
+				{
+					if(assigned[candidates[candidate]])
+						continue;
+
+					const GLuint triangle = candidates[candidate];
+					const float cost = GetFitCost(infos[triangle], centroid, normalSum) *
+						(1.0f + GetLiveNeighbours(indices, liveTriangles, triangle) * LIVE_NEIGHBOUR_COST);
+					if(best == candidates.size() || cost < bestCost)
+					{
+						best = candidate;
+						bestCost = cost;
+					}
+				}
+
+				if(best == candidates.size())
+					break;
+
+				next = candidates[best];
+				candidates[best] = candidates.back();
+				candidates.pop_back();
+			}
+
+			MeshCluster cluster;
+			cluster.firstIndex = (GLuint)output.size();
+			cluster.numIndices = (GLuint)(members.size() * 3);
+			SetClusterBounds(positions, indices, infos, members, cluster);
+			mesh.clusters.push_back(cluster);
+
+			for(size_t member = 0; member < members.size(); member++)
+				output.insert(output.end(), &indices[members[member] * 3], &indices[members[member] * 3] + 3);
+		}
+
+		MeshPrimitive list = mesh.primitives[0];
+		list.primType = GL_TRIANGLES;
+		list.indexType = GetWidestIndexType(mesh);
+		list.count = (GLuint)output.size();
+		list.indices.swap(output);
+		mesh.primitives.assign(1, list);
+
+		return (int)mesh.clusters.size();
+	}
+
+	bool IsClusterVisible( const MeshCluster &cluster, const ClusterView &view )
+	{
+		for(int plane = 0; plane < 6; plane++)
+		{
+			const float *pPlane = view.planes[plane];
+			const float distance = Dot(pPlane, cluster.center) + pPlane[3];
+			if(distance < -cluster.radius * sqrtf(Dot(pPlane, pPlane)))
+				return false;
+		}
+
+		if(cluster.coneCos <= 0.0f)
+			return true;
+
+		float toCluster[3];
+		for(int component = 0; component < 3; component++)
+			toCluster[component] = cluster.center[component] - view.cameraPos[component];
+
+		const float distance = sqrtf(Dot(toCluster, toCluster));
+		if(distance <= cluster.radius)
+			return true;
+
+		//With phi the angle from the view ray to the front side's axis, and alpha the cone's
+		//half-angle, the triangle that turns furthest toward the camera makes phi + alpha
+		//with the ray. It faces away from every point of the sphere if the camera is more
+		//than the radius behind its plane.
+		const float sign = view.bFrontFaceCw ? -1.0f : 1.0f;
+		const float cosPhi = sign * Dot(toCluster, cluster.coneAxis) / distance;
+		const float sinPhi = sqrtf(std::max(0.0f, 1.0f - cosPhi * cosPhi));
+		const float sinAlpha = sqrtf(std::max(0.0f, 1.0f - cluster.coneCos * cluster.coneCos));
+		return distance * (cosPhi * cluster.coneCos - sinPhi * sinAlpha) < cluster.radius;
+	}
+}
@@ -0,0 +1,40 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MESH_CLUSTER_H
+#define FRAMEWORK_MESH_CLUSTER_H
+
+#include "MeshData.h"
+
+namespace Framework
+{
+	enum
+	{
+		DEFAULT_CLUSTER_TRIANGLES = 128,
+	};
+
+	//Gathers the mesh's indexed triangles, strips and fans into one triangle list, ordered
+	//as clusters of up to maxTriangles each. A cluster grows from one triangle across shared
+	//vertices, taking next whichever neighbour lies closest to it and faces most like it,
+	//favouring those that have few free neighbours left. Degenerate triangles are dropped.
+	//
+	//Nothing is built for a mesh with <arrays>, other primitives, a primitive restart index,
+	//or positions (attribute 0) that are not floats. Returns the number of clusters.
+	int BuildClusters(MeshData &mesh, int maxTriangles = DEFAULT_CLUSTER_TRIANGLES);
+
+	//Where the clusters are seen from, in the mesh's model space. A point is inside the
+	//frustum if a x + b y + c z + d >= 0 for every plane (a, b, c, d). The camera is a point,
+	//so the view must be a perspective one.
+	struct ClusterView
+	{
+		float planes[6][4];
+		float cameraPos[3];
+		bool bFrontFaceCw;	//As glFrontFace(GL_CW) draws them.
+	};
+
+	//False if the cluster's sphere is wholly outside a frustum plane, or if every one of its
+	//triangles faces away from the camera wherever in the sphere it lies.
+	bool IsClusterVisible(const MeshCluster &cluster, const ClusterView &view);
+}
+
+#endif //FRAMEWORK_MESH_CLUSTER_H
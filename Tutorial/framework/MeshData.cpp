@@ -0,0 +1,558 @@
+//This file is licensed under the MIT License.
+
+
+#include <string.h>
+#include <stdio.h>
+#include <stdexcept>
+#include "MappedFile.h"
+#include "MeshData.h"
+#include "PackedMeshFormat.h"
+
+namespace Framework
+{
+	namespace
+	{
+		const char g_packedMagic[4] = {'G', 'M', 'S', 'H'};
+
+		size_t GetTypeSize(GLenum type)
+		{
+			switch(type)
+			{
+			case GL_BYTE:
+			case GL_UNSIGNED_BYTE:
+				return 1;
+			case GL_SHORT:
+			case GL_UNSIGNED_SHORT:
+			case GL_HALF_FLOAT:
+				return 2;
+			case GL_INT:
+			case GL_UNSIGNED_INT:
+			case GL_FLOAT:
+				return 4;
+			default:
+				return 0;
+			}
+		}
+
+		GLuint GetIndexTypeMax(GLenum indexType)
+		{
+			switch(indexType)
+			{
+			case GL_UNSIGNED_BYTE: return 0xFF;
+			case GL_UNSIGNED_SHORT: return 0xFFFF;
+			default: return 0xFFFFFFFF;
+			}
+		}
+
+		GLuint AlignUp(size_t value)
+		{
+			return (GLuint)(((value + PACKED_MESH_ALIGNMENT - 1) / PACKED_MESH_ALIGNMENT) *
+				PACKED_MESH_ALIGNMENT);
+		}
+
+		bool RangeInside(size_t offset, size_t size, size_t totalSize)
+		{
+			return offset <= totalSize && size <= totalSize - offset;
+		}
+
+		//Lays out one block of indices after dataSize, and returns its offset.
+		GLuint PlaceIndices(GLenum indexType, const std::vector<GLuint> &indices,
+			size_t &dataSize)
+		{
+			const GLuint indexMax = GetIndexTypeMax(indexType);
+			for(size_t ix = 0; ix < indices.size(); ix++)
+			{
+				if(indices[ix] > indexMax)
+					throw std::runtime_error("An index does not fit the primitive's index type.");
+			}
+
+			const GLuint dataOffset = AlignUp(dataSize);
+			dataSize = dataOffset + indices.size() * GetTypeSize(indexType);
+			return dataOffset;
+		}
+
+		void WriteIndices(GLenum indexType, const std::vector<GLuint> &indices, char *pDst)
+		{
+			const size_t indexSize = GetTypeSize(indexType);
+			for(size_t ix = 0; ix < indices.size(); ix++)
+			{
+				GLuint index = indices[ix];
+				switch(indexSize)
+				{
+				case 1: {GLubyte value = (GLubyte)index; memcpy(pDst, &value, 1);} break;
+				case 2: {GLushort value = (GLushort)index; memcpy(pDst, &value, 2);} break;
+				default: memcpy(pDst, &index, 4); break;
+				}
+				pDst += indexSize;
+			}
+		}
+
+		void ReadIndices(const char *pSrc, GLenum indexType, GLuint count,
+			std::vector<GLuint> &indices)
+		{
+			indices.resize(count);
+			for(GLuint ix = 0; ix < count; ix++)
+			{
+				switch(indexType)
+				{
+				case GL_UNSIGNED_BYTE:
+					indices[ix] = ((const GLubyte *)pSrc)[ix];
+					break;
+				case GL_UNSIGNED_SHORT:
+					{GLushort value; memcpy(&value, pSrc + ix * 2, 2); indices[ix] = value;}
+					break;
+				default:
+					memcpy(&indices[ix], pSrc + ix * 4, 4);
+					break;
+				}
+			}
+		}
+	}
+
+	size_t MeshAttribute::GetVertexSize() const
+	{
+		if(type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV)
+			return 4;
+
+		return GetTypeSize(type) * numComponents;
+	}
+
+	size_t MeshAttribute::GetNumVertices() const
+	{
+		const size_t vertexSize = GetVertexSize();
+		return vertexSize ? data.size() / vertexSize : 0;
+	}
+
+	MeshData::MeshData()
+		: bLodsBuilt(false)
+		, boundsRadius(0.0f)
+		, bClustersBuilt(false)
+		, bQuantized(false)
+	{
+		for(int component = 0; component < 3; component++)
+		{
+			boundsCenter[component] = 0.0f;
+			positionScale[component] = 1.0f;
+			positionOffset[component] = 0.0f;
+		}
+	}
+
+	MeshAttribute *MeshData::FindAttribute( GLuint index )
+	{
+		for(size_t attrib = 0; attrib < attribs.size(); attrib++)
+		{
+			if(attribs[attrib].index == index)
+				return &attribs[attrib];
+		}
+
+		return NULL;
+	}
+
+	const MeshAttribute *MeshData::FindAttribute( GLuint index ) const
+	{
+		return const_cast<MeshData *>(this)->FindAttribute(index);
+	}
+
+	const PackedMeshHeader *GetPackedMeshHeader( const char *pImage, size_t imageSize )
+	{
+		if(imageSize < sizeof(PackedMeshHeader))
+			return NULL;
+
+		const PackedMeshHeader *pHeader = reinterpret_cast<const PackedMeshHeader *>(pImage);
+		if(memcmp(pHeader->magic, g_packedMagic, sizeof(g_packedMagic)) != 0 ||
+			pHeader->version != PACKED_MESH_VERSION)
+		{
+			return NULL;
+		}
+
+		const size_t tableSize = sizeof(PackedMeshHeader) +
+			pHeader->numAttribs * sizeof(PackedMeshAttrib) +
+			pHeader->numPrimitives * sizeof(PackedMeshPrimitive) +
+			pHeader->numVaos * sizeof(PackedMeshVao) +
+			pHeader->numLods * sizeof(PackedMeshLod) +
+			(size_t)pHeader->numClusters * sizeof(PackedMeshCluster);
+		if(pHeader->numAttribs > 16 || pHeader->numLods > 32 || tableSize > imageSize)
+			return NULL;
+
+		if(!RangeInside(pHeader->vertexDataOffset, pHeader->vertexDataSize, imageSize) ||
+			!RangeInside(pHeader->indexDataOffset, pHeader->indexDataSize, imageSize))
+		{
+			return NULL;
+		}
+
+		const PackedMeshAttrib *pAttribs = GetPackedAttribs(pHeader);
+		for(GLuint attrib = 0; attrib < pHeader->numAttribs; attrib++)
+		{
+			if(!RangeInside(pAttribs[attrib].dataOffset, pAttribs[attrib].dataSize,
+				pHeader->vertexDataSize))
+			{
+				return NULL;
+			}
+		}
+
+		const PackedMeshPrimitive *pPrims = GetPackedPrimitives(pHeader);
+		for(GLuint prim = 0; prim < pHeader->numPrimitives; prim++)
+		{
+			const size_t indexSize = GetTypeSize(pPrims[prim].indexType);
+			if(pPrims[prim].indexType &&
+				(pPrims[prim].dataSize != pPrims[prim].count * indexSize ||
+				!RangeInside(pPrims[prim].dataOffset, pPrims[prim].dataSize,
+				pHeader->indexDataSize)))
+			{
+				return NULL;
+			}
+		}
+
+		const PackedMeshVao *pVaos = GetPackedVaos(pHeader);
+		for(GLuint vao = 0; vao < pHeader->numVaos; vao++)
+		{
+			if(!RangeInside(pVaos[vao].nameOffset, pVaos[vao].nameLength, imageSize))
+				return NULL;
+		}
+
+		const PackedMeshLod *pLods = GetPackedLods(pHeader);
+		for(GLuint lod = 0; lod < pHeader->numLods; lod++)
+		{
+			const size_t indexSize = GetTypeSize(pLods[lod].indexType);
+			if(!indexSize || pLods[lod].dataSize != pLods[lod].count * indexSize ||
+				!RangeInside(pLods[lod].dataOffset, pLods[lod].dataSize, pHeader->indexDataSize))
+			{
+				return NULL;
+			}
+		}
+
+		const PackedMeshCluster *pClusters = GetPackedClusters(pHeader);
+		for(GLuint cluster = 0; cluster < pHeader->numClusters; cluster++)
+		{
+			if(pHeader->numPrimitives != 1 || !pPrims[0].indexType ||
+				!RangeInside(pClusters[cluster].firstIndex, pClusters[cluster].numIndices,
+				pPrims[0].count))
+			{
+				return NULL;
+			}
+		}
+
+		return pHeader;
+	}
+
+	void PackMesh( const MeshData &mesh, std::vector<char> &image )
+	{
+		PackedMeshHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, g_packedMagic, sizeof(g_packedMagic));
+		header.version = PACKED_MESH_VERSION;
+		header.numAttribs = (GLuint)mesh.attribs.size();
+		header.numPrimitives = (GLuint)mesh.primitives.size();
+		header.numVaos = (GLuint)mesh.vaos.size();
+		header.numLods = (GLuint)mesh.lods.size();
+		header.numClusters = (GLuint)mesh.clusters.size();
+		header.flags = (mesh.bQuantized ? PACKED_MESH_QUANTIZED : 0) |
+			(mesh.bLodsBuilt ? PACKED_MESH_HAS_LODS : 0) |
+			(mesh.bClustersBuilt ? PACKED_MESH_HAS_CLUSTERS : 0);
+		memcpy(header.positionScale, mesh.positionScale, sizeof(header.positionScale));
+		memcpy(header.positionOffset, mesh.positionOffset, sizeof(header.positionOffset));
+		memcpy(header.boundsCenter, mesh.boundsCenter, sizeof(header.boundsCenter));
+		header.boundsRadius = mesh.boundsRadius;
+
+		//Lay everything out first, so the image is sized once.
+		size_t fileSize = sizeof(PackedMeshHeader) +
+			mesh.attribs.size() * sizeof(PackedMeshAttrib) +
+			mesh.primitives.size() * sizeof(PackedMeshPrimitive) +
+			mesh.vaos.size() * sizeof(PackedMeshVao) +
+			mesh.lods.size() * sizeof(PackedMeshLod) +
+			mesh.clusters.size() * sizeof(PackedMeshCluster);
+
+		std::vector<PackedMeshVao> vaos(mesh.vaos.size());
+		for(size_t vao = 0; vao < mesh.vaos.size(); vao++)
+		{
+			memset(&vaos[vao], 0, sizeof(PackedMeshVao));
+			vaos[vao].nameOffset = (GLuint)fileSize;
+			vaos[vao].nameLength = (GLuint)mesh.vaos[vao].name.size();
+			for(size_t source = 0; source < mesh.vaos[vao].attribs.size(); source++)
+				vaos[vao].attribMask |= 1 << mesh.vaos[vao].attribs[source];
+
+			fileSize += mesh.vaos[vao].name.size();
+		}
+
+		std::vector<PackedMeshAttrib> attribs(mesh.attribs.size());
+		size_t dataSize = 0;
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+		{
+			const MeshAttribute &src = mesh.attribs[attrib];
+			memset(&attribs[attrib], 0, sizeof(PackedMeshAttrib));
+			attribs[attrib].index = src.index;
+			attribs[attrib].type = src.type;
+			attribs[attrib].numComponents = src.numComponents;
+			attribs[attrib].flags = (src.bNormalized ? PACKED_ATTRIB_NORMALIZED : 0) |
+				(src.bIntegral ? PACKED_ATTRIB_INTEGRAL : 0);
+			attribs[attrib].dataOffset = AlignUp(dataSize);
+			attribs[attrib].dataSize = (GLuint)src.data.size();
+			dataSize = attribs[attrib].dataOffset + src.data.size();
+		}
+
+		header.vertexDataOffset = AlignUp(fileSize);
+		header.vertexDataSize = (GLuint)dataSize;
+		fileSize = header.vertexDataOffset + dataSize;
+
+		std::vector<PackedMeshPrimitive> prims(mesh.primitives.size());
+		dataSize = 0;
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const MeshPrimitive &src = mesh.primitives[prim];
+			PackedMeshPrimitive &dst = prims[prim];
+			memset(&dst, 0, sizeof(PackedMeshPrimitive));
+			dst.primType = src.primType;
+			dst.indexType = src.indexType;
+			dst.start = src.start;
+			dst.count = src.indexType ? (GLuint)src.indices.size() : src.count;
+			dst.flags = src.bPrimRestart ? PACKED_PRIM_RESTART : 0;
+			dst.primRestart = src.primRestart;
+			if(!src.indexType)
+				continue;
+
+			dst.dataOffset = PlaceIndices(src.indexType, src.indices, dataSize);
+			dst.dataSize = (GLuint)(src.indices.size() * GetTypeSize(src.indexType));
+		}
+
+		std::vector<PackedMeshLod> lods(mesh.lods.size());
+		for(size_t lod = 0; lod < mesh.lods.size(); lod++)
+		{
+			const MeshLod &src = mesh.lods[lod];
+			PackedMeshLod &dst = lods[lod];
+			memset(&dst, 0, sizeof(PackedMeshLod));
+			dst.indexType = src.indexType;
+			dst.count = (GLuint)src.indices.size();
+			dst.error = src.error;
+			dst.dataOffset = PlaceIndices(src.indexType, src.indices, dataSize);
+			dst.dataSize = (GLuint)(src.indices.size() * GetTypeSize(src.indexType));
+		}
+
+		header.indexDataOffset = AlignUp(fileSize);
+		header.indexDataSize = (GLuint)dataSize;
+		fileSize = header.indexDataOffset + dataSize;
+
+		image.assign(fileSize, 0);
+		char *pImage = &image[0];
+		char *pTable = pImage;
+
+		memcpy(pTable, &header, sizeof(header));
+		pTable += sizeof(header);
+		if(!attribs.empty())
+			memcpy(pTable, &attribs[0], attribs.size() * sizeof(PackedMeshAttrib));
+		pTable += attribs.size() * sizeof(PackedMeshAttrib);
+		if(!prims.empty())
+			memcpy(pTable, &prims[0], prims.size() * sizeof(PackedMeshPrimitive));
+		pTable += prims.size() * sizeof(PackedMeshPrimitive);
+		if(!vaos.empty())
+			memcpy(pTable, &vaos[0], vaos.size() * sizeof(PackedMeshVao));
+		pTable += vaos.size() * sizeof(PackedMeshVao);
+		if(!lods.empty())
+			memcpy(pTable, &lods[0], lods.size() * sizeof(PackedMeshLod));
+		pTable += lods.size() * sizeof(PackedMeshLod);
+		for(size_t cluster = 0; cluster < mesh.clusters.size(); cluster++)
+		{
+			const MeshCluster &src = mesh.clusters[cluster];
+			PackedMeshCluster dst;
+			memset(&dst, 0, sizeof(PackedMeshCluster));
+			dst.firstIndex = src.firstIndex;
+			dst.numIndices = src.numIndices;
+			memcpy(dst.center, src.center, sizeof(dst.center));
+			dst.radius = src.radius;
+			memcpy(dst.coneAxis, src.coneAxis, sizeof(dst.coneAxis));
+			dst.coneCos = src.coneCos;
+			memcpy(pTable, &dst, sizeof(PackedMeshCluster));
+			pTable += sizeof(PackedMeshCluster);
+		}
+
+		for(size_t vao = 0; vao < mesh.vaos.size(); vao++)
+		{
+			memcpy(pImage + vaos[vao].nameOffset, mesh.vaos[vao].name.data(),
+				mesh.vaos[vao].name.size());
+		}
+
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+		{
+			if(!mesh.attribs[attrib].data.empty())
+			{
+				memcpy(pImage + header.vertexDataOffset + attribs[attrib].dataOffset,
+					&mesh.attribs[attrib].data[0], mesh.attribs[attrib].data.size());
+			}
+		}
+
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const MeshPrimitive &src = mesh.primitives[prim];
+			if(src.indexType)
+			{
+				WriteIndices(src.indexType, src.indices,
+					pImage + header.indexDataOffset + prims[prim].dataOffset);
+			}
+		}
+
+		for(size_t lod = 0; lod < mesh.lods.size(); lod++)
+		{
+			WriteIndices(mesh.lods[lod].indexType, mesh.lods[lod].indices,
+				pImage + header.indexDataOffset + lods[lod].dataOffset);
+		}
+	}
+
+	void UnpackCluster( const PackedMeshCluster &packed, MeshCluster &cluster )
+	{
+		cluster.firstIndex = packed.firstIndex;
+		cluster.numIndices = packed.numIndices;
+		memcpy(cluster.center, packed.center, sizeof(cluster.center));
+		cluster.radius = packed.radius;
+		memcpy(cluster.coneAxis, packed.coneAxis, sizeof(cluster.coneAxis));
+		cluster.coneCos = packed.coneCos;
+	}
+
+	bool UnpackMesh( const char *pImage, size_t imageSize, MeshData &mesh )
+	{
+		const PackedMeshHeader *pHeader = GetPackedMeshHeader(pImage, imageSize);
+		if(!pHeader)
+			return false;
+
+		const char *pVertexData = pImage + pHeader->vertexDataOffset;
+		const char *pIndexData = pImage + pHeader->indexDataOffset;
+
+		mesh = MeshData();
+		mesh.bQuantized = (pHeader->flags & PACKED_MESH_QUANTIZED) != 0;
+		memcpy(mesh.positionScale, pHeader->positionScale, sizeof(mesh.positionScale));
+		memcpy(mesh.positionOffset, pHeader->positionOffset, sizeof(mesh.positionOffset));
+		mesh.bLodsBuilt = (pHeader->flags & PACKED_MESH_HAS_LODS) != 0;
+		memcpy(mesh.boundsCenter, pHeader->boundsCenter, sizeof(mesh.boundsCenter));
+		mesh.boundsRadius = pHeader->boundsRadius;
+		mesh.bClustersBuilt = (pHeader->flags & PACKED_MESH_HAS_CLUSTERS) != 0;
+
+		const PackedMeshAttrib *pAttribs = GetPackedAttribs(pHeader);
+		mesh.attribs.resize(pHeader->numAttribs);
+		for(GLuint attrib = 0; attrib < pHeader->numAttribs; attrib++)
+		{
+			const PackedMeshAttrib &src = pAttribs[attrib];
+			MeshAttribute &dst = mesh.attribs[attrib];
+			dst.index = src.index;
+			dst.type = src.type;
+			dst.numComponents = src.numComponents;
+			dst.bNormalized = (src.flags & PACKED_ATTRIB_NORMALIZED) != 0;
+			dst.bIntegral = (src.flags & PACKED_ATTRIB_INTEGRAL) != 0;
+			dst.data.assign(pVertexData + src.dataOffset, pVertexData + src.dataOffset + src.dataSize);
+		}
+
+		const PackedMeshPrimitive *pPrims = GetPackedPrimitives(pHeader);
+		mesh.primitives.resize(pHeader->numPrimitives);
+		for(GLuint prim = 0; prim < pHeader->numPrimitives; prim++)
+		{
+			const PackedMeshPrimitive &src = pPrims[prim];
+			MeshPrimitive &dst = mesh.primitives[prim];
+			dst.primType = src.primType;
+			dst.indexType = src.indexType;
+			dst.start = src.start;
+			dst.count = src.count;
+			dst.bPrimRestart = (src.flags & PACKED_PRIM_RESTART) != 0;
+			dst.primRestart = src.primRestart;
+			if(src.indexType)
+				ReadIndices(pIndexData + src.dataOffset, src.indexType, src.count, dst.indices);
+		}
+
+		const PackedMeshVao *pVaos = GetPackedVaos(pHeader);
+		mesh.vaos.resize(pHeader->numVaos);
+		for(GLuint vao = 0; vao < pHeader->numVaos; vao++)
+		{
+			MeshVaoSet &dst = mesh.vaos[vao];
+			dst.name.assign(pImage + pVaos[vao].nameOffset, pVaos[vao].nameLength);
+			for(GLuint index = 0; index < 32; index++)
+			{
+				if(pVaos[vao].attribMask & (1 << index))
+					dst.attribs.push_back(index);
+			}
+		}
+
+		const PackedMeshLod *pLods = GetPackedLods(pHeader);
+		mesh.lods.resize(pHeader->numLods);
+		for(GLuint lod = 0; lod < pHeader->numLods; lod++)
+		{
+			const PackedMeshLod &src = pLods[lod];
+			MeshLod &dst = mesh.lods[lod];
+			dst.indexType = src.indexType;
+			dst.error = src.error;
+			ReadIndices(pIndexData + src.dataOffset, src.indexType, src.count, dst.indices);
+		}
+
+		const PackedMeshCluster *pClusters = GetPackedClusters(pHeader);
+		mesh.clusters.resize(pHeader->numClusters);
+		for(GLuint cluster = 0; cluster < pHeader->numClusters; cluster++)
+			UnpackCluster(pClusters[cluster], mesh.clusters[cluster]);
+
+		return true;
+	}
+
+	bool ReadPackedMeshImage( const std::string &strFilename, std::vector<char> &image )
+	{
+		image.clear();
+
+		FILE *pFile = fopen(strFilename.c_str(), "rb");
+		if(!pFile)
+			return false;
+
+		if(fseek(pFile, 0, SEEK_END) == 0)
+		{
+			long fileSize = ftell(pFile);
+			if(fileSize > 0 && fseek(pFile, 0, SEEK_SET) == 0)
+			{
+				image.resize(fileSize);
+				if(fread(&image[0], 1, image.size(), pFile) != image.size())
+					image.clear();
+			}
+		}
+		fclose(pFile);
+
+		if(image.empty() || !GetPackedMeshHeader(&image[0], image.size()))
+		{
+			image.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	void WritePackedMeshImage( const std::string &strFilename, const std::vector<char> &image )
+	{
+		FILE *pFile = fopen(strFilename.c_str(), "wb");
+		if(!pFile)
+			throw std::runtime_error("Could not open the file " + strFilename + " for writing.");
+
+		bool bWritten = fwrite(&image[0], 1, image.size(), pFile) == image.size();
+		bWritten = (fclose(pFile) == 0) && bWritten;
+		if(!bWritten)
+		{
+			remove(strFilename.c_str());
+			throw std::runtime_error("Could not write the file " + strFilename + ".");
+		}
+	}
+
+	std::string GetPackedMeshFilename( const std::string &strXmlFilename )
+	{
+		const size_t extension = strXmlFilename.rfind('.');
+		const size_t lastSlash = strXmlFilename.find_last_of("/\\");
+		if(extension == std::string::npos ||
+			(lastSlash != std::string::npos && extension < lastSlash))
+		{
+			return strXmlFilename + ".mesh";
+		}
+
+		return strXmlFilename.substr(0, extension) + ".mesh";
+	}
+
+	bool LoadPackedMeshFile( const std::string &strFilename, MeshData &mesh )
+	{
+		MappedFile packedFile(strFilename);
+		return packedFile.IsOpen() && UnpackMesh(packedFile.GetData(), packedFile.GetSize(), mesh);
+	}
+
+	void SavePackedMeshFile( const std::string &strFilename, const MeshData &mesh )
+	{
+		std::vector<char> image;
+		PackMesh(mesh, image);
+		WritePackedMeshImage(strFilename, image);
+	}
+}
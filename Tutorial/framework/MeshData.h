@@ -0,0 +1,145 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MESH_DATA_H
+#define FRAMEWORK_MESH_DATA_H
+
+#include <string>
+#include <vector>
+#include <glload/gl_3_3.h>
+
+namespace Framework
+{
+	struct PackedMeshCluster;
+
+	//One <attribute> of a mesh file. The values are tightly packed, numComponents per vertex,
+	//in the GL type they will be uploaded as.
+	struct MeshAttribute
+	{
+		GLuint index;
+		GLenum type;
+		int numComponents;
+		bool bNormalized;
+		bool bIntegral;
+		std::vector<char> data;
+
+		size_t GetVertexSize() const;
+		size_t GetNumVertices() const;
+	};
+
+	//One <indices> or <arrays> element. For <arrays>, indexType is 0 and the vertices drawn
+	//are start through start + count - 1. Indices are kept as GLuint whatever indexType
+	//they are uploaded as.
+	struct MeshPrimitive
+	{
+		GLenum primType;
+		GLenum indexType;
+		GLuint start;
+		GLuint count;
+		bool bPrimRestart;
+		GLuint primRestart;
+		std::vector<GLuint> indices;
+	};
+
+	//A <vao> element: a name and the attribute indices it sources.
+	struct MeshVaoSet
+	{
+		std::string name;
+		std::vector<GLuint> attribs;
+	};
+
+	//A coarser version of the mesh's triangles, made by BuildLods (see MeshSimplify.h). It is
+	//an indexed triangle list over the mesh's own vertices. error is how far, in model space,
+	//its surface may be from the full mesh's.
+	struct MeshLod
+	{
+		GLenum indexType;
+		float error;
+		std::vector<GLuint> indices;
+	};
+
+	//A run of the mesh's triangles that lie close together and face much the same way, made
+	//by BuildClusters (see MeshCluster.h), with the bounds to cull them by as one. The
+	//triangles are indices firstIndex through firstIndex + numIndices - 1 of the mesh's one
+	//triangle list. Everything is in model space.
+	struct MeshCluster
+	{
+		GLuint firstIndex;
+		GLuint numIndices;
+		float center[3];
+		float radius;
+		//The triangles' average facing, taking counter-clockwise winding as the front, and
+		//the cosine of the widest angle any of them makes with it. 0 or less if they face too
+		//many ways to be culled together.
+		float coneAxis[3];
+		float coneCos;
+	};
+
+	//Everything Framework::Mesh reads from a mesh file, kept in memory for tools to work on.
+	struct MeshData
+	{
+		std::vector<MeshAttribute> attribs;
+		std::vector<MeshPrimitive> primitives;
+		std::vector<MeshVaoSet> vaos;
+
+		//Levels 1 and up, each coarser than the last; the primitives are level 0. Only
+		//BuildLods makes them, which sets bLodsBuilt even if the mesh could not be simplified,
+		//and the sphere around the positions (in model space) that levels are picked with.
+		std::vector<MeshLod> lods;
+		bool bLodsBuilt;
+		float boundsCenter[3];
+		float boundsRadius;
+
+		//Only BuildClusters makes them, which sets bClustersBuilt even if the mesh could not
+		//be split.
+		std::vector<MeshCluster> clusters;
+		bool bClustersBuilt;
+
+		//Model-space position = stored position * positionScale + positionOffset, per
+		//component. The identity unless the mesh has been through QuantizeMesh, which sets
+		//bQuantized.
+		bool bQuantized;
+		float positionScale[3];
+		float positionOffset[3];
+
+		MeshData();
+
+		//Returns NULL if there is no attribute with that index.
+		MeshAttribute *FindAttribute(GLuint index);
+		const MeshAttribute *FindAttribute(GLuint index) const;
+	};
+
+	//Reads a mesh .xml file from the given path. Throws std::runtime_error on anything it
+	//can't read.
+	void LoadMeshXml(const std::string &strFilename, MeshData &mesh);
+
+	//Writes the mesh as a mesh .xml file that LoadMeshXml reads back to the same data.
+	//Comments and formatting of the file it came from are not kept, nor are levels of detail
+	//and clusters.
+	//A quantized mesh can't be written, as the format has no place for its position
+	//decoding. Throws std::runtime_error if it can't write, and leaves no partial file
+	//behind.
+	void SaveMeshXml(const std::string &strFilename, const MeshData &mesh);
+
+	//The packed binary form of a mesh (see PackedMeshFormat.h) is handled as an image: the
+	//whole file as one block of bytes.
+	void PackMesh(const MeshData &mesh, std::vector<char> &image);
+	bool UnpackMesh(const char *pImage, size_t imageSize, MeshData &mesh);
+	//One entry of the cluster table, for readers that only want the clusters.
+	void UnpackCluster(const PackedMeshCluster &packed, MeshCluster &cluster);
+
+	//ReadPackedMeshImage returns false if the file is missing, damaged, or from another
+	//version of the format. WritePackedMeshImage throws std::runtime_error if it can't write,
+	//and leaves no partial file behind.
+	bool ReadPackedMeshImage(const std::string &strFilename, std::vector<char> &image);
+	void WritePackedMeshImage(const std::string &strFilename, const std::vector<char> &image);
+
+	//Where the packed copy of a mesh .xml file goes: the same path with the .mesh extension.
+	std::string GetPackedMeshFilename(const std::string &strXmlFilename);
+
+	//The above, for tools that work on the MeshData.
+	bool LoadPackedMeshFile(const std::string &strFilename, MeshData &mesh);
+	void SavePackedMeshFile(const std::string &strFilename, const MeshData &mesh);
+}
+
+#endif //FRAMEWORK_MESH_DATA_H
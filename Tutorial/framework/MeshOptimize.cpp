@@ -0,0 +1,415 @@
+//This file is licensed under the MIT License.
+
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "MeshOptimize.h"
+
+namespace Framework
+{
+	namespace
+	{
+		bool IsIndexedTriangles(const MeshPrimitive &prim)
+		{
+			return prim.indexType && !prim.bPrimRestart && (prim.primType == GL_TRIANGLES ||
+				prim.primType == GL_TRIANGLE_STRIP || prim.primType == GL_TRIANGLE_FAN);
+		}
+
+		size_t GetNumTriangles(const MeshPrimitive &prim)
+		{
+			if(prim.primType == GL_TRIANGLES)
+				return prim.indices.size() / 3;
+
+			return prim.indices.size() > 2 ? prim.indices.size() - 2 : 0;
+		}
+
+		//Appends the primitive's triangles as a list, in the winding GL would draw them
+		//with. Degenerate triangles, which draw nothing, are left out.
+		void AppendTriangles(const MeshPrimitive &prim, std::vector<GLuint> &triangles)
+		{
+			const std::vector<GLuint> &indices = prim.indices;
+			for(size_t triangle = 0; triangle < GetNumTriangles(prim); triangle++)
+			{
+				GLuint corners[3];
+				switch(prim.primType)
+				{
+				case GL_TRIANGLE_STRIP:
+					corners[0] = indices[triangle + (triangle & 1)];
+					corners[1] = indices[triangle + 1 - (triangle & 1)];
+					corners[2] = indices[triangle + 2];
+					break;
+				case GL_TRIANGLE_FAN:
+					corners[0] = indices[0];
+					corners[1] = indices[triangle + 1];
+					corners[2] = indices[triangle + 2];
+					break;
+				default:
+					corners[0] = indices[triangle * 3];
+					corners[1] = indices[triangle * 3 + 1];
+					corners[2] = indices[triangle * 3 + 2];
+					break;
+				}
+
+				if(corners[0] != corners[1] && corners[1] != corners[2] && corners[0] != corners[2])
+					triangles.insert(triangles.end(), corners, corners + 3);
+			}
+		}
+
+		//Tipsify's choice of the next fanning vertex: of the vertices just emitted that still
+		//have triangles left, the one that will still be in the cache after those triangles
+		//and has been there longest. If none qualifies, the most recent dead end with
+		//triangles left, and failing that, the next such vertex in input order.
+		int GetNextVertex(const std::vector<GLuint> &candidates, const std::vector<int> &cacheTime,
+			int timeStamp, int cacheSize, const std::vector<int> &liveTriangles,
+			std::vector<GLuint> &deadEnds, GLuint &cursor)
+		{
+			int bestVertex = -1;
+			int bestPriority = -1;
+			for(size_t candidate = 0; candidate < candidates.size(); candidate++)
+			{
+				const GLuint vertex = candidates[candidate];
+				if(liveTriangles[vertex] <= 0)
+					continue;
+
+				int priority = 0;
+				if(timeStamp - cacheTime[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+					priority = timeStamp - cacheTime[vertex];
+				if(priority > bestPriority)
+				{
+					bestPriority = priority;
+					bestVertex = (int)vertex;
+				}
+			}
+
+			if(bestVertex != -1)
+				return bestVertex;
+
+			while(!deadEnds.empty())
+			{
+				const GLuint vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if(liveTriangles[vertex] > 0)
+					return (int)vertex;
+			}
+
+			for(; cursor < liveTriangles.size(); cursor++)
+			{
+				if(liveTriangles[cursor] > 0)
+					return (int)cursor;
+			}
+
+			return -1;
+		}
+
+		VertexCacheStats SimulatePrimitives(const std::vector<MeshPrimitive> &primitives,
+			size_t numVertices, int cacheSize)
+		{
+			VertexCacheStats stats;
+			memset(&stats, 0, sizeof(stats));
+
+			std::vector<bool> used(numVertices, false);
+
+			//The cache is a ring of the last cacheSize misses; inCache says where each vertex
+			//went in, so a hit is a vertex whose entry has not been overwritten since.
+			std::vector<size_t> inCache(numVertices, 0);
+			for(size_t prim = 0; prim < primitives.size(); prim++)
+			{
+				const MeshPrimitive &curr = primitives[prim];
+				if(!IsIndexedTriangles(curr))
+					continue;
+
+				//Each draw starts with an empty cache.
+				const size_t drawStart = stats.numTransformed;
+				for(size_t ix = 0; ix < curr.indices.size(); ix++)
+				{
+					const GLuint vertex = curr.indices[ix];
+					if(!used[vertex])
+					{
+						used[vertex] = true;
+						stats.numVertices++;
+					}
+
+					const bool bHit = inCache[vertex] > drawStart &&
+						stats.numTransformed - inCache[vertex] < (size_t)cacheSize;
+					if(!bHit)
+						inCache[vertex] = ++stats.numTransformed;
+				}
+
+				stats.numTriangles += GetNumTriangles(curr);
+			}
+
+			return stats;
+		}
+
+		void TipsifyIndices(std::vector<GLuint> &indices, size_t numVertices, int cacheSize)
+		{
+			const size_t numTriangles = indices.size() / 3;
+
+			//Each vertex's triangles, as one array sliced by firstTriangle.
+			std::vector<int> liveTriangles(numVertices, 0);
+			for(size_t ix = 0; ix < numTriangles * 3; ix++)
+				liveTriangles[indices[ix]]++;
+
+			std::vector<size_t> firstTriangle(numVertices + 1, 0);
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+				firstTriangle[vertex + 1] = firstTriangle[vertex] + liveTriangles[vertex];
+
+			std::vector<GLuint> vertexTriangles(firstTriangle[numVertices]);
+			std::vector<size_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+			for(size_t triangle = 0; triangle < numTriangles; triangle++)
+			{
+				for(int corner = 0; corner < 3; corner++)
+					vertexTriangles[fill[indices[triangle * 3 + corner]]++] = (GLuint)triangle;
+			}
+
+			std::vector<int> cacheTime(numVertices, 0);
+			std::vector<bool> emitted(numTriangles, false);
+			std::vector<GLuint> deadEnds;
+			std::vector<GLuint> candidates;
+			std::vector<GLuint> output;
+			output.reserve(numTriangles * 3);
+
+			int timeStamp = cacheSize + 1;
+			GLuint cursor = 0;
+			int fanVertex = numTriangles ? (int)indices[0] : -1;
+			while(fanVertex >= 0)
+			{
+				candidates.clear();
+				for(size_t slot = firstTriangle[fanVertex]; slot < firstTriangle[fanVertex + 1]; slot++)
+				{
+					const GLuint triangle = vertexTriangles[slot];
+					if(emitted[triangle])
+						continue;
+
+					for(int corner = 0; corner < 3; corner++)
+					{
+						const GLuint vertex = indices[triangle * 3 + corner];
+						output.push_back(vertex);
+						deadEnds.push_back(vertex);
+						candidates.push_back(vertex);
+						liveTriangles[vertex]--;
+						if(timeStamp - cacheTime[vertex] > cacheSize)
+							cacheTime[vertex] = timeStamp++;
+					}
+					emitted[triangle] = true;
+				}
+
+				fanVertex = GetNextVertex(candidates, cacheTime, timeStamp, cacheSize,
+					liveTriangles, deadEnds, cursor);
+			}
+
+			indices.swap(output);
+		}
+	}
+
+	size_t GetNumVertices( const MeshData &mesh )
+	{
+		return mesh.attribs.empty() ? 0 : mesh.attribs[0].GetNumVertices();
+	}
+
+	void GetTriangles( const MeshData &mesh, std::vector<GLuint> &triangles )
+	{
+		triangles.clear();
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			if(IsIndexedTriangles(mesh.primitives[prim]))
+				AppendTriangles(mesh.primitives[prim], triangles);
+		}
+	}
+
+	double VertexCacheStats::GetAcmr() const
+	{
+		return numTriangles ? numTransformed / (double)numTriangles : 0.0;
+	}
+
+	double VertexCacheStats::GetAtvr() const
+	{
+		return numVertices ? numTransformed / (double)numVertices : 0.0;
+	}
+
+	bool HasOnlyTriangles( const MeshData &mesh )
+	{
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			if(!IsIndexedTriangles(mesh.primitives[prim]))
+				return false;
+		}
+
+		return true;
+	}
+
+	GLenum GetWidestIndexType( const MeshData &mesh )
+	{
+		GLenum indexType = GL_UNSIGNED_BYTE;
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const GLenum curr = mesh.primitives[prim].indexType;
+			if(curr == GL_UNSIGNED_INT ||
+				(curr == GL_UNSIGNED_SHORT && indexType == GL_UNSIGNED_BYTE))
+			{
+				indexType = curr;
+			}
+		}
+
+		return indexType;
+	}
+
+	bool GetPositions( const MeshData &mesh, std::vector<float> &positions )
+	{
+		positions.clear();
+		const MeshAttribute *pPositions = mesh.FindAttribute(0);
+		if(!pPositions || pPositions->type != GL_FLOAT || pPositions->numComponents < 3 ||
+			mesh.bQuantized)
+		{
+			return false;
+		}
+
+		const size_t numVertices = pPositions->GetNumVertices();
+		const size_t vertexSize = pPositions->GetVertexSize();
+		positions.resize(numVertices * 3);
+		for(size_t vertex = 0; vertex < numVertices; vertex++)
+			memcpy(&positions[vertex * 3], &pPositions->data[vertex * vertexSize], 3 * sizeof(float));
+
+		return true;
+	}
+
+	VertexCacheStats SimulateVertexCache( const MeshData &mesh, int cacheSize )
+	{
+		return SimulatePrimitives(mesh.primitives, GetNumVertices(mesh), cacheSize);
+	}
+
+	void OptimizeVertexCache( MeshData &mesh, int cacheSize )
+	{
+		//Each level of detail is a triangle list already, drawn on its own.
+		for(size_t lod = 0; lod < mesh.lods.size(); lod++)
+			TipsifyIndices(mesh.lods[lod].indices, GetNumVertices(mesh), cacheSize);
+
+		//Clusters are ranges of the one list that culling draws on their own, so each is
+		//ordered within itself.
+		if(!mesh.clusters.empty())
+		{
+			std::vector<GLuint> &indices = mesh.primitives[0].indices;
+			for(size_t cluster = 0; cluster < mesh.clusters.size(); cluster++)
+			{
+				const MeshCluster &curr = mesh.clusters[cluster];
+				std::vector<GLuint> range(indices.begin() + curr.firstIndex,
+					indices.begin() + curr.firstIndex + curr.numIndices);
+				TipsifyIndices(range, GetNumVertices(mesh), cacheSize);
+				std::copy(range.begin(), range.end(), indices.begin() + curr.firstIndex);
+			}
+			return;
+		}
+
+		//Every triangle primitive is drawn with the same VAO, so they can all become one list,
+		//in place of the first of them, with the widest index type any of them used.
+		std::vector<GLuint> triangles;
+		size_t firstPrim = mesh.primitives.size();
+		GLenum indexType = GL_UNSIGNED_BYTE;
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const MeshPrimitive &curr = mesh.primitives[prim];
+			if(!IsIndexedTriangles(curr))
+				continue;
+
+			if(firstPrim == mesh.primitives.size())
+				firstPrim = prim;
+			if(curr.indexType == GL_UNSIGNED_INT ||
+				(curr.indexType == GL_UNSIGNED_SHORT && indexType == GL_UNSIGNED_BYTE))
+			{
+				indexType = curr.indexType;
+			}
+			AppendTriangles(curr, triangles);
+		}
+
+		if(triangles.empty())
+			return;
+
+		const size_t numVertices = GetNumVertices(mesh);
+		TipsifyIndices(triangles, numVertices, cacheSize);
+
+		MeshPrimitive list = mesh.primitives[firstPrim];
+		list.primType = GL_TRIANGLES;
+		list.indexType = indexType;
+		list.count = (GLuint)triangles.size();
+		list.indices.swap(triangles);
+
+		std::vector<MeshPrimitive> primitives;
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			if(prim == firstPrim)
+				primitives.push_back(list);
+			else if(!IsIndexedTriangles(mesh.primitives[prim]))
+				primitives.push_back(mesh.primitives[prim]);
+		}
+
+		//Strips and fans that are already well ordered can beat the list; they are kept then.
+		if(SimulatePrimitives(primitives, numVertices, cacheSize).numTransformed <=
+			SimulatePrimitives(mesh.primitives, numVertices, cacheSize).numTransformed)
+		{
+			mesh.primitives.swap(primitives);
+		}
+	}
+
+	bool OptimizeVertexFetch( MeshData &mesh )
+	{
+		const size_t numVertices = GetNumVertices(mesh);
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			const MeshPrimitive &curr = mesh.primitives[prim];
+			if(!curr.indexType || (curr.bPrimRestart && curr.primRestart < numVertices))
+				return false;
+		}
+
+		const GLuint unmapped = 0xFFFFFFFF;
+		std::vector<GLuint> newIndex(numVertices, unmapped);
+		std::vector<GLuint> oldIndex;
+		oldIndex.reserve(numVertices);
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+		{
+			MeshPrimitive &curr = mesh.primitives[prim];
+			for(size_t ix = 0; ix < curr.indices.size(); ix++)
+			{
+				GLuint &index = curr.indices[ix];
+				if(curr.bPrimRestart && index == curr.primRestart)
+					continue;
+
+				if(newIndex[index] == unmapped)
+				{
+					newIndex[index] = (GLuint)oldIndex.size();
+					oldIndex.push_back(index);
+				}
+				index = newIndex[index];
+			}
+		}
+
+		for(GLuint vertex = 0; vertex < numVertices; vertex++)
+		{
+			if(newIndex[vertex] == unmapped)
+			{
+				newIndex[vertex] = (GLuint)oldIndex.size();
+				oldIndex.push_back(vertex);
+			}
+		}
+
+		for(size_t lod = 0; lod < mesh.lods.size(); lod++)
+		{
+			std::vector<GLuint> &indices = mesh.lods[lod].indices;
+			for(size_t ix = 0; ix < indices.size(); ix++)
+				indices[ix] = newIndex[indices[ix]];
+		}
+
+		std::vector<char> data;
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+		{
+			MeshAttribute &curr = mesh.attribs[attrib];
+			const size_t vertexSize = curr.GetVertexSize();
+			data.resize(curr.data.size());
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+				memcpy(&data[vertex * vertexSize], &curr.data[oldIndex[vertex] * vertexSize], vertexSize);
+			curr.data.swap(data);
+		}
+
+		return true;
+	}
+}
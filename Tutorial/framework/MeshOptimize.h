@@ -0,0 +1,72 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MESH_OPTIMIZE_H
+#define FRAMEWORK_MESH_OPTIMIZE_H
+
+#include <vector>
+#include "MeshData.h"
+
+namespace Framework
+{
+	//A FIFO post-transform cache of this many vertices is what the passes below aim for,
+	//and what the statistics are measured with unless told otherwise.
+	enum
+	{
+		DEFAULT_VERTEX_CACHE_SIZE = 16,
+	};
+
+	//What the vertex shader would do for a mesh's indexed triangles, strips and fans, as
+	//counted by a simulated FIFO cache that starts empty for each primitive. Other
+	//primitives are not counted.
+	struct VertexCacheStats
+	{
+		size_t numTriangles;
+		size_t numVertices;		//Vertices the triangles use.
+		size_t numTransformed;	//Cache misses: vertex shader runs.
+
+		//Average cache miss ratio: shader runs per triangle. 0.5 is the best a large regular
+		//grid can do; 3 is no reuse at all.
+		double GetAcmr() const;
+		//Average transform to vertex ratio: shader runs per vertex used. 1 is ideal.
+		double GetAtvr() const;
+	};
+
+	//The number of vertices in the mesh's first attribute, which is what every attribute
+	//should have.
+	size_t GetNumVertices(const MeshData &mesh);
+
+	//The mesh's indexed triangles, strips and fans as one triangle list, in the winding GL
+	//draws them with. Degenerate triangles are left out.
+	void GetTriangles(const MeshData &mesh, std::vector<GLuint> &triangles);
+
+	//True if every primitive is indexed triangles, strips or fans without a restart index.
+	bool HasOnlyTriangles(const MeshData &mesh);
+
+	//The largest index type any of the mesh's primitives uses, which every one of its
+	//indices fits.
+	GLenum GetWidestIndexType(const MeshData &mesh);
+
+	//Each vertex's position (attribute 0) as 3 floats, in model space. Returns false if the
+	//positions are not floats with at least 3 components, or the mesh is quantized.
+	bool GetPositions(const MeshData &mesh, std::vector<float> &positions);
+
+	VertexCacheStats SimulateVertexCache(const MeshData &mesh,
+		int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+	//Gathers the mesh's indexed triangles, strips and fans into one triangle list, then
+	//orders its triangles so that vertices are reused while they are still in the cache
+	//(Tipsify, Sander et al. 2007). The triangles and their winding are kept; degenerate
+	//ones, which draw nothing, are dropped. If the simulated cache does no better with the
+	//list, the primitives are left as they were. The mesh's levels of detail are reordered
+	//the same way, and so is each of its clusters, within itself.
+	void OptimizeVertexCache(MeshData &mesh, int cacheSize = DEFAULT_VERTEX_CACHE_SIZE);
+
+	//Renumbers the vertices in the order the indices first use them, so the vertex fetch
+	//walks the attribute arrays front to back. Vertices no index uses go last. The levels of
+	//detail are renumbered to match. Returns false, and changes nothing, if the mesh has
+	//<arrays> primitives or a primitive restart index that a vertex could take.
+	bool OptimizeVertexFetch(MeshData &mesh);
+}
+
+#endif //FRAMEWORK_MESH_OPTIMIZE_H
@@ -0,0 +1,249 @@
+//This file is licensed under the MIT License.
+
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "MeshQuantize.h"
+
+namespace Framework
+{
+	namespace
+	{
+		enum
+		{
+			POSITION_ATTRIB = 0,
+			COLOR_ATTRIB = 1,
+			NORMAL_ATTRIB = 2,
+		};
+
+		float GetValue(const MeshAttribute &attrib, size_t valueIx)
+		{
+			float value;
+			memcpy(&value, &attrib.data[valueIx * sizeof(float)], sizeof(float));
+			return value;
+		}
+
+		template<typename T>
+		void SetValue(std::vector<char> &data, size_t valueIx, T value)
+		{
+			memcpy(&data[valueIx * sizeof(T)], &value, sizeof(T));
+		}
+
+		bool IsInUnitRange(const MeshAttribute &attrib)
+		{
+			const size_t numValues = attrib.data.size() / sizeof(float);
+			for(size_t valueIx = 0; valueIx < numValues; valueIx++)
+			{
+				const float value = GetValue(attrib, valueIx);
+				if(!(value >= 0.0f && value <= 1.0f))
+					return false;
+			}
+
+			return true;
+		}
+
+		//Maps [0, 1] onto [0, maxValue], to the nearest step.
+		GLuint ToUnorm(float value, GLuint maxValue)
+		{
+			return (GLuint)floor(value * maxValue + 0.5f);
+		}
+
+		QuantizeReport MakeReport(const MeshAttribute &attrib, const char *strEncoding,
+			const char *strErrorUnits)
+		{
+			QuantizeReport report;
+			report.index = attrib.index;
+			report.strEncoding = strEncoding;
+			report.oldVertexSize = attrib.GetVertexSize();
+			report.newVertexSize = 0;
+			report.maxError = 0.0;
+			report.strErrorUnits = strErrorUnits;
+			return report;
+		}
+
+		void QuantizePositions(MeshData &mesh, MeshAttribute &attrib, QuantizeReport &report)
+		{
+			const int numComponents = attrib.numComponents;
+			const size_t numVertices = attrib.GetNumVertices();
+
+			float minValue[3];
+			float maxValue[3];
+			for(int component = 0; component < numComponents; component++)
+			{
+				minValue[component] = maxValue[component] = GetValue(attrib, component);
+				for(size_t vertex = 1; vertex < numVertices; vertex++)
+				{
+					const float value = GetValue(attrib, vertex * numComponents + component);
+					minValue[component] = std::min(minValue[component], value);
+					maxValue[component] = std::max(maxValue[component], value);
+				}
+
+				mesh.positionOffset[component] = minValue[component];
+				mesh.positionScale[component] = maxValue[component] - minValue[component];
+			}
+
+			std::vector<char> data(numVertices * numComponents * sizeof(GLushort));
+			for(size_t valueIx = 0; valueIx < numVertices * numComponents; valueIx++)
+			{
+				const int component = (int)(valueIx % numComponents);
+				const float extent = mesh.positionScale[component];
+				const float value = GetValue(attrib, valueIx);
+
+				GLuint encoded = 0;
+				if(extent > 0.0f)
+					encoded = ToUnorm((value - minValue[component]) / extent, 0xFFFF);
+				SetValue(data, valueIx, (GLushort)encoded);
+
+				const float decoded = (encoded / 65535.0f) * extent + minValue[component];
+				report.maxError = std::max(report.maxError, (double)fabs(decoded - value));
+			}
+
+			attrib.type = GL_UNSIGNED_SHORT;
+			attrib.bNormalized = true;
+			attrib.data.swap(data);
+		}
+
+		//A signed 10-bit normalized component, in the low bits.
+		GLuint ToSnorm10(float value)
+		{
+			value = std::max(-1.0f, std::min(1.0f, value));
+			const int encoded = (int)floor(value * 511.0f + 0.5f);
+			return (GLuint)encoded & 0x3FF;
+		}
+
+		float FromSnorm10(GLuint bits)
+		{
+			bits &= 0x3FF;
+			const int encoded = (bits & 0x200) ? (int)bits - 0x400 : (int)bits;
+			return std::max(-1.0f, encoded / 511.0f);
+		}
+
+		void QuantizeNormals(MeshAttribute &attrib, QuantizeReport &report)
+		{
+			const size_t numVertices = attrib.GetNumVertices();
+
+			std::vector<char> data(numVertices * sizeof(GLuint));
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+			{
+				float normal[3];
+				GLuint packed = 0;
+				for(int component = 0; component < 3; component++)
+				{
+					normal[component] = GetValue(attrib, vertex * 3 + component);
+					packed |= ToSnorm10(normal[component]) << (component * 10);
+				}
+				SetValue(data, vertex, packed);
+
+				//The angle between the normal and its encoding, which is all lighting sees
+				//once the shader normalizes it.
+				float decoded[3];
+				double dot = 0.0, lengthSqr = 0.0, decodedLengthSqr = 0.0;
+				for(int component = 0; component < 3; component++)
+				{
+					decoded[component] = FromSnorm10(packed >> (component * 10));
+					dot += normal[component] * decoded[component];
+					lengthSqr += normal[component] * normal[component];
+					decodedLengthSqr += decoded[component] * decoded[component];
+				}
+
+				if(lengthSqr > 0.0 && decodedLengthSqr > 0.0)
+				{
+					const double cosAngle = std::min(1.0, dot / sqrt(lengthSqr * decodedLengthSqr));
+					report.maxError = std::max(report.maxError, acos(cosAngle) * 180.0 / 3.14159265358979);
+				}
+			}
+
+			attrib.type = GL_INT_2_10_10_10_REV;
+			attrib.numComponents = 4;
+			attrib.bNormalized = true;
+			attrib.data.swap(data);
+		}
+
+		//Values in [0, 1] to unsigned normalized integers with maxValue as 1. Three
+		//components become four, with an alpha of 1.
+		template<typename T>
+		void QuantizeUnitRange(MeshAttribute &attrib, GLenum type, GLuint maxValue, bool bPadAlpha,
+			QuantizeReport &report)
+		{
+			const int numComponents = attrib.numComponents;
+			const int newComponents = bPadAlpha ? 4 : numComponents;
+			const size_t numVertices = attrib.GetNumVertices();
+
+			std::vector<char> data(numVertices * newComponents * sizeof(T));
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+			{
+				for(int component = 0; component < newComponents; component++)
+				{
+					if(component >= numComponents)
+					{
+						SetValue(data, vertex * newComponents + component, (T)maxValue);
+						continue;
+					}
+
+					const float value = GetValue(attrib, vertex * numComponents + component);
+					const GLuint encoded = ToUnorm(value, maxValue);
+					SetValue(data, vertex * newComponents + component, (T)encoded);
+
+					const double decoded = encoded / (double)maxValue;
+					report.maxError = std::max(report.maxError, fabs(decoded - value));
+				}
+			}
+
+			attrib.type = type;
+			attrib.numComponents = newComponents;
+			attrib.bNormalized = true;
+			attrib.data.swap(data);
+		}
+	}
+
+	void QuantizeMesh( MeshData &mesh, std::vector<QuantizeReport> &report )
+	{
+		report.clear();
+		mesh.bQuantized = true;
+		for(size_t attribIx = 0; attribIx < mesh.attribs.size(); attribIx++)
+		{
+			MeshAttribute &attrib = mesh.attribs[attribIx];
+			if(attrib.type != GL_FLOAT || attrib.bNormalized || attrib.data.empty())
+				continue;
+
+			if(attrib.index == POSITION_ATTRIB)
+			{
+				if(attrib.numComponents > 3)
+					continue;
+
+				report.push_back(MakeReport(attrib, "norm-ushort in the bounding box", "units"));
+				QuantizePositions(mesh, attrib, report.back());
+			}
+			else if(attrib.index == NORMAL_ATTRIB)
+			{
+				if(attrib.numComponents != 3)
+					continue;
+
+				report.push_back(MakeReport(attrib, "int-2-10-10-10", "degrees"));
+				QuantizeNormals(attrib, report.back());
+			}
+			else if(IsInUnitRange(attrib))
+			{
+				if(attrib.index == COLOR_ATTRIB)
+				{
+					report.push_back(MakeReport(attrib, "norm-ubyte", ""));
+					QuantizeUnitRange<GLubyte>(attrib, GL_UNSIGNED_BYTE, 0xFF,
+						attrib.numComponents == 3, report.back());
+				}
+				else
+				{
+					report.push_back(MakeReport(attrib, "norm-ushort", ""));
+					QuantizeUnitRange<GLushort>(attrib, GL_UNSIGNED_SHORT, 0xFFFF, false,
+						report.back());
+				}
+			}
+			else
+			{
+				continue;
+			}
+
+			report.back().newVertexSize = attrib.GetVertexSize();
+		}
+	}
+}
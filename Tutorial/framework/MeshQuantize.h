@@ -0,0 +1,41 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MESH_QUANTIZE_H
+#define FRAMEWORK_MESH_QUANTIZE_H
+
+#include <vector>
+#include "MeshData.h"
+
+namespace Framework
+{
+	//How one attribute was encoded, and what that cost in accuracy. The error is the
+	//largest difference between a value before and after encoding, in the units given.
+	struct QuantizeReport
+	{
+		GLuint index;
+		const char *strEncoding;
+		size_t oldVertexSize;
+		size_t newVertexSize;
+		double maxError;
+		const char *strErrorUnits;
+	};
+
+	//Stores the mesh's float attributes in smaller normalized types. Attributes are told
+	//apart by the indices the tutorials' shaders use for them:
+	//
+	//	0, the position: unsigned 16-bit per component, spanning the mesh's bounding box.
+	//		The mesh's positionScale and positionOffset are set to turn it back.
+	//	2, the normal (3 components): GL_INT_2_10_10_10_REV, with w = 0. The error counts
+	//		the GL 4.2 decoding rule (c / 511); under GL 3.3's rule ((2c + 1) / 1023) a
+	//		normal may also be off by up to another 1/1023 per component.
+	//	1, the diffuse color, if it lies in [0, 1]: unsigned bytes. Three components are
+	//		padded to four with an alpha of 1, which is what a vec4 input reads anyway.
+	//	Any other attribute that lies in [0, 1], such as texture coordinates: unsigned
+	//		16-bit.
+	//
+	//Anything else is left as it is. report gets an entry for each attribute that changed.
+	void QuantizeMesh(MeshData &mesh, std::vector<QuantizeReport> &report);
+}
+
+#endif //FRAMEWORK_MESH_QUANTIZE_H
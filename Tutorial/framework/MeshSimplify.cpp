@@ -0,0 +1,490 @@
+//This file is licensed under the MIT License.
+
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+
+namespace Framework
+{
+	namespace
+	{
+		//Border planes count this many times as much as the triangles' own, per unit of
+		//area, so that outlines hold on until little else is left to collapse.
+		const double BORDER_WEIGHT = 10.0;
+
+		//A level that can't get below this fraction of the previous one's triangles is not
+		//worth its index data.
+		const double MIN_LOD_REDUCTION = 0.9;
+
+		//A collapse may turn a triangle by up to about 75 degrees.
+		const double MIN_FLIP_COS = 0.25;
+
+		typedef std::pair<GLuint, GLuint> Edge;
+
+		//The sum of the squared distances from a point to a set of weighted planes, as the
+		//symmetric matrix of the plane equations' products.
+		struct Quadric
+		{
+			double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+			double weight;
+		};
+
+		void AddPlane(Quadric &quadric, const double normal[3], double d, double weight)
+		{
+			const double a = normal[0], b = normal[1], c = normal[2];
+			quadric.a2 += weight * a * a;
+			quadric.b2 += weight * b * b;
+			quadric.c2 += weight * c * c;
+			quadric.ab += weight * a * b;
+			quadric.ac += weight * a * c;
+			quadric.bc += weight * b * c;
+			quadric.ad += weight * a * d;
+			quadric.bd += weight * b * d;
+			quadric.cd += weight * c * d;
+			quadric.d2 += weight * d * d;
+			quadric.weight += weight;
+		}
+
+		void AddQuadric(Quadric &dst, const Quadric &src)
+		{
+			dst.a2 += src.a2; dst.b2 += src.b2; dst.c2 += src.c2;
+			dst.ab += src.ab; dst.ac += src.ac; dst.bc += src.bc;
+			dst.ad += src.ad; dst.bd += src.bd; dst.cd += src.cd;
+			dst.d2 += src.d2;
+			dst.weight += src.weight;
+		}
+
+		double EvalQuadric(const Quadric &quadric, const float *pPoint)
+		{
+			const double x = pPoint[0], y = pPoint[1], z = pPoint[2];
+			return quadric.a2 * x * x + quadric.b2 * y * y + quadric.c2 * z * z +
+				2.0 * (quadric.ab * x * y + quadric.ac * x * z + quadric.bc * y * z) +
+				2.0 * (quadric.ad * x + quadric.bd * y + quadric.cd * z) + quadric.d2;
+		}
+
+		void Subtract(const float *pLhs, const float *pRhs, double result[3])
+		{
+			for(int component = 0; component < 3; component++)
+				result[component] = (double)pLhs[component] - pRhs[component];
+		}
+
+		void Cross(const double lhs[3], const double rhs[3], double result[3])
+		{
+			result[0] = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+			result[1] = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+			result[2] = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+		}
+
+		double Dot(const double lhs[3], const double rhs[3])
+		{
+			return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+		}
+
+		//The triangle's normal, as long as twice its area.
+		void GetFaceNormal(const float *pA, const float *pB, const float *pC, double normal[3])
+		{
+			double ab[3], ac[3];
+			Subtract(pB, pA, ab);
+			Subtract(pC, pA, ac);
+			Cross(ab, ac, normal);
+		}
+
+		Edge MakeEdge(GLuint first, GLuint second)
+		{
+			return first < second ? Edge(first, second) : Edge(second, first);
+		}
+
+		//The edges that only one triangle uses, sorted.
+		void GetBorderEdges(const std::vector<GLuint> &triangles, std::vector<Edge> &borderEdges)
+		{
+			std::vector<Edge> edges;
+			edges.reserve(triangles.size());
+			for(size_t triangle = 0; triangle < triangles.size(); triangle += 3)
+			{
+				for(int corner = 0; corner < 3; corner++)
+				{
+					edges.push_back(MakeEdge(triangles[triangle + corner],
+						triangles[triangle + (corner + 1) % 3]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+
+			borderEdges.clear();
+			for(size_t edge = 0; edge < edges.size(); )
+			{
+				size_t next = edge + 1;
+				while(next < edges.size() && edges[next] == edges[edge])
+					next++;
+				if(next - edge == 1)
+					borderEdges.push_back(edges[edge]);
+				edge = next;
+			}
+		}
+
+		bool IsBorderEdge(const std::vector<Edge> &borderEdges, GLuint first, GLuint second)
+		{
+			return std::binary_search(borderEdges.begin(), borderEdges.end(),
+				MakeEdge(first, second));
+		}
+
+		struct PositionOrder
+		{
+			const std::vector<float> *pPositions;
+
+			bool operator()(GLuint lhs, GLuint rhs) const
+			{
+				const float *pLhs = &(*pPositions)[lhs * 3];
+				const float *pRhs = &(*pPositions)[rhs * 3];
+				return std::lexicographical_compare(pLhs, pLhs + 3, pRhs, pRhs + 3);
+			}
+		};
+
+		//Locks every vertex whose position another vertex also has.
+		void LockSharedPositions(const std::vector<float> &positions, std::vector<bool> &locked)
+		{
+			const size_t numVertices = locked.size();
+			std::vector<GLuint> order(numVertices);
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+				order[vertex] = (GLuint)vertex;
+
+			PositionOrder compare;
+			compare.pPositions = &positions;
+			std::sort(order.begin(), order.end(), compare);
+
+			for(size_t ix = 1; ix < numVertices; ix++)
+			{
+				if(!compare(order[ix - 1], order[ix]) && !compare(order[ix], order[ix - 1]))
+					locked[order[ix - 1]] = locked[order[ix]] = true;
+			}
+		}
+
+		struct Collapse
+		{
+			GLuint from;
+			GLuint to;
+			double error;
+
+			bool operator<(const Collapse &rhs) const
+			{
+				return error < rhs.error;
+			}
+		};
+
+		class Simplifier
+		{
+		public:
+			Simplifier(const std::vector<float> &positions, const std::vector<GLuint> &triangles)
+				: m_positions(positions)
+				, m_numVertices(positions.size() / 3)
+				, m_locked(positions.size() / 3, false)
+				, m_quadrics(positions.size() / 3)
+			{
+				memset(&m_quadrics[0], 0, m_quadrics.size() * sizeof(Quadric));
+				LockSharedPositions(m_positions, m_locked);
+
+				std::vector<Edge> borderEdges;
+				GetBorderEdges(triangles, borderEdges);
+
+				for(size_t triangle = 0; triangle < triangles.size(); triangle += 3)
+				{
+					const GLuint *pCorners = &triangles[triangle];
+					double normal[3];
+					GetFaceNormal(GetPosition(pCorners[0]), GetPosition(pCorners[1]),
+						GetPosition(pCorners[2]), normal);
+					const double length = sqrt(Dot(normal, normal));
+					if(length == 0.0)
+						continue;
+
+					for(int component = 0; component < 3; component++)
+						normal[component] /= length;
+
+					const double area = length * 0.5;
+					const float *pFirst = GetPosition(pCorners[0]);
+					const double d = -(normal[0] * pFirst[0] + normal[1] * pFirst[1] +
+						normal[2] * pFirst[2]);
+					for(int corner = 0; corner < 3; corner++)
+						AddPlane(m_quadrics[pCorners[corner]], normal, d, area);
+
+					//A border edge also gets a plane through it, upright to the triangle,
+					//so that its vertices are held to the outline.
+					for(int corner = 0; corner < 3; corner++)
+					{
+						const GLuint first = pCorners[corner];
+						const GLuint second = pCorners[(corner + 1) % 3];
+						if(!IsBorderEdge(borderEdges, first, second))
+							continue;
+
+						double edge[3], edgeNormal[3];
+						Subtract(GetPosition(second), GetPosition(first), edge);
+						Cross(edge, normal, edgeNormal);
+						const double edgeLength = sqrt(Dot(edgeNormal, edgeNormal));
+						if(edgeLength == 0.0)
+							continue;
+
+						for(int component = 0; component < 3; component++)
+							edgeNormal[component] /= edgeLength;
+
+						const float *pOnEdge = GetPosition(first);
+						const double edgeD = -(edgeNormal[0] * pOnEdge[0] +
+							edgeNormal[1] * pOnEdge[1] + edgeNormal[2] * pOnEdge[2]);
+						const double weight = edgeLength * edgeLength * BORDER_WEIGHT;
+						AddPlane(m_quadrics[first], edgeNormal, edgeD, weight);
+						AddPlane(m_quadrics[second], edgeNormal, edgeD, weight);
+					}
+				}
+			}
+
+			//Collapses edges until the list has no more than targetTriangles, or nothing
+			//more can go. Returns the largest error of the collapses made.
+			double Simplify(std::vector<GLuint> &triangles, size_t targetTriangles)
+			{
+				double maxError = 0.0;
+				while(triangles.size() / 3 > targetTriangles)
+				{
+					size_t numRemoved = 0;
+					const double passError = CollapsePass(triangles,
+						triangles.size() / 3 - targetTriangles, numRemoved);
+					if(!numRemoved)
+						break;
+
+					maxError = std::max(maxError, passError);
+				}
+
+				return maxError;
+			}
+
+		private:
+			const std::vector<float> &m_positions;
+			size_t m_numVertices;
+			std::vector<bool> m_locked;
+			std::vector<Quadric> m_quadrics;
+
+			//Each vertex's triangles, as one array sliced by m_firstTriangle.
+			std::vector<size_t> m_firstTriangle;
+			std::vector<GLuint> m_vertexTriangles;
+
+			const float *GetPosition(GLuint vertex) const
+			{
+				return &m_positions[vertex * 3];
+			}
+
+			void BuildAdjacency(const std::vector<GLuint> &triangles)
+			{
+				m_firstTriangle.assign(m_numVertices + 1, 0);
+				for(size_t ix = 0; ix < triangles.size(); ix++)
+					m_firstTriangle[triangles[ix] + 1]++;
+				for(size_t vertex = 0; vertex < m_numVertices; vertex++)
+					m_firstTriangle[vertex + 1] += m_firstTriangle[vertex];
+
+				m_vertexTriangles.resize(triangles.size());
+				std::vector<size_t> fill(m_firstTriangle.begin(), m_firstTriangle.end() - 1);
+				for(size_t ix = 0; ix < triangles.size(); ix++)
+					m_vertexTriangles[fill[triangles[ix]]++] = (GLuint)(ix / 3);
+			}
+
+			bool IsAllowed(GLuint from, GLuint to, const std::vector<bool> &border,
+				const std::vector<Edge> &borderEdges) const
+			{
+				if(m_locked[from])
+					return false;
+
+				//A border vertex may only slide along the border, or it would take a bite
+				//out of the outline.
+				return !border[from] || (border[to] && IsBorderEdge(borderEdges, from, to));
+			}
+
+			//True if moving from onto to would turn one of from's remaining triangles too far,
+			//or flatten it.
+			bool Flips(const std::vector<GLuint> &triangles, GLuint from, GLuint to) const
+			{
+				for(size_t slot = m_firstTriangle[from]; slot < m_firstTriangle[from + 1]; slot++)
+				{
+					const GLuint *pCorners = &triangles[m_vertexTriangles[slot] * 3];
+					if(pCorners[0] == to || pCorners[1] == to || pCorners[2] == to)
+						continue;
+
+					const float *pOld[3];
+					const float *pNew[3];
+					for(int corner = 0; corner < 3; corner++)
+					{
+						pOld[corner] = GetPosition(pCorners[corner]);
+						pNew[corner] = GetPosition(pCorners[corner] == from ? to : pCorners[corner]);
+					}
+
+					double oldNormal[3], newNormal[3];
+					GetFaceNormal(pOld[0], pOld[1], pOld[2], oldNormal);
+					GetFaceNormal(pNew[0], pNew[1], pNew[2], newNormal);
+					if(Dot(oldNormal, newNormal) <=
+						MIN_FLIP_COS * sqrt(Dot(oldNormal, oldNormal) * Dot(newNormal, newNormal)))
+					{
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			//One round of collapses, cheapest first. A collapse moves the triangles around its
+			//from vertex, so no other collapse in the round may touch them.
+			double CollapsePass(std::vector<GLuint> &triangles, size_t maxRemoved,
+				size_t &numRemoved)
+			{
+				BuildAdjacency(triangles);
+
+				std::vector<Edge> borderEdges;
+				GetBorderEdges(triangles, borderEdges);
+				std::vector<bool> border(m_numVertices, false);
+				for(size_t edge = 0; edge < borderEdges.size(); edge++)
+					border[borderEdges[edge].first] = border[borderEdges[edge].second] = true;
+
+				std::vector<Collapse> collapses;
+				collapses.reserve(triangles.size() * 2);
+				for(size_t ix = 0; ix < triangles.size(); ix++)
+				{
+					const GLuint first = triangles[ix];
+					const GLuint second = triangles[ix - ix % 3 + (ix + 1) % 3];
+					for(int direction = 0; direction < 2; direction++)
+					{
+						Collapse collapse;
+						collapse.from = direction ? second : first;
+						collapse.to = direction ? first : second;
+						if(!IsAllowed(collapse.from, collapse.to, border, borderEdges))
+							continue;
+
+						Quadric merged = m_quadrics[collapse.from];
+						AddQuadric(merged, m_quadrics[collapse.to]);
+						const double cost = EvalQuadric(merged, GetPosition(collapse.to));
+						collapse.error = merged.weight > 0.0 ?
+							sqrt(std::max(cost, 0.0) / merged.weight) : 0.0;
+						collapses.push_back(collapse);
+					}
+				}
+				std::sort(collapses.begin(), collapses.end());
+
+				std::vector<GLuint> remap(m_numVertices);
+				for(size_t vertex = 0; vertex < m_numVertices; vertex++)
+					remap[vertex] = (GLuint)vertex;
+
+				std::vector<bool> touched(m_numVertices, false);
+				double maxError = 0.0;
+				numRemoved = 0;
+				for(size_t ix = 0; ix < collapses.size() && numRemoved < maxRemoved; ix++)
+				{
+					const Collapse &collapse = collapses[ix];
+					if(touched[collapse.from] || touched[collapse.to] ||
+						Flips(triangles, collapse.from, collapse.to))
+					{
+						continue;
+					}
+
+					for(size_t slot = m_firstTriangle[collapse.from];
+						slot < m_firstTriangle[collapse.from + 1]; slot++)
+					{
+						const GLuint *pCorners = &triangles[m_vertexTriangles[slot] * 3];
+						for(int corner = 0; corner < 3; corner++)
+							touched[pCorners[corner]] = true;
+						if(pCorners[0] == collapse.to || pCorners[1] == collapse.to ||
+							pCorners[2] == collapse.to)
+						{
+							numRemoved++;
+						}
+					}
+
+					remap[collapse.from] = collapse.to;
+					AddQuadric(m_quadrics[collapse.to], m_quadrics[collapse.from]);
+					maxError = std::max(maxError, collapse.error);
+				}
+
+				size_t out = 0;
+				for(size_t triangle = 0; triangle < triangles.size(); triangle += 3)
+				{
+					const GLuint a = remap[triangles[triangle]];
+					const GLuint b = remap[triangles[triangle + 1]];
+					const GLuint c = remap[triangles[triangle + 2]];
+					if(a == b || b == c || a == c)
+						continue;
+
+					triangles[out++] = a;
+					triangles[out++] = b;
+					triangles[out++] = c;
+				}
+				triangles.resize(out);
+
+				return maxError;
+			}
+		};
+
+		void SetBounds(MeshData &mesh, const std::vector<float> &positions)
+		{
+			const size_t numVertices = positions.size() / 3;
+			if(!numVertices)
+				return;
+
+			float minValue[3], maxValue[3];
+			for(int component = 0; component < 3; component++)
+			{
+				minValue[component] = maxValue[component] = positions[component];
+				for(size_t vertex = 1; vertex < numVertices; vertex++)
+				{
+					minValue[component] = std::min(minValue[component], positions[vertex * 3 + component]);
+					maxValue[component] = std::max(maxValue[component], positions[vertex * 3 + component]);
+				}
+				mesh.boundsCenter[component] = (minValue[component] + maxValue[component]) * 0.5f;
+			}
+
+			double radiusSqr = 0.0;
+			for(size_t vertex = 0; vertex < numVertices; vertex++)
+			{
+				double offset[3];
+				Subtract(&positions[vertex * 3], mesh.boundsCenter, offset);
+				radiusSqr = std::max(radiusSqr, Dot(offset, offset));
+			}
+			mesh.boundsRadius = (float)sqrt(radiusSqr);
+		}
+	}
+
+	int BuildLods( MeshData &mesh, int maxLods )
+	{
+		mesh.lods.clear();
+		mesh.bLodsBuilt = true;
+
+		std::vector<float> positions;
+		if(!GetPositions(mesh, positions))
+			return 0;
+
+		SetBounds(mesh, positions);
+
+		std::vector<GLuint> triangles;
+		GetTriangles(mesh, triangles);
+		if(!HasOnlyTriangles(mesh) || triangles.empty() ||
+			positions.size() / 3 != GetNumVertices(mesh))
+		{
+			return 0;
+		}
+
+		Simplifier simplifier(positions, triangles);
+		float error = 0.0f;
+		for(int lod = 0; lod < maxLods; lod++)
+		{
+			const size_t numTriangles = triangles.size() / 3;
+			const double levelError = simplifier.Simplify(triangles, numTriangles / 2);
+			if(triangles.size() / 3 > numTriangles * MIN_LOD_REDUCTION)
+				break;
+
+			error = std::max(error, (float)levelError);
+
+			MeshLod level;
+			level.indexType = GetWidestIndexType(mesh);
+			level.error = error;
+			mesh.lods.push_back(level);
+			mesh.lods.back().indices = triangles;
+		}
+
+		return (int)mesh.lods.size();
+	}
+}
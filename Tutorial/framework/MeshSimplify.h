@@ -0,0 +1,33 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_MESH_SIMPLIFY_H
+#define FRAMEWORK_MESH_SIMPLIFY_H
+
+#include "MeshData.h"
+
+namespace Framework
+{
+	enum
+	{
+		DEFAULT_MAX_LODS = 4,
+	};
+
+	//Builds up to maxLods levels of detail into mesh.lods, each with about half the triangles
+	//of the one before. Edges are collapsed onto one of their ends, cheapest first, where the
+	//cost is how far that end lies from the planes of the triangles merged into it (quadric
+	//error metrics, Garland and Heckbert 1997). The levels only drop vertices, so they draw
+	//with the mesh's own vertex data.
+	//
+	//Vertices that share their position with another, as along a seam in the normals or
+	//texture coordinates, never move, so the levels don't crack there. Border vertices only
+	//move along the border. Each level's error is the largest root mean square distance, over
+	//all collapses so far, of a vertex from the planes it stands for.
+	//
+	//No levels are built for a mesh with <arrays>, primitives other than triangles, strips and
+	//fans, a primitive restart index, or positions (attribute 0) that are not floats. The
+	//bounds are set whenever there are float positions. Returns the number of levels built.
+	int BuildLods(MeshData &mesh, int maxLods = DEFAULT_MAX_LODS);
+}
+
+#endif //FRAMEWORK_MESH_SIMPLIFY_H
@@ -0,0 +1,1019 @@
+//This file is licensed under the MIT License.
+
+
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "FloatParse.h"
+#include "MeshData.h"
+
+//Big <attribute> and <indices> bodies are converted on several threads where the standard
+//library has a working std::thread. MinGW's win32 thread model has C++11 but no <thread>,
+//so the library's own threads macro is checked, not just the language version. Elsewhere
+//they are converted a piece at a time on the loading thread. GCC and Clang builds need
+//-pthread on the link line for the threads to start.
+#if defined(_MSC_VER)
+#if _MSC_VER >= 1700
+#define FRAMEWORK_PARSE_THREADS
+#endif
+#elif __cplusplus >= 201103L
+#if defined(_GLIBCXX_HAS_GTHREADS) || \
+	(defined(_LIBCPP_VERSION) && !defined(_LIBCPP_HAS_NO_THREADS))
+#define FRAMEWORK_PARSE_THREADS
+#endif
+#endif
+
+#ifdef FRAMEWORK_PARSE_THREADS
+#include <thread>
+#endif
+
+namespace Framework
+{
+	namespace
+	{
+		struct AttribTypeInfo
+		{
+			const char *strName;
+			GLenum type;
+			bool bNormalized;
+		};
+
+		const AttribTypeInfo g_attribTypes[] =
+		{
+			{"float",		GL_FLOAT,			false},
+			{"half",		GL_HALF_FLOAT,		false},
+			{"int",			GL_INT,				false},
+			{"uint",		GL_UNSIGNED_INT,	false},
+			{"norm-int",	GL_INT,				true},
+			{"norm-uint",	GL_UNSIGNED_INT,	true},
+			{"short",		GL_SHORT,			false},
+			{"ushort",		GL_UNSIGNED_SHORT,	false},
+			{"norm-short",	GL_SHORT,			true},
+			{"norm-ushort",	GL_UNSIGNED_SHORT,	true},
+			{"byte",		GL_BYTE,			false},
+			{"ubyte",		GL_UNSIGNED_BYTE,	false},
+			{"norm-byte",	GL_BYTE,			true},
+			{"norm-ubyte",	GL_UNSIGNED_BYTE,	true},
+		};
+
+		struct NamedEnum
+		{
+			const char *strName;
+			GLenum value;
+		};
+
+		const NamedEnum g_primTypes[] =
+		{
+			{"triangles",	GL_TRIANGLES},
+			{"tri-strip",	GL_TRIANGLE_STRIP},
+			{"tri-fan",		GL_TRIANGLE_FAN},
+			{"lines",		GL_LINES},
+			{"line-strip",	GL_LINE_STRIP},
+			{"line-loop",	GL_LINE_LOOP},
+			{"points",		GL_POINTS},
+		};
+
+		const NamedEnum g_indexTypes[] =
+		{
+			{"uint",	GL_UNSIGNED_INT},
+			{"ushort",	GL_UNSIGNED_SHORT},
+			{"ubyte",	GL_UNSIGNED_BYTE},
+		};
+
+		//A start, end or empty-element tag, with its attributes.
+		struct XmlTag
+		{
+			std::string name;
+			std::vector<std::pair<std::string, std::string> > attribs;
+			bool bEndTag;
+			bool bEmptyElement;
+
+			const std::string *Find(const char *strAttrib) const
+			{
+				for(size_t attrib = 0; attrib < attribs.size(); attrib++)
+				{
+					if(attribs[attrib].first == strAttrib)
+						return &attribs[attrib].second;
+				}
+
+				return NULL;
+			}
+
+			const std::string &Get(const char *strAttrib) const
+			{
+				const std::string *pValue = Find(strAttrib);
+				if(!pValue)
+				{
+					throw std::runtime_error("The <" + name + "> element is missing the \"" +
+						strAttrib + "\" attribute.");
+				}
+
+				return *pValue;
+			}
+		};
+
+		//Walks the tags of a document. The mesh format has no mixed content worth keeping, so
+		//the text between two tags is only handed back as a range, for the caller to parse.
+		class XmlScanner
+		{
+		public:
+			XmlScanner(const char *pBegin, const char *pEnd)
+				: m_pCurr(pBegin)
+				, m_pEnd(pEnd)
+			{}
+
+			//Returns false at the end of the document. pTextBegin/pTextEnd get the text
+			//between the previous tag and this one.
+			bool NextTag(XmlTag &tag, const char *&pTextBegin, const char *&pTextEnd)
+			{
+				for(;;)
+				{
+					pTextBegin = m_pCurr;
+					while(m_pCurr != m_pEnd && *m_pCurr != '<')
+						++m_pCurr;
+					pTextEnd = m_pCurr;
+
+					if(m_pCurr == m_pEnd)
+						return false;
+
+					if(StartsWith("<?"))
+						SkipPast("?>");
+					else if(StartsWith("<!--"))
+						SkipPast("-->");
+					else if(StartsWith("<!"))
+						SkipPast(">");
+					else
+						break;
+				}
+
+				++m_pCurr;
+				tag.attribs.clear();
+				tag.bEndTag = false;
+				tag.bEmptyElement = false;
+
+				if(m_pCurr != m_pEnd && *m_pCurr == '/')
+				{
+					tag.bEndTag = true;
+					++m_pCurr;
+				}
+
+				tag.name = ReadName();
+				if(tag.name.empty())
+					throw std::runtime_error("Malformed XML tag.");
+
+				for(;;)
+				{
+					SkipSpace();
+					if(m_pCurr == m_pEnd)
+						throw std::runtime_error("Unterminated XML tag <" + tag.name + ">.");
+
+					if(*m_pCurr == '>')
+					{
+						++m_pCurr;
+						return true;
+					}
+
+					if(*m_pCurr == '/')
+					{
+						tag.bEmptyElement = true;
+						++m_pCurr;
+						continue;
+					}
+
+					std::string attribName = ReadName();
+					SkipSpace();
+					if(attribName.empty() || m_pCurr == m_pEnd || *m_pCurr != '=')
+						throw std::runtime_error("Malformed attribute in the XML tag <" + tag.name + ">.");
+					++m_pCurr;
+					SkipSpace();
+
+					if(m_pCurr == m_pEnd || (*m_pCurr != '"' && *m_pCurr != '\''))
+						throw std::runtime_error("Unquoted attribute in the XML tag <" + tag.name + ">.");
+					const char quote = *m_pCurr++;
+					const char *pValueBegin = m_pCurr;
+					while(m_pCurr != m_pEnd && *m_pCurr != quote)
+						++m_pCurr;
+					if(m_pCurr == m_pEnd)
+						throw std::runtime_error("Unterminated attribute in the XML tag <" + tag.name + ">.");
+
+					tag.attribs.push_back(std::make_pair(attribName, std::string(pValueBegin, m_pCurr)));
+					++m_pCurr;
+				}
+			}
+
+		private:
+			const char *m_pCurr;
+			const char *m_pEnd;
+
+			bool StartsWith(const char *strPrefix) const
+			{
+				const size_t length = strlen(strPrefix);
+				return (size_t)(m_pEnd - m_pCurr) >= length && memcmp(m_pCurr, strPrefix, length) == 0;
+			}
+
+			void SkipPast(const char *strTerminator)
+			{
+				const size_t length = strlen(strTerminator);
+				while((size_t)(m_pEnd - m_pCurr) >= length)
+				{
+					if(memcmp(m_pCurr, strTerminator, length) == 0)
+					{
+						m_pCurr += length;
+						return;
+					}
+					++m_pCurr;
+				}
+
+				throw std::runtime_error("Unterminated XML declaration or comment.");
+			}
+
+			void SkipSpace()
+			{
+				while(m_pCurr != m_pEnd && isspace((unsigned char)*m_pCurr))
+					++m_pCurr;
+			}
+
+			std::string ReadName()
+			{
+				const char *pBegin = m_pCurr;
+				while(m_pCurr != m_pEnd && (isalnum((unsigned char)*m_pCurr) ||
+					*m_pCurr == '-' || *m_pCurr == '_' || *m_pCurr == ':' || *m_pCurr == '.'))
+				{
+					++m_pCurr;
+				}
+
+				return std::string(pBegin, m_pCurr);
+			}
+		};
+
+		GLenum FindEnum(const NamedEnum *pTable, size_t tableSize, const std::string &strName,
+			const char *strWhat)
+		{
+			for(size_t entry = 0; entry < tableSize; entry++)
+			{
+				if(strName == pTable[entry].strName)
+					return pTable[entry].value;
+			}
+
+			throw std::runtime_error("Unknown " + std::string(strWhat) + " \"" + strName + "\".");
+		}
+
+		unsigned long ParseUnsigned(const std::string &strValue, const char *strWhat)
+		{
+			char *pEnd = NULL;
+			errno = 0;
+			unsigned long value = strtoul(strValue.c_str(), &pEnd, 10);
+			if(strValue.empty() || *pEnd != '\0' || errno != 0 || strValue[0] == '-')
+				throw std::runtime_error("Bad " + std::string(strWhat) + " \"" + strValue + "\".");
+
+			return value;
+		}
+
+		bool ParseBool(const std::string &strValue)
+		{
+			return strValue == "true";
+		}
+
+		//The nearest half. Values too big for a half become infinity.
+		GLushort FloatToHalf(float value)
+		{
+			GLuint bits;
+			memcpy(&bits, &value, sizeof(bits));
+
+			const GLushort sign = (GLushort)((bits >> 16) & 0x8000);
+			const int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+			GLuint mantissa = bits & 0x7FFFFF;
+
+			if(((bits >> 23) & 0xFF) == 0xFF)
+				return (GLushort)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+			if(exponent >= 31)
+				return (GLushort)(sign | 0x7C00);
+			if(exponent <= 0)
+			{
+				if(exponent < -10)
+					return sign;
+
+				mantissa |= 0x800000;
+				const int shift = 14 - exponent;
+				GLuint half = mantissa >> shift;
+				if((mantissa >> (shift - 1)) & 1)
+					++half;
+				return (GLushort)(sign | half);
+			}
+
+			GLuint half = ((GLuint)exponent << 10) | (mantissa >> 13);
+			if(mantissa & 0x1000)
+				++half;
+			return (GLushort)(sign | half);
+		}
+
+		float HalfToFloat(GLushort half)
+		{
+			const GLuint sign = (GLuint)(half & 0x8000) << 16;
+			const int exponent = (half >> 10) & 0x1F;
+			GLuint mantissa = half & 0x3FF;
+
+			GLuint bits;
+			if(exponent == 0x1F)
+				bits = sign | 0x7F800000 | (mantissa << 13);
+			else if(exponent != 0)
+				bits = sign | ((GLuint)(exponent - 15 + 127) << 23) | (mantissa << 13);
+			else if(mantissa == 0)
+				bits = sign;
+			else
+			{
+				//Denormal: shift the mantissa up until its leading bit is the implicit one.
+				int shift = 0;
+				while(!(mantissa & 0x400))
+				{
+					mantissa <<= 1;
+					shift++;
+				}
+				bits = sign | ((GLuint)(1 - 15 + 127 - shift) << 23) | ((mantissa & 0x3FF) << 13);
+			}
+
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		template<typename T>
+		void AppendValue(std::vector<char> &data, T value)
+		{
+			const size_t offset = data.size();
+			data.resize(offset + sizeof(T));
+			memcpy(&data[offset], &value, sizeof(T));
+		}
+
+		//Converts the whitespace-separated numbers in [pBegin, pEnd) to attrib's type and
+		//appends them to data. The text must be followed by whitespace or a non-numeric
+		//character (the next tag's '<' always is), so ParseFloat, strtol and strtoul stop at
+		//pEnd on their own.
+		void ParseAttributeChunk(const char *pBegin, const char *pEnd, const MeshAttribute &attrib,
+			std::vector<char> &data)
+		{
+			const char *pCurr = pBegin;
+			for(;;)
+			{
+				while(pCurr != pEnd && isspace((unsigned char)*pCurr))
+					++pCurr;
+				if(pCurr == pEnd)
+					return;
+
+				const char *pNumberEnd = NULL;
+				errno = 0;
+				bool bInRange = true;
+				switch(attrib.type)
+				{
+				case GL_FLOAT:
+				case GL_HALF_FLOAT:
+					{
+						float value = 0.0f;
+						pNumberEnd = ParseFloat(pCurr, value);
+						if(attrib.type == GL_FLOAT)
+							AppendValue(data, value);
+						else
+							AppendValue(data, FloatToHalf(value));
+					}
+					break;
+				case GL_INT:
+				case GL_SHORT:
+				case GL_BYTE:
+					{
+						char *pIntegerEnd = NULL;
+						long value = strtol(pCurr, &pIntegerEnd, 10);
+						pNumberEnd = pIntegerEnd;
+						if(attrib.type == GL_INT)
+						{
+							bInRange = value >= -2147483647L - 1 && value <= 2147483647L;
+							AppendValue(data, (GLint)value);
+						}
+						else if(attrib.type == GL_SHORT)
+						{
+							bInRange = value >= -32768 && value <= 32767;
+							AppendValue(data, (GLshort)value);
+						}
+						else
+						{
+							bInRange = value >= -128 && value <= 127;
+							AppendValue(data, (GLbyte)value);
+						}
+					}
+					break;
+				default:
+					{
+						bInRange = *pCurr != '-';
+						char *pIntegerEnd = NULL;
+						unsigned long value = strtoul(pCurr, &pIntegerEnd, 10);
+						pNumberEnd = pIntegerEnd;
+						if(attrib.type == GL_UNSIGNED_INT)
+						{
+							bInRange = bInRange && value <= 0xFFFFFFFFUL;
+							AppendValue(data, (GLuint)value);
+						}
+						else if(attrib.type == GL_UNSIGNED_SHORT)
+						{
+							bInRange = bInRange && value <= 0xFFFF;
+							AppendValue(data, (GLushort)value);
+						}
+						else
+						{
+							bInRange = bInRange && value <= 0xFF;
+							AppendValue(data, (GLubyte)value);
+						}
+					}
+					break;
+				}
+
+				if(!pNumberEnd || pNumberEnd == pCurr || pNumberEnd > pEnd)
+					throw std::runtime_error("An <attribute> holds something that is not a number.");
+				if(!bInRange || errno == ERANGE)
+					throw std::runtime_error("An <attribute> value is out of range for its type.");
+
+				pCurr = pNumberEnd;
+			}
+		}
+
+		void ParseIndexChunk(const char *pBegin, const char *pEnd, const MeshPrimitive &,
+			std::vector<GLuint> &indices)
+		{
+			const char *pCurr = pBegin;
+			for(;;)
+			{
+				while(pCurr != pEnd && isspace((unsigned char)*pCurr))
+					++pCurr;
+				if(pCurr == pEnd)
+					return;
+
+				char *pNumberEnd = NULL;
+				errno = 0;
+				unsigned long value = strtoul(pCurr, &pNumberEnd, 10);
+				if(pNumberEnd == pCurr || pNumberEnd > pEnd || *pCurr == '-')
+					throw std::runtime_error("An <indices> element holds something that is not an index.");
+				if(errno == ERANGE || value > 0xFFFFFFFFUL)
+					throw std::runtime_error("An index is out of range.");
+
+				indices.push_back((GLuint)value);
+				pCurr = pNumberEnd;
+			}
+		}
+
+		//The least text worth a thread of its own. For less, starting the thread costs more
+		//than it saves.
+		const size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+		//Splits [pBegin, pEnd) into at most maxChunks pieces of about the same size. Every
+		//split is made on whitespace, so no number is cut in two, and each piece is followed
+		//by a character the conversions stop at. bounds gets the start of each piece, then pEnd.
+		void SplitOnWhitespace(const char *pBegin, const char *pEnd, size_t maxChunks,
+			std::vector<const char *> &bounds)
+		{
+			const size_t chunkSize = (pEnd - pBegin) / maxChunks;
+
+			bounds.clear();
+			bounds.push_back(pBegin);
+			for(size_t chunk = 1; chunk < maxChunks; chunk++)
+			{
+				const char *pSplit = pBegin + chunk * chunkSize;
+				if(pSplit < bounds.back())
+					pSplit = bounds.back();
+				while(pSplit != pEnd && !isspace((unsigned char)*pSplit))
+					++pSplit;
+				if(pSplit == pEnd)
+					break;
+
+				bounds.push_back(pSplit);
+			}
+			bounds.push_back(pEnd);
+		}
+
+		size_t GetNumParseThreads()
+		{
+#ifdef FRAMEWORK_PARSE_THREADS
+			const size_t numThreads = std::thread::hardware_concurrency();
+			return numThreads ? numThreads : 1;
+#else
+			return 1;
+#endif
+		}
+
+		//One piece of the text and what it converts to. Errors are kept as text, to be
+		//thrown again on the thread that asked for the conversion.
+		template<typename Owner, typename Value>
+		struct ParseChunk
+		{
+			const char *pBegin;
+			const char *pEnd;
+			const Owner *pOwner;
+			void (*Parse)(const char *, const char *, const Owner &, std::vector<Value> &);
+
+			std::vector<Value> values;
+			std::string strError;
+		};
+
+		template<typename Owner, typename Value>
+		void RunParseChunk(ParseChunk<Owner, Value> *pChunk)
+		{
+			try
+			{
+				pChunk->Parse(pChunk->pBegin, pChunk->pEnd, *pChunk->pOwner, pChunk->values);
+			}
+			catch(std::exception &e)
+			{
+				pChunk->strError = e.what();
+			}
+		}
+
+		//Runs Parse over [pBegin, pEnd), appending to values. Long text is split on whitespace
+		//and the pieces are converted at the same time, one per thread, then stitched back
+		//together in order.
+		template<typename Owner, typename Value>
+		void ParseInChunks(const char *pBegin, const char *pEnd, const Owner &owner,
+			void (*Parse)(const char *, const char *, const Owner &, std::vector<Value> &),
+			std::vector<Value> &values)
+		{
+			size_t maxChunks = (pEnd - pBegin) / MIN_CHUNK_SIZE;
+			maxChunks = std::min(maxChunks, GetNumParseThreads());
+			if(maxChunks <= 1)
+			{
+				Parse(pBegin, pEnd, owner, values);
+				return;
+			}
+
+			std::vector<const char *> bounds;
+			SplitOnWhitespace(pBegin, pEnd, maxChunks, bounds);
+
+			std::vector<ParseChunk<Owner, Value> > chunks(bounds.size() - 1);
+			for(size_t chunk = 0; chunk < chunks.size(); chunk++)
+			{
+				chunks[chunk].pBegin = bounds[chunk];
+				chunks[chunk].pEnd = bounds[chunk + 1];
+				chunks[chunk].pOwner = &owner;
+				chunks[chunk].Parse = Parse;
+			}
+
+#ifdef FRAMEWORK_PARSE_THREADS
+			//This thread takes the first piece itself. If a thread can't be started, the ones
+			//that were are joined before the error goes on: a std::thread destroyed while
+			//still running ends the program.
+			std::vector<std::thread> threads;
+			threads.reserve(chunks.size() - 1);
+			try
+			{
+				for(size_t chunk = 1; chunk < chunks.size(); chunk++)
+					threads.push_back(std::thread(RunParseChunk<Owner, Value>, &chunks[chunk]));
+			}
+			catch(...)
+			{
+				for(size_t thread = 0; thread < threads.size(); thread++)
+					threads[thread].join();
+				throw;
+			}
+
+			RunParseChunk(&chunks[0]);
+			for(size_t thread = 0; thread < threads.size(); thread++)
+				threads[thread].join();
+#else
+			for(size_t chunk = 0; chunk < chunks.size(); chunk++)
+				RunParseChunk(&chunks[chunk]);
+#endif
+
+			size_t numValues = values.size();
+			for(size_t chunk = 0; chunk < chunks.size(); chunk++)
+			{
+				if(!chunks[chunk].strError.empty())
+					throw std::runtime_error(chunks[chunk].strError);
+				numValues += chunks[chunk].values.size();
+			}
+
+			values.reserve(numValues);
+			for(size_t chunk = 0; chunk < chunks.size(); chunk++)
+				values.insert(values.end(), chunks[chunk].values.begin(), chunks[chunk].values.end());
+		}
+
+		void ParseAttributeValues(const char *pBegin, const char *pEnd, MeshAttribute &attrib)
+		{
+			ParseInChunks(pBegin, pEnd, attrib, ParseAttributeChunk, attrib.data);
+		}
+
+		void ParseIndexValues(const char *pBegin, const char *pEnd, MeshPrimitive &prim)
+		{
+			ParseInChunks(pBegin, pEnd, prim, ParseIndexChunk, prim.indices);
+		}
+
+		void ReadAttributeTag(const XmlTag &tag, MeshAttribute &attrib)
+		{
+			attrib.index = (GLuint)ParseUnsigned(tag.Get("index"), "attribute index");
+			if(attrib.index >= 16)
+				throw std::runtime_error("Attribute indices must be less than 16.");
+
+			attrib.numComponents = (int)ParseUnsigned(tag.Get("size"), "attribute size");
+			if(attrib.numComponents < 1 || attrib.numComponents > 4)
+				throw std::runtime_error("Attribute sizes must be 1 through 4.");
+
+			const std::string &strType = tag.Get("type");
+			size_t typeIx = 0;
+			for(; typeIx < sizeof(g_attribTypes) / sizeof(g_attribTypes[0]); typeIx++)
+			{
+				if(strType == g_attribTypes[typeIx].strName)
+					break;
+			}
+			if(typeIx == sizeof(g_attribTypes) / sizeof(g_attribTypes[0]))
+				throw std::runtime_error("Unknown attribute type \"" + strType + "\".");
+
+			attrib.type = g_attribTypes[typeIx].type;
+			attrib.bNormalized = g_attribTypes[typeIx].bNormalized;
+
+			const std::string *pIntegral = tag.Find("integral");
+			attrib.bIntegral = pIntegral && ParseBool(*pIntegral);
+			if(attrib.bIntegral && (attrib.bNormalized || attrib.type == GL_FLOAT ||
+				attrib.type == GL_HALF_FLOAT))
+			{
+				throw std::runtime_error("Only unnormalized integer attributes can be integral.");
+			}
+		}
+
+		void ReadPrimitiveTag(const XmlTag &tag, MeshPrimitive &prim)
+		{
+			prim.primType = FindEnum(g_primTypes, sizeof(g_primTypes) / sizeof(g_primTypes[0]),
+				tag.Get("cmd"), "primitive command");
+			prim.indexType = 0;
+			prim.start = 0;
+			prim.count = 0;
+			prim.bPrimRestart = false;
+			prim.primRestart = 0;
+
+			if(tag.name == "arrays")
+			{
+				prim.start = (GLuint)ParseUnsigned(tag.Get("start"), "arrays start");
+				prim.count = (GLuint)ParseUnsigned(tag.Get("count"), "arrays count");
+				if(prim.count == 0)
+					throw std::runtime_error("An <arrays> element must draw something.");
+				return;
+			}
+
+			prim.indexType = FindEnum(g_indexTypes, sizeof(g_indexTypes) / sizeof(g_indexTypes[0]),
+				tag.Get("type"), "index type");
+
+			const std::string *pRestart = tag.Find("prim-restart");
+			if(pRestart)
+			{
+				prim.bPrimRestart = true;
+				prim.primRestart = (GLuint)ParseUnsigned(*pRestart, "primitive restart index");
+			}
+		}
+
+		//Reads the element's text up to its end tag.
+		void ReadElementText(XmlScanner &scanner, const XmlTag &startTag,
+			const char *&pTextBegin, const char *&pTextEnd)
+		{
+			XmlTag endTag;
+			if(startTag.bEmptyElement)
+			{
+				pTextBegin = pTextEnd = NULL;
+				return;
+			}
+
+			if(!scanner.NextTag(endTag, pTextBegin, pTextEnd) || !endTag.bEndTag ||
+				endTag.name != startTag.name)
+			{
+				throw std::runtime_error("The <" + startTag.name + "> element must only hold numbers.");
+			}
+		}
+
+		void CheckMesh(const MeshData &mesh)
+		{
+			if(mesh.attribs.empty())
+				throw std::runtime_error("The mesh has no attributes.");
+
+			const size_t numVertices = mesh.attribs[0].GetNumVertices();
+			for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+			{
+				const MeshAttribute &curr = mesh.attribs[attrib];
+				if(curr.data.size() % curr.GetVertexSize() != 0)
+					throw std::runtime_error("An attribute's value count is not a multiple of its size.");
+				if(curr.GetNumVertices() != numVertices)
+					throw std::runtime_error("The attributes do not all have the same number of vertices.");
+
+				for(size_t other = 0; other < attrib; other++)
+				{
+					if(mesh.attribs[other].index == curr.index)
+						throw std::runtime_error("Two attributes use the same index.");
+				}
+			}
+
+			if(mesh.primitives.empty())
+				throw std::runtime_error("The mesh has no <indices> or <arrays> elements.");
+
+			for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+			{
+				const MeshPrimitive &curr = mesh.primitives[prim];
+				if(!curr.indexType)
+				{
+					if((size_t)curr.start + curr.count > numVertices)
+						throw std::runtime_error("An <arrays> element runs past the last vertex.");
+					continue;
+				}
+
+				if(curr.indices.empty())
+					throw std::runtime_error("An <indices> element is empty.");
+
+				for(size_t ix = 0; ix < curr.indices.size(); ix++)
+				{
+					const GLuint index = curr.indices[ix];
+					if(index >= numVertices && !(curr.bPrimRestart && index == curr.primRestart))
+						throw std::runtime_error("An index refers to a vertex that does not exist.");
+				}
+			}
+
+			for(size_t vao = 0; vao < mesh.vaos.size(); vao++)
+			{
+				for(size_t source = 0; source < mesh.vaos[vao].attribs.size(); source++)
+				{
+					if(!mesh.FindAttribute(mesh.vaos[vao].attribs[source]))
+					{
+						throw std::runtime_error("The VAO \"" + mesh.vaos[vao].name +
+							"\" sources an attribute the mesh does not have.");
+					}
+				}
+			}
+		}
+	}
+
+	void LoadMeshXml( const std::string &strFilename, MeshData &mesh )
+	{
+		FILE *pFile = fopen(strFilename.c_str(), "rb");
+		if(!pFile)
+			throw std::runtime_error("Could not open the mesh file " + strFilename + ".");
+
+		//One extra byte, so the numeric conversions always find a terminator.
+		std::vector<char> text;
+		char buffer[65536];
+		size_t bytesRead;
+		while((bytesRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+			text.insert(text.end(), buffer, buffer + bytesRead);
+		const bool bReadError = ferror(pFile) != 0;
+		fclose(pFile);
+		if(bReadError)
+			throw std::runtime_error("Could not read the mesh file " + strFilename + ".");
+		text.push_back('\0');
+
+		mesh = MeshData();
+		try
+		{
+			XmlScanner scanner(&text[0], &text[0] + text.size() - 1);
+			XmlTag tag;
+			const char *pTextBegin;
+			const char *pTextEnd;
+
+			if(!scanner.NextTag(tag, pTextBegin, pTextEnd) || tag.name != "mesh" || tag.bEndTag)
+				throw std::runtime_error("The root element must be <mesh>.");
+
+			MeshVaoSet *pCurrVao = NULL;
+			while(scanner.NextTag(tag, pTextBegin, pTextEnd))
+			{
+				if(tag.bEndTag)
+				{
+					if(tag.name == "vao")
+						pCurrVao = NULL;
+					else if(tag.name == "mesh")
+						break;
+					continue;
+				}
+
+				if(tag.name == "attribute")
+				{
+					mesh.attribs.push_back(MeshAttribute());
+					MeshAttribute &attrib = mesh.attribs.back();
+					ReadAttributeTag(tag, attrib);
+					ReadElementText(scanner, tag, pTextBegin, pTextEnd);
+					if(pTextBegin)
+						ParseAttributeValues(pTextBegin, pTextEnd, attrib);
+					if(attrib.data.empty())
+						throw std::runtime_error("An <attribute> element is empty.");
+				}
+				else if(tag.name == "indices" || tag.name == "arrays")
+				{
+					mesh.primitives.push_back(MeshPrimitive());
+					MeshPrimitive &prim = mesh.primitives.back();
+					ReadPrimitiveTag(tag, prim);
+					if(tag.name == "indices")
+					{
+						ReadElementText(scanner, tag, pTextBegin, pTextEnd);
+						if(pTextBegin)
+							ParseIndexValues(pTextBegin, pTextEnd, prim);
+						prim.count = (GLuint)prim.indices.size();
+					}
+				}
+				else if(tag.name == "vao")
+				{
+					mesh.vaos.push_back(MeshVaoSet());
+					mesh.vaos.back().name = tag.Get("name");
+					pCurrVao = tag.bEmptyElement ? NULL : &mesh.vaos.back();
+				}
+				else if(tag.name == "source")
+				{
+					if(!pCurrVao)
+						throw std::runtime_error("A <source> element must be inside a <vao>.");
+					pCurrVao->attribs.push_back((GLuint)ParseUnsigned(tag.Get("attrib"), "source attribute"));
+				}
+				else
+				{
+					throw std::runtime_error("Unknown mesh element <" + tag.name + ">.");
+				}
+			}
+
+			CheckMesh(mesh);
+		}
+		catch(std::runtime_error &e)
+		{
+			throw std::runtime_error(strFilename + ": " + e.what());
+		}
+	}
+
+	namespace
+	{
+		//The shortest text that reads back as the same float.
+		void AppendFloat(std::string &text, float value)
+		{
+			char buffer[32];
+			for(int precision = 6; precision <= 9; precision++)
+			{
+				sprintf(buffer, "%.*g", precision, value);
+				if((float)strtod(buffer, NULL) == value)
+					break;
+			}
+
+			text += buffer;
+		}
+
+		template<typename T>
+		T ReadValue(const std::vector<char> &data, size_t valueIx)
+		{
+			T value;
+			memcpy(&value, &data[valueIx * sizeof(T)], sizeof(T));
+			return value;
+		}
+
+		void AppendAttributeValue(std::string &text, const MeshAttribute &attrib, size_t valueIx)
+		{
+			char buffer[32];
+			switch(attrib.type)
+			{
+			case GL_FLOAT:
+				AppendFloat(text, ReadValue<float>(attrib.data, valueIx));
+				return;
+			case GL_HALF_FLOAT:
+				AppendFloat(text, HalfToFloat(ReadValue<GLushort>(attrib.data, valueIx)));
+				return;
+			case GL_INT:
+				sprintf(buffer, "%ld", (long)ReadValue<GLint>(attrib.data, valueIx));
+				break;
+			case GL_UNSIGNED_INT:
+				sprintf(buffer, "%lu", (unsigned long)ReadValue<GLuint>(attrib.data, valueIx));
+				break;
+			case GL_SHORT:
+				sprintf(buffer, "%d", (int)ReadValue<GLshort>(attrib.data, valueIx));
+				break;
+			case GL_UNSIGNED_SHORT:
+				sprintf(buffer, "%u", (unsigned int)ReadValue<GLushort>(attrib.data, valueIx));
+				break;
+			case GL_BYTE:
+				sprintf(buffer, "%d", (int)ReadValue<GLbyte>(attrib.data, valueIx));
+				break;
+			default:
+				sprintf(buffer, "%u", (unsigned int)ReadValue<GLubyte>(attrib.data, valueIx));
+				break;
+			}
+
+			text += buffer;
+		}
+
+		const char *GetEnumName(const NamedEnum *pTable, size_t tableSize, GLenum value)
+		{
+			for(size_t entry = 0; entry < tableSize; entry++)
+			{
+				if(pTable[entry].value == value)
+					return pTable[entry].strName;
+			}
+
+			throw std::runtime_error("The mesh uses a type the mesh file format has no name for.");
+		}
+
+		const char *GetAttribTypeName(const MeshAttribute &attrib)
+		{
+			for(size_t typeIx = 0; typeIx < sizeof(g_attribTypes) / sizeof(g_attribTypes[0]); typeIx++)
+			{
+				if(g_attribTypes[typeIx].type == attrib.type &&
+					g_attribTypes[typeIx].bNormalized == attrib.bNormalized)
+				{
+					return g_attribTypes[typeIx].strName;
+				}
+			}
+
+			throw std::runtime_error("The mesh uses a type the mesh file format has no name for.");
+		}
+
+		void WriteAttribute(std::string &text, const MeshAttribute &attrib)
+		{
+			char buffer[128];
+			sprintf(buffer, "\t<attribute index=\"%u\" type=\"%s\" size=\"%d\"%s>", attrib.index,
+				GetAttribTypeName(attrib), attrib.numComponents,
+				attrib.bIntegral ? " integral=\"true\"" : "");
+			text += buffer;
+
+			const size_t numValues = attrib.GetNumVertices() * attrib.numComponents;
+			for(size_t valueIx = 0; valueIx < numValues; valueIx++)
+			{
+				text += (valueIx % attrib.numComponents) ? " " : "\n\t\t";
+				AppendAttributeValue(text, attrib, valueIx);
+			}
+			text += "</attribute>\n";
+		}
+
+		void WritePrimitive(std::string &text, const MeshPrimitive &prim)
+		{
+			const char *strCmd = GetEnumName(g_primTypes, sizeof(g_primTypes) / sizeof(g_primTypes[0]),
+				prim.primType);
+
+			char buffer[128];
+			if(!prim.indexType)
+			{
+				sprintf(buffer, "\t<arrays cmd=\"%s\" start=\"%u\" count=\"%u\"/>\n", strCmd,
+					prim.start, prim.count);
+				text += buffer;
+				return;
+			}
+
+			sprintf(buffer, "\t<indices cmd=\"%s\" type=\"%s\"", strCmd,
+				GetEnumName(g_indexTypes, sizeof(g_indexTypes) / sizeof(g_indexTypes[0]), prim.indexType));
+			text += buffer;
+			if(prim.bPrimRestart)
+			{
+				sprintf(buffer, " prim-restart=\"%u\"", prim.primRestart);
+				text += buffer;
+			}
+			text += ">";
+
+			//A triangle or a line per row, to match the files the tutorials ship with.
+			size_t perLine = 16;
+			if(prim.primType == GL_TRIANGLES)
+				perLine = 3;
+			else if(prim.primType == GL_LINES)
+				perLine = 2;
+
+			for(size_t ix = 0; ix < prim.indices.size(); ix++)
+			{
+				sprintf(buffer, "%s%u", (ix % perLine) ? " " : "\n\t\t", prim.indices[ix]);
+				text += buffer;
+			}
+			text += "</indices>\n";
+		}
+	}
+
+	void SaveMeshXml( const std::string &strFilename, const MeshData &mesh )
+	{
+		if(mesh.bQuantized)
+			throw std::runtime_error("A quantized mesh can't be written as a mesh file.");
+
+		std::string text = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			"<mesh xmlns=\"http://www.arcsynthesis.com/gltut/mesh\">\n";
+
+		for(size_t attrib = 0; attrib < mesh.attribs.size(); attrib++)
+			WriteAttribute(text, mesh.attribs[attrib]);
+
+		for(size_t vao = 0; vao < mesh.vaos.size(); vao++)
+		{
+			text += "\t<vao name=\"" + mesh.vaos[vao].name + "\">\n";
+			for(size_t source = 0; source < mesh.vaos[vao].attribs.size(); source++)
+			{
+				char buffer[64];
+				sprintf(buffer, "\t\t<source attrib=\"%u\"/>\n", mesh.vaos[vao].attribs[source]);
+				text += buffer;
+			}
+			text += "\t</vao>\n";
+		}
+
+		for(size_t prim = 0; prim < mesh.primitives.size(); prim++)
+			WritePrimitive(text, mesh.primitives[prim]);
+
+		text += "</mesh>\n";
+
+		FILE *pFile = fopen(strFilename.c_str(), "wb");
+		if(!pFile)
+			throw std::runtime_error("Could not open the file " + strFilename + " for writing.");
+
+		bool bWritten = fwrite(text.data(), 1, text.size(), pFile) == text.size();
+		bWritten = (fclose(pFile) == 0) && bWritten;
+		if(!bWritten)
+		{
+			remove(strFilename.c_str());
+			throw std::runtime_error("Could not write the file " + strFilename + ".");
+		}
+	}
+}
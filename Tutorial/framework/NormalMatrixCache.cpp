@@ -0,0 +1,40 @@
+//This file is licensed under the MIT License.
+
+
+#include "NormalMatrixCache.h"
+
+namespace Framework
+{
+	NormalMatrixCache::NormalMatrixCache( int numSlots )
+		: m_numComputed(0)
+		, m_numReused(0)
+	{
+		Entry empty;
+		empty.bValid = false;
+		m_entries.resize(numSlots, empty);
+	}
+
+	const glm::mat3 &NormalMatrixCache::Get( int slot, const glm::mat4 &modelMatrix )
+	{
+		Entry &entry = m_entries[slot];
+		glm::mat3 upper(modelMatrix);
+
+		if(entry.bValid && entry.modelMatrix == upper)
+		{
+			++m_numReused;
+			return entry.normalMatrix;
+		}
+
+		glm::vec3 cof0 = glm::cross(upper[1], upper[2]);
+		glm::vec3 cof1 = glm::cross(upper[2], upper[0]);
+		glm::vec3 cof2 = glm::cross(upper[0], upper[1]);
+		float invDet = 1.0f / glm::dot(upper[0], cof0);
+
+		entry.modelMatrix = upper;
+		entry.normalMatrix = glm::mat3(cof0 * invDet, cof1 * invDet, cof2 * invDet);
+		entry.bValid = true;
+
+		++m_numComputed;
+		return entry.normalMatrix;
+	}
+}
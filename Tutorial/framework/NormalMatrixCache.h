@@ -0,0 +1,42 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_NORMAL_MATRIX_CACHE_H
+#define FRAMEWORK_NORMAL_MATRIX_CACHE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace Framework
+{
+	//Produces normal matrices: the inverse-transpose of a model matrix's upper 3x3.
+	//That is the cofactor matrix over the determinant, and the cofactor columns are
+	//just cross products of the matrix's columns, so no general inverse is needed.
+	//Each slot remembers its last input; an object that did not move costs a compare.
+	class NormalMatrixCache
+	{
+	public:
+		explicit NormalMatrixCache(int numSlots = 1);
+
+		const glm::mat3 &Get(int slot, const glm::mat4 &modelMatrix);
+		const glm::mat3 &Get(const glm::mat4 &modelMatrix) {return Get(0, modelMatrix);}
+
+		void ResetCounts() {m_numComputed = 0; m_numReused = 0;}
+		int GetNumComputed() const {return m_numComputed;}
+		int GetNumReused() const {return m_numReused;}
+
+	private:
+		struct Entry
+		{
+			glm::mat3 modelMatrix;
+			glm::mat3 normalMatrix;
+			bool bValid;
+		};
+
+		std::vector<Entry> m_entries;
+		int m_numComputed;
+		int m_numReused;
+	};
+}
+
+#endif //FRAMEWORK_NORMAL_MATRIX_CACHE_H
@@ -0,0 +1,406 @@
+//This file is licensed under the MIT License.
+
+
+#include <stdio.h>
+#include <algorithm>
+#include <stdexcept>
+#include <sys/stat.h>
+#include "framework.h"
+#include "MappedFile.h"
+#include "MeshCluster.h"
+#include "MeshData.h"
+#include "MeshOptimize.h"
+#include "MeshQuantize.h"
+#include "MeshSimplify.h"
+#include "PackedMesh.h"
+#include "PackedMeshFormat.h"
+
+namespace Framework
+{
+	namespace
+	{
+		//True if the first file exists and was modified no earlier than the second.
+		bool IsUpToDate(const std::string &strFilename, const std::string &strSourceFilename)
+		{
+			struct stat fileStat;
+			struct stat sourceStat;
+			if(stat(strFilename.c_str(), &fileStat) != 0)
+				return false;
+			if(stat(strSourceFilename.c_str(), &sourceStat) != 0)
+				return true;
+
+			return fileStat.st_mtime >= sourceStat.st_mtime;
+		}
+
+		void SetupAttribute(const PackedMeshAttrib &attrib)
+		{
+			const void *pOffset = (const void *)(size_t)attrib.dataOffset;
+
+			glEnableVertexAttribArray(attrib.index);
+			if(attrib.flags & PACKED_ATTRIB_INTEGRAL)
+			{
+				glVertexAttribIPointer(attrib.index, attrib.numComponents, attrib.type, 0, pOffset);
+			}
+			else
+			{
+				glVertexAttribPointer(attrib.index, attrib.numComponents, attrib.type,
+					(attrib.flags & PACKED_ATTRIB_NORMALIZED) ? GL_TRUE : GL_FALSE, 0, pOffset);
+			}
+		}
+
+		//Makes a VAO with the attributes in attribMask, or all of them if it is ~0.
+		GLuint CreateVao(const PackedMeshHeader *pHeader, GLuint vertexBuffer,
+			GLuint indexBuffer, GLuint attribMask)
+		{
+			GLuint vao;
+			glGenVertexArrays(1, &vao);
+			glBindVertexArray(vao);
+
+			glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+			const PackedMeshAttrib *pAttribs = GetPackedAttribs(pHeader);
+			for(GLuint attrib = 0; attrib < pHeader->numAttribs; attrib++)
+			{
+				if(attribMask & (1 << pAttribs[attrib].index))
+					SetupAttribute(pAttribs[attrib]);
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			if(indexBuffer)
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+			glBindVertexArray(0);
+			return vao;
+		}
+	}
+
+	PackedMesh::PackedMesh( const std::string &strFilename, unsigned int options )
+		: m_vertexBuffer(0)
+		, m_indexBuffer(0)
+		, m_vao(0)
+		, m_boundsRadius(0.0f)
+	{
+		const GLuint wantedFlags =
+			((options & PACKED_MESH_QUANTIZE) ? PACKED_MESH_QUANTIZED : 0) |
+			((options & PACKED_MESH_LODS) ? PACKED_MESH_HAS_LODS : 0) |
+			((options & PACKED_MESH_CLUSTERS) ? PACKED_MESH_HAS_CLUSTERS : 0);
+
+		const std::string strXmlFilename = FindFileOrThrow(strFilename);
+		const std::string strPackedFilename = GetPackedMeshFilename(strXmlFilename);
+
+		//The up-to-date copy is uploaded straight out of its mapping: nothing is read onto
+		//the heap, and only the pages glBufferData touches are brought in.
+		if(IsUpToDate(strPackedFilename, strXmlFilename))
+		{
+			MappedFile packedFile(strPackedFilename);
+			const PackedMeshHeader *pHeader = packedFile.IsOpen() ?
+				GetPackedMeshHeader(packedFile.GetData(), packedFile.GetSize()) : NULL;
+			if(pHeader && pHeader->flags == wantedFlags)
+			{
+				CreateObjects(packedFile.GetData(), packedFile.GetSize());
+				return;
+			}
+		}
+
+		std::vector<char> image;
+		{
+			MeshData mesh;
+			LoadMeshXml(strXmlFilename, mesh);
+			if(options & PACKED_MESH_LODS)
+				BuildLods(mesh);
+			if(options & PACKED_MESH_CLUSTERS)
+				BuildClusters(mesh);
+			OptimizeVertexCache(mesh);
+			OptimizeVertexFetch(mesh);
+			if(options & PACKED_MESH_QUANTIZE)
+			{
+				std::vector<QuantizeReport> report;
+				QuantizeMesh(mesh, report);
+			}
+			PackMesh(mesh, image);
+		}
+
+		try
+		{
+			WritePackedMeshImage(strPackedFilename, image);
+		}
+		catch(std::runtime_error &e)
+		{
+			printf("%s\n", e.what());
+		}
+
+		CreateObjects(&image[0], image.size());
+	}
+
+	PackedMesh::~PackedMesh()
+	{
+		DeleteObjects();
+	}
+
+	void PackedMesh::CreateObjects( const char *pImage, size_t imageSize )
+	{
+		const PackedMeshHeader *pHeader = GetPackedMeshHeader(pImage, imageSize);
+		if(!pHeader)
+			throw std::runtime_error("The packed mesh is damaged.");
+
+		glGenBuffers(1, &m_vertexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, pHeader->vertexDataSize,
+			pImage + pHeader->vertexDataOffset, GL_STATIC_DRAW);
+
+		//A buffer is a buffer: the index data goes up through GL_ARRAY_BUFFER too, so it
+		//does not disturb whatever VAO is bound.
+		if(pHeader->indexDataSize)
+		{
+			glGenBuffers(1, &m_indexBuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+			glBufferData(GL_ARRAY_BUFFER, pHeader->indexDataSize,
+				pImage + pHeader->indexDataOffset, GL_STATIC_DRAW);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		m_positionDecode = glm::mat4(1.0f);
+		for(int component = 0; component < 3; component++)
+		{
+			m_positionDecode[component][component] = pHeader->positionScale[component];
+			m_positionDecode[3][component] = pHeader->positionOffset[component];
+		}
+
+		m_boundsCenter = glm::vec3(pHeader->boundsCenter[0], pHeader->boundsCenter[1],
+			pHeader->boundsCenter[2]);
+		m_boundsRadius = pHeader->boundsRadius;
+
+		m_vao = CreateVao(pHeader, m_vertexBuffer, m_indexBuffer, ~0U);
+
+		const PackedMeshVao *pVaos = GetPackedVaos(pHeader);
+		for(GLuint vao = 0; vao < pHeader->numVaos; vao++)
+		{
+			std::string name(pImage + pVaos[vao].nameOffset, pVaos[vao].nameLength);
+			m_namedVaos[name] = CreateVao(pHeader, m_vertexBuffer, m_indexBuffer,
+				pVaos[vao].attribMask);
+		}
+
+		const PackedMeshPrimitive *pPrims = GetPackedPrimitives(pHeader);
+		for(GLuint prim = 0; prim < pHeader->numPrimitives; prim++)
+		{
+			RenderCmd cmd;
+			cmd.primType = pPrims[prim].primType;
+			cmd.indexType = pPrims[prim].indexType;
+			cmd.start = pPrims[prim].start;
+			cmd.count = pPrims[prim].count;
+			cmd.offset = pPrims[prim].dataOffset;
+			cmd.bPrimRestart = (pPrims[prim].flags & PACKED_PRIM_RESTART) != 0;
+			cmd.primRestart = pPrims[prim].primRestart;
+			m_renderCmds.push_back(cmd);
+		}
+
+		const PackedMeshLod *pLods = GetPackedLods(pHeader);
+		for(GLuint lod = 0; lod < pHeader->numLods; lod++)
+		{
+			LodCmd cmd;
+			cmd.indexType = pLods[lod].indexType;
+			cmd.count = pLods[lod].count;
+			cmd.offset = pLods[lod].dataOffset;
+			cmd.error = pLods[lod].error;
+			m_lodCmds.push_back(cmd);
+		}
+
+		const PackedMeshCluster *pClusters = GetPackedClusters(pHeader);
+		m_clusters.resize(pHeader->numClusters);
+		for(GLuint cluster = 0; cluster < pHeader->numClusters; cluster++)
+			UnpackCluster(pClusters[cluster], m_clusters[cluster]);
+	}
+
+	void PackedMesh::DeleteObjects()
+	{
+		for(std::map<std::string, GLuint>::iterator it = m_namedVaos.begin();
+			it != m_namedVaos.end(); ++it)
+		{
+			glDeleteVertexArrays(1, &it->second);
+		}
+		m_namedVaos.clear();
+
+		if(m_vao)
+			glDeleteVertexArrays(1, &m_vao);
+		if(m_indexBuffer)
+			glDeleteBuffers(1, &m_indexBuffer);
+		if(m_vertexBuffer)
+			glDeleteBuffers(1, &m_vertexBuffer);
+
+		m_vao = 0;
+		m_indexBuffer = 0;
+		m_vertexBuffer = 0;
+		m_renderCmds.clear();
+		m_lodCmds.clear();
+		m_clusters.clear();
+	}
+
+	void PackedMesh::Render() const
+	{
+		if(!m_vao)
+			return;
+
+		glBindVertexArray(m_vao);
+		RenderCmds(0, 1);
+		glBindVertexArray(0);
+	}
+
+	void PackedMesh::Render( const std::string &strMeshName ) const
+	{
+		Render(strMeshName, 0);
+	}
+
+	void PackedMesh::Render( const std::string &strMeshName, int lod ) const
+	{
+		std::map<std::string, GLuint>::const_iterator it = m_namedVaos.find(strMeshName);
+		if(it == m_namedVaos.end())
+			return;
+
+		glBindVertexArray(it->second);
+		RenderCmds(lod, 1);
+		glBindVertexArray(0);
+	}
+
+	void PackedMesh::RenderInstanced( GLsizei numInstances ) const
+	{
+		if(!m_vao)
+			return;
+
+		glBindVertexArray(m_vao);
+		RenderCmds(0, numInstances);
+		glBindVertexArray(0);
+	}
+
+	void PackedMesh::RenderInstanced( const std::string &strMeshName, GLsizei numInstances ) const
+	{
+		std::map<std::string, GLuint>::const_iterator it = m_namedVaos.find(strMeshName);
+		if(it == m_namedVaos.end())
+			return;
+
+		glBindVertexArray(it->second);
+		RenderCmds(0, numInstances);
+		glBindVertexArray(0);
+	}
+
+	int PackedMesh::SelectLod( const glm::mat4 &modelToCamera, float projectionScale,
+		float maxPixelError ) const
+	{
+		if(m_lodCmds.empty())
+			return 0;
+
+		//Errors are in model space; the largest scale of the matrix takes them to camera
+		//space, where the nearest point of the sphere sets how many pixels they cover.
+		float scale = 0.0f;
+		for(int column = 0; column < 3; column++)
+			scale = std::max(scale, glm::length(glm::vec3(modelToCamera[column])));
+
+		const glm::vec4 center = modelToCamera * glm::vec4(m_boundsCenter, 1.0f);
+		const float distance = glm::length(glm::vec3(center)) - m_boundsRadius * scale;
+		if(distance <= 0.0f)
+			return 0;
+
+		const float pixelsPerUnit = scale * projectionScale / distance;
+		int lod = 0;
+		while(lod < (int)m_lodCmds.size() && m_lodCmds[lod].error * pixelsPerUnit <= maxPixelError)
+			lod++;
+
+		return lod;
+	}
+
+	int PackedMesh::RenderVisible( const std::string &strMeshName,
+		const glm::mat4 &modelToCamera, const glm::mat4 &cameraToClip, GLenum frontFace ) const
+	{
+		if(m_clusters.empty())
+		{
+			Render(strMeshName);
+			return 0;
+		}
+
+		std::map<std::string, GLuint>::const_iterator it = m_namedVaos.find(strMeshName);
+		if(it == m_namedVaos.end())
+			return 0;
+
+		//The frustum's planes in model space are sums and differences of the rows of the
+		//model-to-clip matrix: -w <= x, y, z <= w.
+		ClusterView view;
+		const glm::mat4 modelToClip = cameraToClip * modelToCamera;
+		for(int axis = 0; axis < 3; axis++)
+		{
+			for(int side = 0; side < 2; side++)
+			{
+				float *pPlane = view.planes[axis * 2 + side];
+				const float sign = side ? -1.0f : 1.0f;
+				for(int column = 0; column < 4; column++)
+					pPlane[column] = modelToClip[column][3] + sign * modelToClip[column][axis];
+			}
+		}
+
+		const glm::vec4 cameraPos = glm::inverse(modelToCamera) * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		view.cameraPos[0] = cameraPos.x;
+		view.cameraPos[1] = cameraPos.y;
+		view.cameraPos[2] = cameraPos.z;
+		view.bFrontFaceCw = frontFace == GL_CW;
+
+		//The clusters are ranges of the one triangle list, one after the other.
+		const RenderCmd &list = m_renderCmds[0];
+		const size_t indexSize = list.indexType == GL_UNSIGNED_BYTE ? 1 :
+			(list.indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+
+		glBindVertexArray(it->second);
+		int numDrawn = 0;
+		GLuint runStart = 0;
+		GLsizei runIndices = 0;
+		for(size_t cluster = 0; cluster <= m_clusters.size(); cluster++)
+		{
+			//One past the last cluster ends the last run.
+			if(cluster < m_clusters.size() && IsClusterVisible(m_clusters[cluster], view))
+			{
+				if(!runIndices)
+					runStart = m_clusters[cluster].firstIndex;
+				runIndices += m_clusters[cluster].numIndices;
+				numDrawn++;
+			}
+			else if(runIndices)
+			{
+				glDrawElements(GL_TRIANGLES, runIndices, list.indexType,
+					(const void *)(list.offset + runStart * indexSize));
+				runIndices = 0;
+			}
+		}
+		glBindVertexArray(0);
+
+		return numDrawn;
+	}
+
+	void PackedMesh::RenderCmds( int lod, GLsizei numInstances ) const
+	{
+		if(lod > 0 && !m_lodCmds.empty())
+		{
+			const LodCmd &curr = m_lodCmds[std::min(lod, (int)m_lodCmds.size()) - 1];
+			glDrawElementsInstanced(GL_TRIANGLES, curr.count, curr.indexType,
+				(const void *)curr.offset, numInstances);
+			return;
+		}
+
+		for(size_t cmd = 0; cmd < m_renderCmds.size(); cmd++)
+		{
+			const RenderCmd &curr = m_renderCmds[cmd];
+			if(!curr.indexType)
+			{
+				glDrawArraysInstanced(curr.primType, curr.start, curr.count, numInstances);
+				continue;
+			}
+
+			if(curr.bPrimRestart)
+			{
+				glEnable(GL_PRIMITIVE_RESTART);
+				glPrimitiveRestartIndex(curr.primRestart);
+			}
+
+			glDrawElementsInstanced(curr.primType, curr.count, curr.indexType,
+				(const void *)curr.offset, numInstances);
+
+			if(curr.bPrimRestart)
+				glDisable(GL_PRIMITIVE_RESTART);
+		}
+	}
+}
@@ -0,0 +1,122 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_PACKED_MESH_H
+#define FRAMEWORK_PACKED_MESH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <glload/gl_3_3.h>
+#include <glm/glm.hpp>
+#include "MeshData.h"
+
+namespace Framework
+{
+	//What goes into PackedMesh's cached copy, besides the mesh. A copy made with other options
+	//is made again.
+	enum PackedMeshOptions
+	{
+		//Stores the attributes in the smaller types QuantizeMesh picks. The positions then
+		//have to go through GetPositionDecodeMatrix.
+		PACKED_MESH_QUANTIZE	= 0x1,
+		//Builds levels of detail with BuildLods (see MeshSimplify.h), for SelectLod.
+		PACKED_MESH_LODS		= 0x2,
+		//Splits the triangles with BuildClusters (see MeshCluster.h), for RenderVisible.
+		PACKED_MESH_CLUSTERS	= 0x4,
+	};
+
+	//Draws a mesh .xml file the way Framework::Mesh does, but loads it through a packed binary
+	//copy (see PackedMeshFormat.h). The first load parses the .xml, reorders its triangles
+	//and vertices for the vertex cache and fetch (see MeshOptimize.h), and writes the copy
+	//next to it (see GetPackedMeshFilename). Later loads read the copy instead, as long as
+	//it is newer than the .xml. The copy is memory-mapped and its vertex and index data go
+	//to glBufferData from the mapping. The copy is only a cache: if it can't be written, the
+	//mesh still loads from the .xml.
+	class PackedMesh
+	{
+	public:
+		//Finds the file the way Framework::Mesh does. options is any of PackedMeshOptions.
+		//Throws std::runtime_error if the mesh can't be loaded.
+		explicit PackedMesh(const std::string &strFilename, unsigned int options = 0);
+		~PackedMesh();
+
+		//Draws every primitive with all of the mesh's attributes, or only with the ones the
+		//named <vao> sources. Unknown names draw nothing.
+		void Render() const;
+		void Render(const std::string &strMeshName) const;
+
+		//Level 0 is the full mesh; 1 and up only draw the mesh's triangles, with fewer of them.
+		//Levels past the last draw the last.
+		void Render(const std::string &strMeshName, int lod) const;
+		int GetNumLods() const {return (int)m_lodCmds.size() + 1;}
+
+		//Draws numInstances copies in one instanced draw per primitive, as Render() does one.
+		//The shader tells the copies apart with gl_InstanceID.
+		void RenderInstanced(GLsizei numInstances) const;
+		void RenderInstanced(const std::string &strMeshName, GLsizei numInstances) const;
+
+		//Picks the coarsest level whose error covers no more than maxPixelError pixels, for
+		//the nearest point of the mesh's bounding sphere. modelToCamera is the model's own
+		//matrix, without GetPositionDecodeMatrix. projectionScale is the viewport's height
+		//in pixels over 2 tan(fovY / 2). Returns 0 for a mesh without levels, or once the
+		//camera is inside the sphere.
+		int SelectLod(const glm::mat4 &modelToCamera, float projectionScale,
+			float maxPixelError = 1.0f) const;
+
+		//Draws with the named <vao>, but only the clusters that IsClusterVisible keeps; each
+		//run of them is one draw. modelToCamera is as for SelectLod, and frontFace is what
+		//glFrontFace is set to. A mesh without clusters is drawn whole. Returns the number of
+		//clusters drawn.
+		int RenderVisible(const std::string &strMeshName, const glm::mat4 &modelToCamera,
+			const glm::mat4 &cameraToClip, GLenum frontFace) const;
+		int GetNumClusters() const {return (int)m_clusters.size();}
+
+		//Takes the positions the mesh stores to model space: apply it after the model matrix.
+		//It scales, so normals must not go through it. The identity unless the mesh was
+		//loaded quantized.
+		const glm::mat4 &GetPositionDecodeMatrix() const {return m_positionDecode;}
+
+		void DeleteObjects();
+
+	private:
+		struct RenderCmd
+		{
+			GLenum primType;
+			GLenum indexType;
+			GLuint start;
+			GLsizei count;
+			size_t offset;
+			bool bPrimRestart;
+			GLuint primRestart;
+		};
+
+		struct LodCmd
+		{
+			GLenum indexType;
+			GLsizei count;
+			size_t offset;
+			float error;
+		};
+
+		GLuint m_vertexBuffer;
+		GLuint m_indexBuffer;
+		GLuint m_vao;
+		std::map<std::string, GLuint> m_namedVaos;
+		std::vector<RenderCmd> m_renderCmds;
+		std::vector<LodCmd> m_lodCmds;
+		std::vector<MeshCluster> m_clusters;
+		glm::mat4 m_positionDecode;
+		glm::vec3 m_boundsCenter;
+		float m_boundsRadius;
+
+		void CreateObjects(const char *pImage, size_t imageSize);
+		void RenderCmds(int lod, GLsizei numInstances) const;
+
+		//Buffer objects can't be copied.
+		PackedMesh(const PackedMesh &);
+		PackedMesh &operator=(const PackedMesh &);
+	};
+}
+
+#endif //FRAMEWORK_PACKED_MESH_H
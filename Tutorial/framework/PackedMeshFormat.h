@@ -0,0 +1,170 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_PACKED_MESH_FORMAT_H
+#define FRAMEWORK_PACKED_MESH_FORMAT_H
+
+#include <stddef.h>
+#include <glload/gl_3_3.h>
+
+namespace Framework
+{
+	//The packed binary form of a mesh .xml file. It is written in the byte order of the
+	//machine that writes it; a file from another kind of machine fails the magic check.
+	//
+	//	PackedMeshHeader
+	//	PackedMeshAttrib[numAttribs]
+	//	PackedMeshPrimitive[numPrimitives]
+	//	PackedMeshVao[numVaos]
+	//	PackedMeshLod[numLods]
+	//	PackedMeshCluster[numClusters]
+	//	the VAO names
+	//	the vertex data: every attribute's values, one block per attribute
+	//	the index data: every indexed primitive's indices, one block per primitive, then
+	//		one block per level of detail
+	//
+	//The vertex data and the index data are each one contiguous range of the file, so each
+	//can be uploaded to its buffer object as is. Attribute and index block offsets are from
+	//the start of their range, which makes them the buffer offsets too. Every block starts on
+	//a multiple of PACKED_MESH_ALIGNMENT.
+	//
+	//A quantized mesh (PACKED_MESH_QUANTIZED) stores its positions as normalized integers
+	//within its bounding box; positionScale and positionOffset turn them back into model
+	//space. See MeshQuantize.h.
+	//
+	//PACKED_MESH_HAS_LODS says the levels of detail were built, even if there are none, and
+	//that boundsCenter and boundsRadius hold the sphere around the positions. See
+	//MeshSimplify.h.
+	//
+	//PACKED_MESH_HAS_CLUSTERS says the clusters were built, even if there are none. They are
+	//ranges of the one primitive, an indexed triangle list. See MeshCluster.h.
+	enum
+	{
+		PACKED_MESH_VERSION = 4,
+		PACKED_MESH_ALIGNMENT = 16,
+	};
+
+	enum PackedMeshFlags
+	{
+		PACKED_MESH_QUANTIZED		= 0x1,
+		PACKED_MESH_HAS_LODS		= 0x2,
+		PACKED_MESH_HAS_CLUSTERS	= 0x4,
+
+		PACKED_ATTRIB_NORMALIZED	= 0x1,
+		PACKED_ATTRIB_INTEGRAL		= 0x2,
+
+		PACKED_PRIM_RESTART			= 0x1,
+	};
+
+	struct PackedMeshHeader
+	{
+		char magic[4];
+		GLuint version;
+		GLuint numAttribs;
+		GLuint numPrimitives;
+		GLuint numVaos;
+		GLuint vertexDataOffset;
+		GLuint vertexDataSize;
+		GLuint indexDataOffset;
+		GLuint indexDataSize;
+		GLuint flags;
+		float positionScale[3];
+		float positionOffset[3];
+		GLuint numLods;
+		float boundsCenter[3];
+		float boundsRadius;
+		GLuint numClusters;
+		GLuint padding[2];
+	};
+
+	struct PackedMeshAttrib
+	{
+		GLuint index;
+		GLenum type;
+		GLuint numComponents;
+		GLuint flags;
+		GLuint dataOffset;
+		GLuint dataSize;
+		GLuint padding[2];
+	};
+
+	//indexType is 0 for an <arrays> primitive, which has no index block.
+	struct PackedMeshPrimitive
+	{
+		GLenum primType;
+		GLenum indexType;
+		GLuint start;
+		GLuint count;
+		GLuint flags;
+		GLuint primRestart;
+		GLuint dataOffset;
+		GLuint dataSize;
+	};
+
+	//Bit n of attribMask is set if the VAO sources attribute index n.
+	struct PackedMeshVao
+	{
+		GLuint nameOffset;
+		GLuint nameLength;
+		GLuint attribMask;
+		GLuint padding;
+	};
+
+	//A level of detail: an indexed triangle list, drawn with the mesh's vertices.
+	struct PackedMeshLod
+	{
+		GLenum indexType;
+		GLuint count;
+		float error;
+		GLuint dataOffset;
+		GLuint dataSize;
+		GLuint padding[3];
+	};
+
+	struct PackedMeshCluster
+	{
+		GLuint firstIndex;
+		GLuint numIndices;
+		float center[3];
+		float radius;
+		float coneAxis[3];
+		float coneCos;
+		GLuint padding[2];
+	};
+
+	//Checks that the bytes are a packed mesh of this version, and that every table and block
+	//it describes lies inside them. Returns the header, or NULL if anything is wrong.
+	const PackedMeshHeader *GetPackedMeshHeader(const char *pImage, size_t imageSize);
+
+	//The tables, which follow each other straight after the header.
+	inline const PackedMeshAttrib *GetPackedAttribs(const PackedMeshHeader *pHeader)
+	{
+		return reinterpret_cast<const PackedMeshAttrib *>(pHeader + 1);
+	}
+
+	inline const PackedMeshPrimitive *GetPackedPrimitives(const PackedMeshHeader *pHeader)
+	{
+		return reinterpret_cast<const PackedMeshPrimitive *>(
+			GetPackedAttribs(pHeader) + pHeader->numAttribs);
+	}
+
+	inline const PackedMeshVao *GetPackedVaos(const PackedMeshHeader *pHeader)
+	{
+		return reinterpret_cast<const PackedMeshVao *>(
+			GetPackedPrimitives(pHeader) + pHeader->numPrimitives);
+	}
+
+	inline const PackedMeshLod *GetPackedLods(const PackedMeshHeader *pHeader)
+	{
+		return reinterpret_cast<const PackedMeshLod *>(
+			GetPackedVaos(pHeader) + pHeader->numVaos);
+	}
+
+	inline const PackedMeshCluster *GetPackedClusters(const PackedMeshHeader *pHeader)
+	{
+		return reinterpret_cast<const PackedMeshCluster *>(
+			GetPackedLods(pHeader) + pHeader->numLods);
+	}
+}
+
+#endif //FRAMEWORK_PACKED_MESH_FORMAT_H
@@ -0,0 +1,111 @@
+//This file is licensed under the MIT License.
+
+
+#include <string.h>
+#include <stdexcept>
+#include "UniformRing.h"
+
+namespace Framework
+{
+	namespace
+	{
+		GLintptr AlignUp(GLintptr value, GLint alignment)
+		{
+			return ((value + alignment - 1) / alignment) * alignment;
+		}
+	}
+
+	UniformRing::UniformRing( GLsizeiptr bytesPerFrame, int blocksPerFrame, int numFrames )
+		: m_buffer(0)
+		, m_sectionSize(0)
+		, m_alignment(1)
+		, m_fences(numFrames, (GLsync)0)
+		, m_currSection(numFrames - 1)
+		, m_currOffset(0)
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_alignment);
+		if(m_alignment < 1)
+			m_alignment = 1;
+
+		//Each block may need padding up to the alignment, and every section has to start on
+		//an aligned offset too.
+		m_sectionSize = AlignUp(bytesPerFrame + (blocksPerFrame * (m_alignment - 1)), m_alignment);
+
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferData(GL_UNIFORM_BUFFER, m_sectionSize * numFrames, NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	UniformRing::~UniformRing()
+	{
+		for(size_t section = 0; section < m_fences.size(); section++)
+		{
+			if(m_fences[section])
+				glDeleteSync(m_fences[section]);
+		}
+
+		glDeleteBuffers(1, &m_buffer);
+	}
+
+	void UniformRing::BeginFrame()
+	{
+		m_currSection = (m_currSection + 1) % (int)m_fences.size();
+		m_currOffset = 0;
+
+		GLsync &fence = m_fences[m_currSection];
+		if(!fence)
+			return;
+
+		//Only flush on the first wait; later ones would flush for nothing.
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		for(;;)
+		{
+			GLenum result = glClientWaitSync(fence, flags, 1000000);
+			if(result != GL_TIMEOUT_EXPIRED)
+				break;
+			flags = 0;
+		}
+
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	void UniformRing::Upload( GLuint bindingIndex, const void *pData, GLsizeiptr size )
+	{
+		GLintptr offset = AlignUp(m_currOffset, m_alignment);
+		if(offset + size > m_sectionSize)
+			throw std::runtime_error("The uniform ring ran out of room for this frame.");
+
+		const GLintptr bufferOffset = (m_currSection * m_sectionSize) + offset;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		void *pDst = glMapBufferRange(GL_UNIFORM_BUFFER, bufferOffset, size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if(pDst)
+		{
+			memcpy(pDst, pData, size);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+		}
+		else
+		{
+			//The map can fail (out of memory, or a driver that refuses the range). The
+			//section is still fenced, so a plain copy into it is just as safe, only slower.
+			glBufferSubData(GL_UNIFORM_BUFFER, bufferOffset, size, pData);
+		}
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, bindingIndex, m_buffer, bufferOffset, size);
+
+		m_currOffset = offset + size;
+	}
+
+	void UniformRing::EndFrame()
+	{
+		GLsync &fence = m_fences[m_currSection];
+		if(fence)
+			glDeleteSync(fence);
+
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
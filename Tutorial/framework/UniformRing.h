@@ -0,0 +1,51 @@
+//This file is licensed under the MIT License.
+
+
+#ifndef FRAMEWORK_UNIFORM_RING_H
+#define FRAMEWORK_UNIFORM_RING_H
+
+#include <vector>
+#include <glload/gl_3_3.h>
+
+namespace Framework
+{
+	//Hands out per-frame blocks of uniform data from one buffer that is split into a section
+	//per frame in flight. Each frame writes into its own section through an unsynchronized
+	//map, so uploading a block is a memcpy rather than a buffer re-specification. A fence is
+	//set at the end of every frame, and a section is not written again until the GPU has
+	//passed the fence of the frame that last used it.
+	//
+	//Blocks only live for the frame they were uploaded in: anything bound from the ring
+	//must be uploaded again each frame.
+	class UniformRing
+	{
+	public:
+		//A frame may upload up to blocksPerFrame blocks, totalling at most bytesPerFrame.
+		UniformRing(GLsizeiptr bytesPerFrame, int blocksPerFrame, int numFrames = 3);
+		~UniformRing();
+
+		//Waits, if needed, until the next section is free, then writes start there.
+		void BeginFrame();
+
+		//Copies the data into the current section and binds it to the uniform buffer
+		//binding point. Throws if the section does not have room left.
+		void Upload(GLuint bindingIndex, const void *pData, GLsizeiptr size);
+
+		//Fences the commands that read the current section.
+		void EndFrame();
+
+	private:
+		GLuint m_buffer;
+		GLsizeiptr m_sectionSize;
+		GLint m_alignment;
+
+		std::vector<GLsync> m_fences;
+		int m_currSection;
+		GLintptr m_currOffset;
+
+		UniformRing(const UniformRing &);
+		UniformRing &operator=(const UniformRing &);
+	};
+}
+
+#endif //FRAMEWORK_UNIFORM_RING_H